@@ -0,0 +1,62 @@
+#ifndef H_ATTACKS
+#define H_ATTACKS
+
+#include "bitboard.h"
+
+//Sliding attacks come from precomputed tables indexed by the blockers on the slider's rays.
+//The index is found with a magic multiply and shift, or with a single PEXT instruction
+//when compiled for a cpu with BMI2 (define CHESS_USE_PEXT, or build with -mbmi2 on gcc/clang).
+#if defined(CHESS_USE_PEXT) || defined(__BMI2__)
+#define ATTACKS_USE_PEXT 1
+#include <immintrin.h>
+#endif
+
+#define ROOK_ATTACK_TABLE_SIZE 102400
+#define BISHOP_ATTACK_TABLE_SIZE 5248
+
+typedef struct SliderMagic{
+    Bitboard* attacks; //Start of this square's slice of the shared attack table
+    Bitboard mask;     //Squares whose occupancy matters, board edges excluded
+    Bitboard magic;
+    unsigned int shift;
+} SliderMagic;
+
+extern SliderMagic rookMagics[64];
+extern SliderMagic bishopMagics[64];
+
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+extern Bitboard pawnAttacks[2][64]; //Squares a pawn of the given CHESS_SIDE attacks from each square
+
+extern Bitboard betweenMasks[64][64]; //Squares strictly between two squares on a shared row, column or diagonal
+extern Bitboard lineMasks[64][64];    //Whole row, column or diagonal through two aligned squares, empty otherwise
+
+//Must be called once before any lookups
+void Attacks_Init();
+
+static inline unsigned int SliderMagic_Index(const SliderMagic* magic, Bitboard occupied){
+#if defined(ATTACKS_USE_PEXT)
+    return (unsigned int)_pext_u64(occupied, magic->mask);
+#else
+    return (unsigned int)(((occupied & magic->mask) * magic->magic) >> magic->shift);
+#endif
+}
+
+static inline Bitboard Attacks_Rook(int index, Bitboard occupied){
+    const SliderMagic* magic = &rookMagics[index];
+    return magic->attacks[SliderMagic_Index(magic, occupied)];
+}
+
+static inline Bitboard Attacks_Bishop(int index, Bitboard occupied){
+    const SliderMagic* magic = &bishopMagics[index];
+    return magic->attacks[SliderMagic_Index(magic, occupied)];
+}
+
+static inline Bitboard Attacks_Queen(int index, Bitboard occupied){
+    return Attacks_Rook(index, occupied) | Attacks_Bishop(index, occupied);
+}
+
+//Reference ray walk used to build the tables
+Bitboard Attacks_SlidingSlow(int index, Bitboard occupied, int bishop);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+//Game archive write and read throughput.
+//
+//  archive_benchmark <path> [games]  appends games of random legal moves to the archive at path, then reads it back
+//  archive_benchmark scan <path>     only reads the archive at path, one a server wrote for example
+//
+//games defaults to 1000000. Reading maps the archive and times a pass over every move of every game, replaying every
+//game on a Position with each move checked, and looking games up by random id. The run exits with 1 if a game can't
+//be read or holds an illegal move. Right after writing the archive is still in the os file cache, so the pass over the
+//moves shows memory bandwidth rather than the disk's.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../position.h"
+#include "../movegen.h"
+#include "../attacks.h"
+#include "../zobrist.h"
+#include "../fen.h"
+#include "../game_archive.h"
+#include "../platform.h"
+
+#define ARCHIVE_DEFAULT_GAMES 1000000
+#define ARCHIVE_DISTINCT_GAMES 1024 //Written over and over, playing out a million games would time the move generator
+#define ARCHIVE_MAX_PLIES 200
+#define ARCHIVE_LOOKUPS 1000000
+
+typedef struct SampleGame{
+    unsigned char moves[ARCHIVE_MAX_PLIES*2];
+    int moveCount;
+    enum GAME_RESULT result;
+    enum GAME_END_REASON reason;
+} SampleGame;
+
+//Random legal moves until the game ends or runs ARCHIVE_MAX_PLIES long
+static void PlayRandomGame(SampleGame* game){
+
+    Position position;
+    Position_LoadFen(&position, FEN_START_POSITION);
+    game->moveCount = 0;
+    game->result = GAME_RESULT_UNFINISHED;
+    game->reason = GAME_END_DISCONNECT;
+
+    while(game->moveCount < ARCHIVE_MAX_PLIES && !GameResult_FromPosition(&position, &game->result, &game->reason)){
+        MoveList moveList;
+        Position_GenerateLegalMoves(&position, &moveList);
+        Move move = moveList.moves[rand() % moveList.length];
+        Move_Encode(move, game->moves + game->moveCount*2);
+        game->moveCount++;
+        PositionUndo undo;
+        Position_MakeMove(&position, move, &undo);
+    }
+
+}
+
+static int WriteGames(const char* path, uint64_t gameCount){
+
+    SampleGame* samples = (SampleGame*)malloc(sizeof(SampleGame) * ARCHIVE_DISTINCT_GAMES);
+    if(samples == NULL){
+        printf("Out of memory\n");
+        return 0;
+    }
+    srand(1);
+    for(int i = 0; i < ARCHIVE_DISTINCT_GAMES; i++){
+        PlayRandomGame(&samples[i]);
+    }
+
+    GameArchiveWriter writer;
+    if(!GameArchiveWriter_Open(&writer, path)){
+        printf("Could not open %s for writing\n", path);
+        free(samples);
+        return 0;
+    }
+    uint64_t startSize = writer.dataSize;
+
+    uint64_t start = Platform_TimeNanoseconds();
+    for(uint64_t i = 0; i < gameCount; i++){
+        const SampleGame* game = &samples[i % ARCHIVE_DISTINCT_GAMES];
+        if(GameArchiveWriter_Append(&writer, NULL, game->moves, game->moveCount, game->result, game->reason) < 0){
+            printf("Could not write game %llu\n", (unsigned long long)i);
+            GameArchiveWriter_Close(&writer);
+            free(samples);
+            return 0;
+        }
+    }
+    uint64_t bytes = writer.dataSize - startSize + gameCount*GAME_ARCHIVE_INDEX_ENTRY_SIZE;
+    GameArchiveWriter_Close(&writer);
+    uint64_t elapsed = Platform_TimeNanoseconds() - start;
+
+    printf("Write:  %llu games, %.1f bytes per game with its index entry\n", (unsigned long long)gameCount, (double)bytes / gameCount);
+    printf("        %.0f games per second, %.0f MB/s\n", elapsed ? gameCount / (elapsed / 1e9) : 0.0, elapsed ? bytes / (elapsed / 1e3) : 0.0);
+    free(samples);
+    return 1;
+
+}
+
+static int ReadGames(const char* path){
+
+    uint64_t start = Platform_TimeNanoseconds();
+    GameArchive archive;
+    if(!GameArchive_Open(&archive, path)){
+        printf("Could not open the archive %s\n", path);
+        return 1;
+    }
+    uint64_t openTime = Platform_TimeNanoseconds() - start;
+    printf("Open:   %llu games, %.1f MB mapped in %.3f ms\n", (unsigned long long)archive.count,
+        (archive.dataSize + archive.indexSize) / 1e6, openTime / 1e6);
+    if(archive.count == 0){
+        GameArchive_Close(&archive);
+        return 0;
+    }
+
+    //Every move of every game, in id order so the records are read front to back
+    int failures = 0;
+    uint64_t moves = 0;
+    uint64_t checksum = 0;
+    start = Platform_TimeNanoseconds();
+    for(uint64_t id = 0; id < archive.count; id++){
+        ArchivedGame game;
+        if(!GameArchive_Game(&archive, id, &game)){
+            failures++;
+            continue;
+        }
+        for(int ply = 0; ply < game.moveCount; ply++){
+            checksum += ArchivedGame_Move(&game, ply);
+        }
+        moves += game.moveCount;
+    }
+    uint64_t scanTime = Platform_TimeNanoseconds() - start;
+    uint64_t bytes = archive.dataSize + archive.indexSize;
+    printf("Scan:   %.0f games per second, %.0f MB/s, %llu moves (checksum %llu)\n", scanTime ? archive.count / (scanTime / 1e9) : 0.0,
+        scanTime ? bytes / (scanTime / 1e3) : 0.0, (unsigned long long)moves, (unsigned long long)checksum);
+
+    start = Platform_TimeNanoseconds();
+    for(uint64_t id = 0; id < archive.count; id++){
+        ArchivedGame game;
+        Position position;
+        if(!GameArchive_Game(&archive, id, &game) || !ArchivedGame_StartPosition(&game, &position)){
+            continue;
+        }
+        for(int ply = 0; ply < game.moveCount; ply++){
+            Move move = ArchivedGame_Move(&game, ply);
+            if(!Position_IsLegalMove(&position, move)){
+                if(failures < 10) printf("Game %llu has an illegal move at ply %d\n", (unsigned long long)id, ply);
+                failures++;
+                break;
+            }
+            PositionUndo undo;
+            Position_MakeMove(&position, move, &undo);
+        }
+    }
+    uint64_t replayTime = Platform_TimeNanoseconds() - start;
+    printf("Replay: %.0f games per second, %.0f moves per second\n", replayTime ? archive.count / (replayTime / 1e9) : 0.0,
+        replayTime ? moves / (replayTime / 1e9) : 0.0);
+
+    srand(2);
+    checksum = 0;
+    start = Platform_TimeNanoseconds();
+    for(int i = 0; i < ARCHIVE_LOOKUPS; i++){
+        uint64_t id = (((uint64_t)rand() << 31) ^ (uint64_t)rand()) % archive.count;
+        ArchivedGame game;
+        if(GameArchive_Game(&archive, id, &game) && game.moveCount > 0){
+            checksum += ArchivedGame_Move(&game, game.moveCount - 1);
+        }
+    }
+    uint64_t lookupTime = Platform_TimeNanoseconds() - start;
+    printf("Lookup: %.0f random games per second (checksum %llu)\n", lookupTime ? ARCHIVE_LOOKUPS / (lookupTime / 1e9) : 0.0,
+        (unsigned long long)checksum);
+
+    GameArchive_Close(&archive);
+    printf("%s\n", failures ? "FAILED" : "Every game read back and replayed");
+    return failures ? 1 : 0;
+
+}
+
+int main(int argc, char** argv){
+
+    Attacks_Init();
+    Zobrist_Init();
+
+    if(argc >= 3 && strcmp(argv[1], "scan") == 0){
+        return ReadGames(argv[2]);
+    }
+
+    long long gameCount = argc >= 3 ? atoll(argv[2]) : ARCHIVE_DEFAULT_GAMES;
+    if(argc < 2 || gameCount < 1){
+        printf("Usage: %s <path> [games]\n", argv[0]);
+        printf("       %s scan <path>\n", argv[0]);
+        return 1;
+    }
+    if(!WriteGames(argv[1], (uint64_t)gameCount)) return 1;
+    return ReadGames(argv[1]);
+
+}
\ No newline at end of file
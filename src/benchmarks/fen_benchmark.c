@@ -0,0 +1,255 @@
+//FEN parsing and writing throughput.
+//
+//  fen_benchmark [depth]      every position in the perft reference trees to depth, written out and parsed back
+//  fen_benchmark file <path>  parses every line of a fen or epd file, like a test suite
+//  fen_benchmark validate     checks that fens of positions the move generator can't work on are rejected
+//
+//depth defaults to 3. Every position is checked to come back the same after a round trip, the run exits with 1
+//if one doesn't, a line of the file can't be parsed or a fen is accepted or rejected when it shouldn't be.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../position.h"
+#include "../movegen.h"
+#include "../attacks.h"
+#include "../zobrist.h"
+#include "../fen.h"
+#include "../platform.h"
+
+#define FEN_DEFAULT_DEPTH 3
+#define FEN_MAX_POSITIONS 1000000
+#define FEN_TIMING_ROUNDS 5
+
+static const char* fenSources[] = {
+    FEN_START_POSITION,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+};
+
+//Positions Position_LoadFen has to turn down, each of them once got through and broke the generator
+static const char* invalidFens[] = {
+    "4k3/8/8/8/8/8/4Q3/4K3 w - - 0 1",        //Black to move is in check, white could capture the king
+    "P3k3/8/8/8/8/8/8/4K3 w - - 0 1",         //Pawn on the eighth rank
+    "4k3/8/8/8/8/8/8/p3K3 b - - 0 1",         //Pawn on the first rank
+    "4k3/8/8/8/8/8/2P5/4K3 w - d3 0 1",       //En passant on the third rank with white to move
+    "4k3/8/8/3p4/8/8/8/4K3 b - d6 0 1",       //En passant on the sixth rank with black to move
+    "4k3/8/8/4P3/8/8/8/4K3 w - d6 0 1",       //No black pawn in front of the square
+    "4k3/3n4/8/3pP3/8/8/8/4K3 w - d6 0 1",    //The square the pawn came from isn't empty
+    "4k3/8/3n4/3pP3/8/8/8/4K3 w - d6 0 1",    //The en passant square isn't empty
+    "8/8/8/8/8/8/8/4K3 w - - 0 1",            //No black king
+    "4k3/8/8/8/8/8/8/3KK3 w - - 0 1",         //Two white kings
+    "4k3/8/8/8/8/8/8/4K3 x - - 0 1",          //No side to move
+    "4k3/8/8/8/8/8/8/4K3 w - e9 0 1"          //En passant square off the board
+};
+
+//Edge cases that have to load, with the en passant square kept or dropped as Position keeps it
+static const struct{ const char* fen; int enPassantSquare; } validFens[] = {
+    { "4k3/8/8/8/8/8/8/4K3 b - - 0 1 extra", NO_SQUARE },
+    { "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", 19 },
+    { "4k3/8/8/3p4/8/8/8/4K3 w - d6 0 1", NO_SQUARE },   //Nothing can capture there
+    { "4k3/8/8/8/3Pp3/8/8/4K3 b - d3 0 1", 43 },
+    { "4k3/8/8/8/8/8/8/4K2R w Kkq - 0 1", NO_SQUARE },   //Rights without king and rook at home are dropped
+    { "4k3/8/8/8/8/8/4q3/4K3 w - - 0 1", NO_SQUARE }     //The side to move may be in check
+};
+
+typedef struct FenCollection{
+    Position* positions;
+    int count;
+} FenCollection;
+
+static void Collect(FenCollection* collection, Position* position, int depth){
+
+    if(collection->count == FEN_MAX_POSITIONS) return;
+    collection->positions[collection->count++] = *position;
+    if(depth == 0) return;
+
+    MoveList moveList;
+    Position_GenerateLegalMoves(position, &moveList);
+    for(int i = 0; i < moveList.length; i++){
+        PositionUndo undo;
+        Position_MakeMove(position, moveList.moves[i], &undo);
+        Collect(collection, position, depth - 1);
+        Position_UnmakeMove(position, &undo);
+    }
+
+}
+
+static int SamePosition(const Position* a, const Position* b){
+    return memcmp(a->squares, b->squares, sizeof(a->squares)) == 0 && a->sideToMove == b->sideToMove
+        && a->castlingRights == b->castlingRights && a->enPassantSquare == b->enPassantSquare
+        && a->halfmoveClock == b->halfmoveClock && a->fullmoveNumber == b->fullmoveNumber
+        && a->sides[WHITE] == b->sides[WHITE] && a->hash == b->hash;
+}
+
+int RunTrees(int depth){
+
+    FenCollection collection;
+    collection.positions = (Position*)malloc(sizeof(Position) * FEN_MAX_POSITIONS);
+    char* fens = (char*)malloc((size_t)FEN_MAX_LENGTH * FEN_MAX_POSITIONS);
+    if(collection.positions == NULL || fens == NULL){
+        printf("Out of memory\n");
+        return 1;
+    }
+    collection.count = 0;
+
+    int sourceCount = (int)(sizeof(fenSources) / sizeof(fenSources[0]));
+    for(int i = 0; i < sourceCount; i++){
+        Position position;
+        Position_LoadFen(&position, fenSources[i]);
+        Collect(&collection, &position, depth);
+    }
+
+    //Writing, the fens are kept in fixed size slots for the parsing pass
+    uint64_t bytes = 0;
+    uint64_t start = Platform_TimeNanoseconds();
+    for(int round = 0; round < FEN_TIMING_ROUNDS; round++){
+        for(int i = 0; i < collection.count; i++){
+            bytes += Position_ToFen(&collection.positions[i], fens + (size_t)i * FEN_MAX_LENGTH);
+        }
+    }
+    uint64_t writeTime = Platform_TimeNanoseconds() - start;
+
+    int failures = 0;
+    start = Platform_TimeNanoseconds();
+    for(int round = 0; round < FEN_TIMING_ROUNDS; round++){
+        for(int i = 0; i < collection.count; i++){
+            Position position;
+            if(!Position_LoadFen(&position, fens + (size_t)i * FEN_MAX_LENGTH)) failures++;
+        }
+    }
+    uint64_t parseTime = Platform_TimeNanoseconds() - start;
+
+    //Checked outside the timed loops
+    for(int i = 0; i < collection.count; i++){
+        Position position;
+        const char* fen = fens + (size_t)i * FEN_MAX_LENGTH;
+        if(!Position_LoadFen(&position, fen) || !SamePosition(&position, &collection.positions[i])){
+            if(failures < 10) printf("Round trip failed: %s\n", fen);
+            failures++;
+        }
+    }
+
+    uint64_t total = (uint64_t)collection.count * FEN_TIMING_ROUNDS;
+    printf("Positions: %d (depth %d), %.1f bytes per fen\n", collection.count, depth, (double)bytes / total);
+    printf("Write:     %.0f fens per second\n", writeTime ? total / (writeTime / 1e9) : 0.0);
+    printf("Parse:     %.0f fens per second\n", parseTime ? total / (parseTime / 1e9) : 0.0);
+    printf("%s\n", failures ? "FAILED" : "Every position came back the same");
+
+    free(collection.positions);
+    free(fens);
+    return failures ? 1 : 0;
+
+}
+
+int RunValidate(){
+
+    int accepted = 0;
+    int invalidCount = (int)(sizeof(invalidFens) / sizeof(invalidFens[0]));
+    for(int i = 0; i < invalidCount; i++){
+        Position position;
+        if(Position_LoadFen(&position, invalidFens[i])){
+            printf("Accepted: %s\n", invalidFens[i]);
+            accepted++;
+        }
+    }
+
+    int rejected = 0;
+    int validCount = (int)(sizeof(validFens) / sizeof(validFens[0]));
+    for(int i = 0; i < validCount; i++){
+        Position position;
+        if(!Position_LoadFen(&position, validFens[i].fen) || !Position_IsValid(&position)
+            || position.enPassantSquare != validFens[i].enPassantSquare || position.hash != Position_ComputeHash(&position)){
+            printf("Rejected or loaded wrong: %s\n", validFens[i].fen);
+            rejected++;
+        }
+    }
+
+    printf("%d of %d invalid fens rejected, %d of %d edge cases loaded\n", invalidCount - accepted, invalidCount,
+        validCount - rejected, validCount);
+    printf("%s\n", accepted || rejected ? "FAILED" : "Every fen was handled right");
+    return accepted || rejected ? 1 : 0;
+
+}
+
+//The whole file is read in first so only the parsing is timed
+int RunFile(const char* path){
+
+    FILE* file = fopen(path, "rb");
+    if(file == NULL){
+        printf("Could not open %s\n", path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = (char*)malloc(size + 1);
+    if(text == NULL || fread(text, 1, size, file) != (size_t)size){
+        printf("Could not read %s\n", path);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    //Lines become strings in place
+    text[size] = '\0';
+    for(long i = 0; i < size; i++){
+        if(text[i] == '\n' || text[i] == '\r') text[i] = '\0';
+    }
+
+    uint64_t lines = 0;
+    uint64_t failures = 0;
+    uint64_t start = Platform_TimeNanoseconds();
+    for(long i = 0; i < size; i++){
+        if(text[i] == '\0' || (i > 0 && text[i-1] != '\0')) continue;
+        Position position;
+        lines++;
+        failures += !Position_LoadFen(&position, text + i);
+    }
+    uint64_t parseTime = Platform_TimeNanoseconds() - start;
+
+    if(failures > 0){
+        int shown = 0;
+        for(long i = 0; i < size && shown < 10; i++){
+            Position position;
+            if(text[i] == '\0' || (i > 0 && text[i-1] != '\0')) continue;
+            if(!Position_LoadFen(&position, text + i)){
+                printf("Could not parse: %s\n", text + i);
+                shown++;
+            }
+        }
+    }
+    free(text);
+
+    printf("Lines:  %llu, %llu could not be parsed\n", (unsigned long long)lines, (unsigned long long)failures);
+    printf("Parse:  %.0f fens per second\n", parseTime ? lines / (parseTime / 1e9) : 0.0);
+    return failures ? 1 : 0;
+
+}
+
+int main(int argc, char** argv){
+
+    Attacks_Init();
+    Zobrist_Init();
+
+    if(argc >= 3 && strcmp(argv[1], "file") == 0){
+        return RunFile(argv[2]);
+    }
+    if(argc >= 2 && strcmp(argv[1], "validate") == 0){
+        return RunValidate();
+    }
+
+    int depth = argc >= 2 ? atoi(argv[1]) : FEN_DEFAULT_DEPTH;
+    if(depth < 0){
+        printf("Usage: %s [depth]\n", argv[0]);
+        printf("       %s file <path>\n", argv[0]);
+        printf("       %s validate\n", argv[0]);
+        return 1;
+    }
+    return RunTrees(depth);
+
+}
\ No newline at end of file
@@ -0,0 +1,360 @@
+//Perft, the move generator's correctness gate and throughput benchmark.
+//
+//  perft_benchmark <depth> [fen] [threads]            per root move divide, total nodes and nodes per second
+//  perft_benchmark suite [maxDepth] [threads]         runs the reference positions below and checks every count
+//  perft_benchmark scaling <depth> [maxThreads] [fen] same tree on 1 to maxThreads threads, nodes per second and speedup
+//  perft_benchmark validate [depth]                   checks Position_IsLegalMove against the generator and times both
+//
+//Without a fen the starting position is used, threads defaults to 1 and maxThreads to the number of cores.
+//The suite, scaling and validate runs exit with 1 if any count or answer is wrong.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../position.h"
+#include "../movegen.h"
+#include "../attacks.h"
+#include "../zobrist.h"
+#include "../fen.h"
+#include "../perft.h"
+#include "../platform.h"
+
+#define SUITE_MAX_DEPTH 7
+#define SUITE_DEFAULT_DEPTH 5
+#define VALIDATE_DEFAULT_DEPTH 3
+#define VALIDATE_MAX_SAMPLES 20000
+#define VALIDATE_TIMING_ROUNDS 20
+
+typedef struct PerftReference{
+    const char* name;
+    const char* fen;
+    uint64_t nodes[SUITE_MAX_DEPTH]; //nodes[0] is depth 1, 0 where no count is listed
+} PerftReference;
+
+//The usual reference positions, they cover castling, en passant, promotions and discovered checks between them
+static const PerftReference perftSuite[] = {
+    { "start", FEN_START_POSITION,
+        { 20, 400, 8902, 197281, 4865609, 119060324, 3195901860ULL } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        { 48, 2039, 97862, 4085603, 193690690, 8031647685ULL, 0 } },
+    { "endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        { 14, 191, 2812, 43238, 674624, 11030083, 178633661 } },
+    { "promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        { 6, 264, 9467, 422333, 15833292, 706045033, 0 } },
+    { "promotions mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+        { 6, 264, 9467, 422333, 15833292, 706045033, 0 } },
+    { "talkchess", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        { 44, 1486, 62379, 2103487, 89941194, 0, 0 } },
+    { "middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        { 46, 2079, 89890, 3894594, 164075551, 6923051137ULL, 0 } }
+};
+
+uint64_t CountNodes(const Position* position, int depth, int threadCount){
+
+    MoveList rootMoves;
+    uint64_t moveNodes[MAX_LEGAL_MOVES];
+    return Perft_DivideParallel(position, depth, threadCount, &rootMoves, moveNodes);
+
+}
+
+int RunDivide(const char* fen, int depth, int threadCount){
+
+    Position position;
+    if(!Position_LoadFen(&position, fen)){
+        printf("Could not parse fen: %s\n", fen);
+        return 1;
+    }
+
+    MoveList rootMoves;
+    uint64_t moveNodes[MAX_LEGAL_MOVES];
+
+    uint64_t start = Platform_TimeNanoseconds();
+    uint64_t nodes = Perft_DivideParallel(&position, depth, threadCount, &rootMoves, moveNodes);
+    uint64_t elapsed = Platform_TimeNanoseconds() - start;
+
+    char moveString[6];
+    for(int i = 0; i < rootMoves.length; i++){
+        Move_ToString(rootMoves.moves[i], moveString);
+        printf("%s: %llu\n", moveString, (unsigned long long)moveNodes[i]);
+    }
+
+    double seconds = elapsed / 1e9;
+    printf("\nMoves: %d\n", rootMoves.length);
+    printf("Nodes: %llu\n", (unsigned long long)nodes);
+    printf("Time:  %.3f s\n", seconds);
+    printf("NPS:   %.0f\n", seconds > 0 ? nodes / seconds : 0.0);
+
+    return 0;
+
+}
+
+int RunSuite(int maxDepth, int threadCount){
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    uint64_t totalTime = 0;
+
+    int suiteSize = (int)(sizeof(perftSuite) / sizeof(perftSuite[0]));
+    for(int i = 0; i < suiteSize; i++){
+
+        const PerftReference* reference = &perftSuite[i];
+        Position position;
+        if(!Position_LoadFen(&position, reference->fen)){
+            printf("%-20s could not parse fen\n", reference->name);
+            failures++;
+            continue;
+        }
+
+        for(int depth = 1; depth <= maxDepth; depth++){
+
+            uint64_t expected = reference->nodes[depth-1];
+            if(expected == 0) break;
+
+            uint64_t start = Platform_TimeNanoseconds();
+            uint64_t nodes = CountNodes(&position, depth, threadCount);
+            uint64_t elapsed = Platform_TimeNanoseconds() - start;
+
+            totalNodes += nodes;
+            totalTime += elapsed;
+
+            int passed = nodes == expected;
+            if(!passed) failures++;
+
+            printf("%-20s depth %d  %12llu  %s", reference->name, depth, (unsigned long long)nodes, passed ? "ok  " : "FAIL");
+            if(!passed) printf(" (expected %llu)", (unsigned long long)expected);
+            printf("  %.3f s\n", elapsed / 1e9);
+
+        }
+
+    }
+
+    double seconds = totalTime / 1e9;
+    printf("\nTotal nodes: %llu\n", (unsigned long long)totalNodes);
+    printf("Total time:  %.3f s\n", seconds);
+    printf("NPS:         %.0f\n", seconds > 0 ? totalNodes / seconds : 0.0);
+    printf("%s\n", failures ? "FAILED" : "All counts match");
+
+    return failures ? 1 : 0;
+
+}
+
+//Runs the same perft on 1, 2, 4... threads up to maxThreads, every run must agree with the single threaded count
+int RunScaling(const char* fen, int depth, int maxThreads){
+
+    Position position;
+    if(!Position_LoadFen(&position, fen)){
+        printf("Could not parse fen: %s\n", fen);
+        return 1;
+    }
+
+    printf("Threads        Nodes     Time           NPS  Speedup\n");
+
+    uint64_t baseNodes = 0;
+    uint64_t baseTime = 0;
+    int failures = 0;
+    for(int threads = 1; threads <= maxThreads; threads = (threads*2 > maxThreads && threads != maxThreads) ? maxThreads : threads*2){
+
+        uint64_t start = Platform_TimeNanoseconds();
+        uint64_t nodes = CountNodes(&position, depth, threads);
+        uint64_t elapsed = Platform_TimeNanoseconds() - start;
+
+        if(threads == 1){
+            baseNodes = nodes;
+            baseTime = elapsed;
+        }
+        int passed = nodes == baseNodes;
+        if(!passed) failures++;
+
+        double seconds = elapsed / 1e9;
+        printf("%7d %12llu %7.3f s %13.0f  %6.2fx%s\n", threads, (unsigned long long)nodes, seconds,
+            seconds > 0 ? nodes / seconds : 0.0, elapsed ? (double)baseTime / elapsed : 0.0, passed ? "" : "  COUNT MISMATCH");
+
+    }
+
+    return failures ? 1 : 0;
+
+}
+
+typedef struct ValidationRun{
+    unsigned char generated[65536/8]; //Bit per Move code, set for the moves of the node being checked
+    uint64_t checked;
+    uint64_t wrong;
+    Position* samples;                //Positions kept for timing
+    int sampleCount;
+} ValidationRun;
+
+static int CheckMove(ValidationRun* run, const Position* position, Move move){
+
+    int expected = (run->generated[move >> 3] >> (move & 7)) & 1;
+    run->checked++;
+    if(Position_IsLegalMove(position, move) == expected) return 1;
+
+    char moveString[6];
+    Move_ToString(move, moveString);
+    if(run->wrong < 10) printf("  %s flags %d: said %s\n", moveString, MOVE_FLAGS(move), expected ? "illegal" : "legal");
+    run->wrong++;
+    return 0;
+
+}
+
+//Every node checks each from/to pair as Position_MoveFromCoordinates flags it, and every generated move under all 16 flags
+static void ValidateTree(ValidationRun* run, Position* position, int depth){
+
+    MoveList moveList;
+    Position_GenerateLegalMoves(position, &moveList);
+    for(int i = 0; i < moveList.length; i++){
+        run->generated[moveList.moves[i] >> 3] |= (unsigned char)(1 << (moveList.moves[i] & 7));
+    }
+
+    for(int from = 0; from < 64; from++){
+        for(int to = 0; to < 64; to++){
+            CheckMove(run, position, Position_MoveFromCoordinates(position, from, to, QUEEN));
+            CheckMove(run, position, Position_MoveFromCoordinates(position, from, to, KNIGHT));
+        }
+    }
+    for(int i = 0; i < moveList.length; i++){
+        for(int flags = 0; flags < 16; flags++){
+            CheckMove(run, position, MOVE_CREATE(MOVE_FROM(moveList.moves[i]), MOVE_TO(moveList.moves[i]), flags));
+        }
+    }
+
+    for(int i = 0; i < moveList.length; i++){
+        run->generated[moveList.moves[i] >> 3] = 0;
+    }
+    if(run->sampleCount < VALIDATE_MAX_SAMPLES){
+        run->samples[run->sampleCount++] = *position;
+    }
+
+    if(depth <= 1) return;
+    for(int i = 0; i < moveList.length; i++){
+        PositionUndo undo;
+        Position_MakeMove(position, moveList.moves[i], &undo);
+        ValidateTree(run, position, depth - 1);
+        Position_UnmakeMove(position, &undo);
+    }
+
+}
+
+//How fast a received legal move is accepted either way: the single move check, or generating the list and looking for it
+static void TimeValidation(const ValidationRun* run){
+
+    MoveList* sampleMoves = (MoveList*)malloc(sizeof(MoveList) * run->sampleCount);
+    if(sampleMoves == NULL) return;
+    for(int i = 0; i < run->sampleCount; i++){
+        Position_GenerateLegalMoves(&run->samples[i], &sampleMoves[i]);
+    }
+
+    uint64_t validations = 0;
+    uint64_t accepted = 0;
+    uint64_t start = Platform_TimeNanoseconds();
+    for(int round = 0; round < VALIDATE_TIMING_ROUNDS; round++){
+        for(int i = 0; i < run->sampleCount; i++){
+            for(int m = 0; m < sampleMoves[i].length; m++){
+                accepted += Position_IsLegalMove(&run->samples[i], sampleMoves[i].moves[m]);
+            }
+            validations += sampleMoves[i].length;
+        }
+    }
+    uint64_t singleTime = Platform_TimeNanoseconds() - start;
+
+    uint64_t listAccepted = 0;
+    start = Platform_TimeNanoseconds();
+    for(int round = 0; round < VALIDATE_TIMING_ROUNDS; round++){
+        for(int i = 0; i < run->sampleCount; i++){
+            for(int m = 0; m < sampleMoves[i].length; m++){
+                MoveList moveList;
+                Position_GenerateLegalMoves(&run->samples[i], &moveList);
+                for(int j = 0; j < moveList.length; j++){
+                    if(moveList.moves[j] == sampleMoves[i].moves[m]){
+                        listAccepted++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    uint64_t listTime = Platform_TimeNanoseconds() - start;
+
+    printf("\nValidations:     %llu legal moves over %d positions\n", (unsigned long long)validations, run->sampleCount);
+    printf("Single move:     %.0f per second\n", singleTime ? validations / (singleTime / 1e9) : 0.0);
+    printf("Generate + find: %.0f per second\n", listTime ? validations / (listTime / 1e9) : 0.0);
+    if(accepted != validations || listAccepted != validations) printf("Rejected legal moves\n");
+
+    free(sampleMoves);
+
+}
+
+int RunValidation(int depth){
+
+    ValidationRun* run = (ValidationRun*)calloc(1, sizeof(ValidationRun));
+    if(run == NULL || (run->samples = (Position*)malloc(sizeof(Position) * VALIDATE_MAX_SAMPLES)) == NULL){
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    int suiteSize = (int)(sizeof(perftSuite) / sizeof(perftSuite[0]));
+    for(int i = 0; i < suiteSize; i++){
+        Position position;
+        if(!Position_LoadFen(&position, perftSuite[i].fen)) continue;
+        uint64_t wrongBefore = run->wrong;
+        uint64_t checkedBefore = run->checked;
+        ValidateTree(run, &position, depth);
+        printf("%-20s depth %d  %12llu moves checked  %s\n", perftSuite[i].name, depth,
+            (unsigned long long)(run->checked - checkedBefore), run->wrong == wrongBefore ? "ok" : "FAIL");
+    }
+
+    int failed = run->wrong != 0;
+    printf("%s\n", failed ? "FAILED" : "All answers match the generator");
+    TimeValidation(run);
+
+    free(run->samples);
+    free(run);
+    return failed;
+
+}
+
+int main(int argc, char** argv){
+
+    Attacks_Init();
+    Zobrist_Init();
+
+    if(argc >= 2 && strcmp(argv[1], "suite") == 0){
+        int maxDepth = SUITE_DEFAULT_DEPTH;
+        int threads = 1;
+        if(argc >= 3) maxDepth = atoi(argv[2]);
+        if(argc >= 4) threads = atoi(argv[3]);
+        if(maxDepth < 1 || maxDepth > SUITE_MAX_DEPTH){
+            printf("Suite depth must be between 1 and %d\n", SUITE_MAX_DEPTH);
+            return 1;
+        }
+        return RunSuite(maxDepth, threads);
+    }
+
+    if(argc >= 3 && strcmp(argv[1], "scaling") == 0){
+        int maxThreads = Platform_ProcessorCount();
+        if(argc >= 4) maxThreads = atoi(argv[3]);
+        if(maxThreads < 1) maxThreads = 1;
+        return RunScaling(argc >= 5 ? argv[4] : FEN_START_POSITION, atoi(argv[2]), maxThreads);
+    }
+
+    if(argc >= 2 && strcmp(argv[1], "validate") == 0){
+        int depth = argc >= 3 ? atoi(argv[2]) : VALIDATE_DEFAULT_DEPTH;
+        if(depth < 1){
+            printf("Validate depth must be at least 1\n");
+            return 1;
+        }
+        return RunValidation(depth);
+    }
+
+    if(argc < 2 || atoi(argv[1]) < 1){
+        printf("Usage: %s <depth> [fen] [threads]\n", argv[0]);
+        printf("       %s suite [maxDepth] [threads]\n", argv[0]);
+        printf("       %s scaling <depth> [maxThreads] [fen]\n", argv[0]);
+        printf("       %s validate [depth]\n", argv[0]);
+        return 1;
+    }
+
+    return RunDivide(argc >= 3 ? argv[2] : FEN_START_POSITION, atoi(argv[1]), argc >= 4 ? atoi(argv[3]) : 1);
+
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+//Search benchmark, prints every finished iteration of the engine's search.
+//
+//  search_benchmark [timeMs] [fen] [threads]       one search with a time budget, 1000 ms and the starting position by default
+//  search_benchmark depth <depth> [fen] [threads]  search to a fixed depth without a time limit
+//  search_benchmark suite [timeMs] [threads]       the positions below one after another, with totals
+//  search_benchmark scaling <depth> [maxThreads]   time to depth and nodes per second on 1 to maxThreads threads
+//
+//Every line shows the depth, score, nodes, elapsed time, nodes per second and principal variation.
+//threads defaults to 1 and maxThreads to the number of cores.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../position.h"
+#include "../attacks.h"
+#include "../zobrist.h"
+#include "../fen.h"
+#include "../search.h"
+#include "../transposition_table.h"
+#include "../platform.h"
+
+#define TABLE_MEGABYTES 64
+#define DEFAULT_TIME_MS 1000
+
+static const char* benchmarkPositions[] = {
+    FEN_START_POSITION,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1" //Back rank mate in one
+};
+
+static void PrintIteration(const SearchResult* result, void* context){
+
+    (void)context;
+    double seconds = result->elapsedNs / 1e9;
+
+    printf("depth %2d  score ", result->depth);
+    if(result->score >= SCORE_MATE_BOUND) printf("mate %3d", (SCORE_MATE - result->score + 1) / 2);
+    else if(result->score <= -SCORE_MATE_BOUND) printf("mate %3d", -(SCORE_MATE + result->score) / 2);
+    else printf("%8d", result->score);
+    printf("  nodes %10llu  time %7.3f s  nps %9.0f  pv", (unsigned long long)result->nodes, seconds, seconds > 0 ? result->nodes / seconds : 0.0);
+
+    char moveString[6];
+    for(int i = 0; i < result->pvLength; i++){
+        Move_ToString(result->pv[i], moveString);
+        printf(" %s", moveString);
+    }
+    printf("\n");
+
+}
+
+static int RunSearch(TranspositionTable* table, const char* fen, int depth, uint64_t timeMs, int threads, int print, SearchResult* result){
+
+    Position position;
+    if(!Position_LoadFen(&position, fen)){
+        printf("Could not parse fen: %s\n", fen);
+        return 0;
+    }
+
+    SearchLimits limits;
+    memset(&limits, 0, sizeof(limits));
+    limits.depth = depth;
+    limits.timeMs = timeMs;
+    limits.threads = threads;
+    limits.report = print ? PrintIteration : NULL;
+
+    TranspositionTable_Clear(table);
+    if(print) printf("%s\n", fen);
+    Search_Run(&position, NULL, 0, &limits, table, result);
+    if(!print) return 1;
+
+    char moveString[6];
+    Move_ToString(result->bestMove, moveString);
+    printf("bestmove %s  hashfull %d\n\n", moveString, TranspositionTable_Hashfull(table));
+    return 1;
+
+}
+
+//Fixed depth searches of every position on 1, 2, 4... threads. Lazy SMP threads don't split the tree, they race
+//through it together, so the speedup that matters is how much sooner the depth is reached rather than raw nodes per second.
+static int RunScaling(TranspositionTable* table, int depth, int maxThreads){
+
+    int positionCount = (int)(sizeof(benchmarkPositions) / sizeof(benchmarkPositions[0]));
+    uint64_t baseTime = 0;
+    double baseNps = 0;
+    SearchResult result;
+
+    printf("Threads        Nodes   Time to depth           NPS  Time speedup  NPS scaling\n");
+    for(int threads = 1; threads <= maxThreads; threads = (threads*2 > maxThreads && threads != maxThreads) ? maxThreads : threads*2){
+
+        uint64_t nodes = 0, elapsed = 0;
+        for(int i = 0; i < positionCount; i++){
+            if(!RunSearch(table, benchmarkPositions[i], depth, 0, threads, 0, &result)) return 1;
+            nodes += result.nodes;
+            elapsed += result.elapsedNs;
+        }
+
+        double seconds = elapsed / 1e9;
+        double nps = seconds > 0 ? nodes / seconds : 0.0;
+        if(threads == 1){
+            baseTime = elapsed;
+            baseNps = nps;
+        }
+        printf("%7d %12llu %13.3f s %13.0f %12.2fx %11.2fx\n", threads, (unsigned long long)nodes, seconds, nps,
+            elapsed ? (double)baseTime / elapsed : 0.0, baseNps > 0 ? nps / baseNps : 0.0);
+
+    }
+
+    return 0;
+
+}
+
+int main(int argc, char** argv){
+
+    Attacks_Init();
+    Zobrist_Init();
+
+    TranspositionTable table;
+    if(!TranspositionTable_Init(&table, TABLE_MEGABYTES)){
+        printf("Could not allocate the transposition table\n");
+        return 1;
+    }
+
+    SearchResult result;
+    int status = 0;
+
+    if(argc >= 2 && strcmp(argv[1], "suite") == 0){
+
+        uint64_t timeMs = argc >= 3 ? strtoull(argv[2], NULL, 10) : DEFAULT_TIME_MS;
+        int threads = argc >= 4 ? atoi(argv[3]) : 1;
+        uint64_t totalNodes = 0, totalTime = 0;
+        int depthSum = 0;
+        int positionCount = (int)(sizeof(benchmarkPositions) / sizeof(benchmarkPositions[0]));
+
+        for(int i = 0; i < positionCount; i++){
+            if(!RunSearch(&table, benchmarkPositions[i], 0, timeMs, threads, 1, &result)){
+                status = 1;
+                continue;
+            }
+            totalNodes += result.nodes;
+            totalTime += result.elapsedNs;
+            depthSum += result.depth;
+        }
+
+        double seconds = totalTime / 1e9;
+        printf("Total nodes:   %llu\n", (unsigned long long)totalNodes);
+        printf("Total time:    %.3f s\n", seconds);
+        printf("NPS:           %.0f\n", seconds > 0 ? totalNodes / seconds : 0.0);
+        printf("Average depth: %.1f\n", (double)depthSum / positionCount);
+
+    }
+    else if(argc >= 3 && strcmp(argv[1], "depth") == 0){
+        status = !RunSearch(&table, argc >= 4 ? argv[3] : FEN_START_POSITION, atoi(argv[2]), 0, argc >= 5 ? atoi(argv[4]) : 1, 1, &result);
+    }
+    else if(argc >= 3 && strcmp(argv[1], "scaling") == 0){
+        int maxThreads = argc >= 4 ? atoi(argv[3]) : Platform_ProcessorCount();
+        if(maxThreads < 1) maxThreads = 1;
+        status = RunScaling(&table, atoi(argv[2]), maxThreads);
+    }
+    else{
+        uint64_t timeMs = argc >= 2 ? strtoull(argv[1], NULL, 10) : DEFAULT_TIME_MS;
+        if(timeMs == 0){
+            printf("Usage: %s [timeMs] [fen] [threads]\n", argv[0]);
+            printf("       %s depth <depth> [fen] [threads]\n", argv[0]);
+            printf("       %s suite [timeMs] [threads]\n", argv[0]);
+            printf("       %s scaling <depth> [maxThreads]\n", argv[0]);
+            status = 1;
+        }
+        else{
+            status = !RunSearch(&table, argc >= 3 ? argv[2] : FEN_START_POSITION, 0, timeMs, argc >= 4 ? atoi(argv[3]) : 1, 1, &result);
+        }
+    }
+
+    TranspositionTable_Free(&table);
+    return status;
+
+}
\ No newline at end of file
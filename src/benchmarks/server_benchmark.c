@@ -0,0 +1,318 @@
+//Load test for the headless server, measures how many games it holds and how fast it relays their moves.
+//
+//  server_benchmark [games] [moves] [spectators]                                         server on a thread of this process
+//  server_benchmark external <host> <port> [games] [moves] [spectators] [spectatorPort]  drives a separate chess_server
+//
+//Every game plays moves moves, each a MESSAGE_MOVE frame answered by the opponent as soon as it arrives. The
+//players shuffle their king's knights out and back, so every move passes the server's legality check.
+//Spectators are spread over the first few games and replay every move they're sent.
+//games defaults to 1000, moves to 100 and spectators to 0. Each game takes four sockets in process and two with
+//an external server, so large runs need the open file limit raised or the external mode.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../server.h"
+#include "../protocol.h"
+#include "../platform.h"
+#include "../attacks.h"
+#include "../zobrist.h"
+#include "../movegen.h"
+
+#define BENCHMARK_PORT "27115"
+#define BENCHMARK_SPECTATOR_PORT "27116"
+#define BENCHMARK_FEATURED_GAMES 10
+#define BENCHMARK_DEFAULT_GAMES 1000
+#define BENCHMARK_DEFAULT_MOVES 100
+
+typedef struct BenchmarkClient{
+    NetSocket socket;
+    int side;      //-1 until the server has paired it, or for a spectator
+    int sent;      //Moves this player has made
+    uint32_t game; //Number the server gave the player's game
+    int seen;      //Moves this spectator has been sent, -1 until it has the position
+    Position position; //Spectators replay the moves on it, any move that isn't legal there fails the run
+    RingBuffer in;
+} BenchmarkClient;
+
+typedef struct BenchmarkRun{
+    BenchmarkClient* clients; //Players first, white then black of each pair in connect order, spectators after them
+    int players;
+    int spectators;
+    int moves;
+    NetReactor reactor;
+    NetEvent* events;
+    uint64_t movesLeft;       //Still to be relayed between players
+    uint64_t spectatorMovesLeft;
+    uint64_t spectatorBytes;
+    int paired;
+    int watching;
+    int started;              //Whites only move once every spectator is in place
+    uint64_t failures;
+} BenchmarkRun;
+
+static void RunServer(void* argument){
+    Server_Run((GameServer*)argument);
+}
+
+static int SendMove(BenchmarkClient* client){
+
+    //g1f3 f3g1 for white, g8f6 f6g8 for black
+    int home = (client->side == WHITE) ? 62 : 6;
+    int out = (client->side == WHITE) ? 45 : 21;
+    Move move = (client->sent % 2 == 0) ? MOVE_CREATE(home, out, MOVE_FLAG_QUIET) : MOVE_CREATE(out, home, MOVE_FLAG_QUIET);
+    unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+    unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+    int frameLength = Protocol_Encode(frame, MESSAGE_MOVE, payload, Protocol_EncodeMove(payload, move));
+
+    client->sent++;
+    return Net_Send(client->socket, frame, frameLength) == frameLength;
+
+}
+
+static int Connect(BenchmarkRun* run, int index, const char* host, const char* port){
+
+    BenchmarkClient* client = &run->clients[index];
+    client->socket = Net_Connect(host, port);
+    client->side = -1;
+    client->sent = 0;
+    client->seen = -1;
+    RingBuffer_Reset(&client->in);
+    if(client->socket == NET_INVALID_SOCKET || !NetReactor_Add(&run->reactor, client->socket, NET_EVENT_READ, index)){
+        printf("Connection %d failed, raise the open file limit or lower games\n", index);
+        return 0;
+    }
+    return 1;
+
+}
+
+static void HandleMessage(BenchmarkRun* run, BenchmarkClient* client, const ProtocolMessage* message){
+
+    enum CHESS_SIDE side;
+    uint32_t game;
+    Move move;
+    PositionUndo undo;
+
+    switch(message->type){
+        case MESSAGE_SIDE:
+            if(!Protocol_DecodeSide(message, &side, &game)) run->failures++;
+            client->side = side;
+            client->game = game;
+            run->paired++;
+            break;
+        case MESSAGE_POSITION:
+            if(!Protocol_DecodePosition(message, &client->position)) run->failures++;
+            client->seen = 0;
+            run->watching++;
+            break;
+        case MESSAGE_MOVE:
+            if(client->side == -1){
+                if(!Protocol_DecodeMove(message, &move) || !Position_IsLegalMove(&client->position, move)){
+                    run->failures++;
+                    break;
+                }
+                Position_MakeMove(&client->position, move, &undo);
+                client->seen++;
+                run->spectatorMovesLeft--;
+                break;
+            }
+            run->movesLeft--;
+            int quota = (client->side == WHITE) ? (run->moves + 1) / 2 : run->moves / 2;
+            if(client->sent < quota && !SendMove(client)) run->failures++;
+            break;
+        case MESSAGE_ERROR:
+            printf("Server ended a game: %.*s\n", message->length, (const char*)message->payload);
+            run->failures++;
+            break;
+    }
+
+}
+
+//Waits for and handles whatever the server sends until done says to stop. Returns 0 on a failure or time out.
+static int Pump(BenchmarkRun* run, int (*done)(const BenchmarkRun* run)){
+
+    int clientCount = run->players + run->spectators;
+    while(!done(run) && run->failures == 0){
+
+        int eventCount = NetReactor_Wait(&run->reactor, run->events, clientCount, 5000);
+        if(eventCount <= 0){
+            printf("Timed out with %llu moves and %llu spectator moves left\n", (unsigned long long)run->movesLeft,
+                (unsigned long long)run->spectatorMovesLeft);
+            run->failures++;
+            break;
+        }
+
+        for(int e = 0; e < eventCount; e++){
+
+            BenchmarkClient* client = &run->clients[run->events[e].data];
+            int space;
+            unsigned char* span = RingBuffer_WriteSpan(&client->in, &space);
+            int received = Net_Recv(client->socket, span, space);
+            if(received == NET_WOULD_BLOCK) continue;
+            if(received <= 0){
+                run->failures++;
+                break;
+            }
+            RingBuffer_Commit(&client->in, received);
+            if(client->side == -1) run->spectatorBytes += received;
+
+            ProtocolMessage message;
+            int result;
+            while((result = Protocol_Read(&client->in, &message)) == PROTOCOL_MESSAGE){
+                HandleMessage(run, client, &message);
+            }
+            if(result == PROTOCOL_MALFORMED) run->failures++;
+
+        }
+
+    }
+    return run->failures == 0;
+
+}
+
+static int AllPaired(const BenchmarkRun* run){
+    return run->paired == run->players;
+}
+
+static int AllWatching(const BenchmarkRun* run){
+    return run->watching == run->spectators;
+}
+
+static int AllPlayed(const BenchmarkRun* run){
+    return run->movesLeft == 0 && run->spectatorMovesLeft == 0;
+}
+
+int RunClients(const char* host, const char* port, const char* spectatorPort, int games, int moves, int spectators){
+
+    BenchmarkRun run;
+    memset(&run, 0, sizeof(BenchmarkRun));
+    run.players = games*2;
+    run.spectators = spectators;
+    run.moves = moves;
+    int clientCount = run.players + spectators;
+    run.clients = (BenchmarkClient*)malloc(sizeof(BenchmarkClient) * clientCount);
+    run.events = (NetEvent*)malloc(sizeof(NetEvent) * clientCount);
+    if(run.clients == NULL || run.events == NULL || !NetReactor_Init(&run.reactor, clientCount)){
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    //Pair everyone first so the spectators have games to watch
+    uint64_t start = Platform_TimeNanoseconds();
+    for(int i = 0; i < run.players; i++){
+        if(!Connect(&run, i, host, port)) return 1;
+    }
+    int ok = Pump(&run, AllPaired);
+    uint64_t connected = Platform_TimeNanoseconds();
+
+    //Spectators crowd onto a few featured games, hundreds to a board in big runs
+    int featured = games < BENCHMARK_FEATURED_GAMES ? games : BENCHMARK_FEATURED_GAMES;
+    for(int i = 0; ok && i < spectators; i++){
+        int index = run.players + i;
+        if(!Connect(&run, index, host, spectatorPort)) return 1;
+        int white = (i % featured) * 2;
+        while(run.clients[white].side != WHITE) white++; //Pairs are made in connect order, the white one comes first
+        unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+        unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+        int frameLength = Protocol_Encode(frame, MESSAGE_WATCH, payload, Protocol_EncodeWatch(payload, run.clients[white].game));
+        if(Net_Send(run.clients[index].socket, frame, frameLength) != frameLength) run.failures++;
+    }
+    ok = ok && Pump(&run, AllWatching);
+    uint64_t watching = Platform_TimeNanoseconds();
+
+    //Each side makes half of the moves, white one more when it's odd
+    run.movesLeft = (uint64_t)games * moves;
+    run.spectatorMovesLeft = (uint64_t)spectators * moves;
+    for(int i = 0; i < run.players; i++){
+        if(ok && run.clients[i].side == WHITE && moves > 0 && !SendMove(&run.clients[i])) run.failures++;
+    }
+    ok = ok && Pump(&run, AllPlayed);
+    uint64_t finished = Platform_TimeNanoseconds();
+
+    for(int i = 0; i < clientCount; i++){
+        NetReactor_Remove(&run.reactor, run.clients[i].socket, i);
+        Net_Close(run.clients[i].socket);
+    }
+    NetReactor_Free(&run.reactor);
+    free(run.clients);
+    free(run.events);
+
+    double connectSeconds = (connected - start) / 1e9;
+    double playSeconds = (finished - watching) / 1e9;
+    uint64_t played = (uint64_t)games * moves - run.movesLeft;
+    printf("Games:        %d\n", games);
+    printf("Connect time: %.3f s\n", connectSeconds);
+    printf("Moves:        %llu\n", (unsigned long long)played);
+    printf("Play time:    %.3f s\n", playSeconds);
+    printf("Moves/s:      %.0f\n", playSeconds > 0 ? played / playSeconds : 0.0);
+    if(spectators > 0){
+        uint64_t delivered = (uint64_t)spectators * moves - run.spectatorMovesLeft;
+        printf("Spectators:   %d on %d games, attached in %.3f s\n", spectators, featured, (watching - connected) / 1e9);
+        printf("Moves delivered to spectators: %llu, %.0f/s, %llu bytes\n", (unsigned long long)delivered,
+            playSeconds > 0 ? delivered / playSeconds : 0.0, (unsigned long long)run.spectatorBytes);
+    }
+    printf("Server bytes per game: %d\n", (int)(sizeof(ServerConnection)*2 + sizeof(ServerGame)));
+
+    if(!ok){
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+
+}
+
+int main(int argc, char** argv){
+
+    Attacks_Init();
+    Zobrist_Init();
+    if(!Net_Init()){
+        printf("Could not initialize networking\n");
+        return 1;
+    }
+
+    if(argc >= 4 && strcmp(argv[1], "external") == 0){
+        int games = argc >= 5 ? atoi(argv[4]) : BENCHMARK_DEFAULT_GAMES;
+        int moves = argc >= 6 ? atoi(argv[5]) : BENCHMARK_DEFAULT_MOVES;
+        int spectators = argc >= 7 ? atoi(argv[6]) : 0;
+        int result = RunClients(argv[2], argv[3], argc >= 8 ? argv[7] : SERVER_DEFAULT_SPECTATOR_PORT, games, moves, spectators);
+        Net_Cleanup();
+        return result;
+    }
+
+    int games = argc >= 2 ? atoi(argv[1]) : BENCHMARK_DEFAULT_GAMES;
+    int moves = argc >= 3 ? atoi(argv[2]) : BENCHMARK_DEFAULT_MOVES;
+    int spectators = argc >= 4 ? atoi(argv[3]) : 0;
+    if(games < 1 || moves < 0 || spectators < 0){
+        printf("Usage: %s [games] [moves] [spectators]\n", argv[0]);
+        printf("       %s external <host> <port> [games] [moves] [spectators] [spectatorPort]\n", argv[0]);
+        return 1;
+    }
+
+    static GameServer server;
+    if(!Server_Init(&server, BENCHMARK_PORT, BENCHMARK_SPECTATOR_PORT, games, spectators)){
+        printf("Could not start the server on port %s\n", BENCHMARK_PORT);
+        return 1;
+    }
+    PlatformThread* serverThread = Platform_CreateThread(RunServer, &server);
+    if(serverThread == NULL){
+        printf("Could not start the server thread\n");
+        return 1;
+    }
+
+    int result = RunClients("127.0.0.1", BENCHMARK_PORT, BENCHMARK_SPECTATOR_PORT, games, moves, spectators);
+
+    server.running = 0;
+    Platform_JoinThread(serverThread);
+    printf("Server reads: %llu, writes: %llu, messages relayed: %llu, messages per read: %.2f\n", (unsigned long long)server.stats.reads,
+        (unsigned long long)server.stats.writes, (unsigned long long)server.stats.messagesRelayed,
+        server.stats.reads ? (double)server.stats.messagesRelayed / server.stats.reads : 0.0);
+    if(spectators > 0){
+        printf("Server broadcast bytes encoded: %llu, sent to spectators: %llu, chunks allocated: %d\n",
+            (unsigned long long)server.stats.broadcastBytes, (unsigned long long)server.stats.spectatorBytes, server.broadcastPool.allocated);
+    }
+    Server_Free(&server);
+    Net_Cleanup();
+    return result;
+
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+//Compares the square by square ray walks in chess.c against the magic bitboard lookups in attacks.c.
+//Both sides count the destination squares of every rook, bishop and queen over a set of random
+//middlegame-like boards, the totals must match or the benchmark reports a mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../chess.h"
+#include "../position.h"
+#include "../attacks.h"
+#include "../zobrist.h"
+#include "../platform.h"
+#include "../data_structures/chess_coord_pool.h"
+
+#define BENCHMARK_BOARDS 1024
+#define BENCHMARK_ROUNDS 200
+
+BoardState boards[BENCHMARK_BOARDS];
+Position positions[BENCHMARK_BOARDS];
+
+//Read through volatile pointers every round so the compiler cannot hoist the counting out of the timing loops
+BoardState* volatile boardsView = boards;
+Position* volatile positionsView = positions;
+
+void FillRandomBoard(BoardState* boardState){
+
+    static const enum CHESS_PIECE_TYPE types[] = { PAWN, KNIGHT, ROOK, BISHOP, QUEEN, KING };
+
+    for(int i = 0; i < 64; i++){
+        ChessPiece_Init(&boardState->board[i], WHITE, NONE);
+        //Roughly half the board occupied, heavy on sliders so they have something to hit
+        if(rand() % 2 == 0){
+            ChessPiece_Init(&boardState->board[i], (enum CHESS_SIDE)(rand() % 2), types[rand() % 6]);
+        }
+    }
+
+}
+
+long long CountRayWalkMoves(BoardState* boardSet){
+
+    ChessCoordPool coordPool;
+    ChessCoordPool_Init(&coordPool);
+
+    long long total = 0;
+    for(int b = 0; b < BENCHMARK_BOARDS; b++){
+        BoardState* boardState = &boardSet[b];
+        for(int i = 0; i < 64; i++){
+            ChessPiece* piece = &boardState->board[i];
+            if(piece->type == ROOK || piece->type == BISHOP || piece->type == QUEEN){
+                ChessPiece_GetAvailableMoves(piece, boardState, &coordPool, i % 8, i / 8);
+                total += coordPool.length;
+            }
+        }
+    }
+    return total;
+
+}
+
+long long CountMagicMoves(const Position* positionSet){
+
+    long long total = 0;
+    for(int b = 0; b < BENCHMARK_BOARDS; b++){
+        const Position* position = &positionSet[b];
+        Bitboard sliders = position->pieces[ROOK] | position->pieces[BISHOP] | position->pieces[QUEEN];
+        while(sliders){
+            int index = Bitboard_PopLSB(&sliders);
+            Bitboard own = position->sides[Position_PieceSideAt(position, index)];
+            Bitboard attacks;
+            switch(Position_PieceTypeAt(position, index)){
+                case ROOK:
+                    attacks = Attacks_Rook(index, position->occupied);
+                    break;
+                case BISHOP:
+                    attacks = Attacks_Bishop(index, position->occupied);
+                    break;
+                default:
+                    attacks = Attacks_Queen(index, position->occupied);
+                    break;
+            }
+            total += Bitboard_PopCount(attacks & ~own);
+        }
+    }
+    return total;
+
+}
+
+int main(void){
+
+    uint64_t initStart = Platform_TimeNanoseconds();
+    Attacks_Init();
+    Zobrist_Init();
+    uint64_t initTime = Platform_TimeNanoseconds() - initStart;
+
+    srand(1);
+    long long sliders = 0;
+    for(int b = 0; b < BENCHMARK_BOARDS; b++){
+        FillRandomBoard(&boards[b]);
+        Position_FromBoardState(&positions[b], &boards[b], WHITE);
+        sliders += Bitboard_PopCount(positions[b].pieces[ROOK] | positions[b].pieces[BISHOP] | positions[b].pieces[QUEEN]);
+    }
+
+    long long rayTotal = 0, magicTotal = 0;
+
+    uint64_t start = Platform_TimeNanoseconds();
+    for(int r = 0; r < BENCHMARK_ROUNDS; r++){
+        rayTotal += CountRayWalkMoves(boardsView);
+    }
+    uint64_t rayTime = Platform_TimeNanoseconds() - start;
+
+    start = Platform_TimeNanoseconds();
+    for(int r = 0; r < BENCHMARK_ROUNDS; r++){
+        magicTotal += CountMagicMoves(positionsView);
+    }
+    uint64_t magicTime = Platform_TimeNanoseconds() - start;
+
+    long long calls = sliders * BENCHMARK_ROUNDS;
+
+#if defined(ATTACKS_USE_PEXT)
+    printf("Index method:     PEXT\n");
+#else
+    printf("Index method:     magic multiply\n");
+#endif
+    printf("Table init:       %.2f ms\n", initTime / 1e6);
+    printf("Slider lookups:   %lld\n", calls);
+    printf("Ray walk:         %.2f ns/slider (%lld moves)\n", (double)rayTime / calls, rayTotal);
+    printf("Attack tables:    %.2f ns/slider (%lld moves)\n", (double)magicTime / calls, magicTotal);
+    printf("Speedup:          %.1fx\n", (double)rayTime / (double)magicTime);
+
+    if(rayTotal != magicTotal){
+        printf("MISMATCH between ray walk and attack tables!\n");
+        return 1;
+    }
+
+    return 0;
+
+}
\ No newline at end of file
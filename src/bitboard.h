@@ -0,0 +1,50 @@
+#ifndef H_BITBOARD
+#define H_BITBOARD
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//One bit per square, bit index matches GetBoardIndexFromColumnRow (a8 = 0, h1 = 63)
+typedef uint64_t Bitboard;
+
+#define BITBOARD_EMPTY 0ULL
+#define BITBOARD_SQUARE(index) (1ULL << (index))
+
+#define BITBOARD_FILE_A 0x0101010101010101ULL
+#define BITBOARD_FILE_H 0x8080808080808080ULL
+#define BITBOARD_ROW(row) (0xFFULL << ((row)*8))
+
+static inline int Bitboard_PopCount(Bitboard bitboard){
+#if defined(_MSC_VER)
+    return (int)__popcnt64(bitboard);
+#else
+    return __builtin_popcountll(bitboard);
+#endif
+}
+
+//Index of the lowest set bit, bitboard must not be empty
+static inline int Bitboard_LSB(Bitboard bitboard){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bitboard);
+    return (int)index;
+#else
+    return __builtin_ctzll(bitboard);
+#endif
+}
+
+//Removes the lowest set bit and returns its index
+static inline int Bitboard_PopLSB(Bitboard* bitboard){
+    int index = Bitboard_LSB(*bitboard);
+    *bitboard &= *bitboard - 1;
+    return index;
+}
+
+static inline int Bitboard_Test(Bitboard bitboard, int index){
+    return (int)((bitboard >> index) & 1ULL);
+}
+
+#endif
\ No newline at end of file
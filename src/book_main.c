@@ -0,0 +1,192 @@
+//Opening books built from game archives.
+//
+//  chess_book build <archive> <book> [plies] [minGames] [threads]  builds a book of the moves played in the first plies
+//                                                                 plies of the games, 24 and 2 games by default
+//  chess_book probe <book> [fen]                                  lists the book moves of a position, the start by default
+//  chess_book bench <book> [lookups]                              times lookups and picks along the book's own lines
+//
+//threads defaults to one per core.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opening_book.h"
+#include "byte_order.h"
+#include "san.h"
+#include "fen.h"
+#include "movegen.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "platform.h"
+
+#define BOOK_BENCH_POSITIONS 4096
+
+static uint64_t NextRandom(uint64_t* state){
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int Build(int argc, char** argv){
+
+    int maxPlies = argc >= 5 ? atoi(argv[4]) : OPENING_BOOK_DEFAULT_PLIES;
+    int minGames = argc >= 6 ? atoi(argv[5]) : OPENING_BOOK_DEFAULT_MIN_GAMES;
+    int threadCount = argc >= 7 ? atoi(argv[6]) : 0;
+    if(threadCount <= 0) threadCount = Platform_ProcessorCount();
+
+    GameArchive archive;
+    if(!GameArchive_Open(&archive, argv[2])){
+        printf("Could not open the game archive %s\n", argv[2]);
+        return 1;
+    }
+
+    OpeningBookBuildStats stats;
+    uint64_t start = Platform_TimeNanoseconds();
+    int built = OpeningBook_Build(&archive, argv[3], threadCount, maxPlies, minGames, &stats);
+    double seconds = (Platform_TimeNanoseconds() - start) / 1e9;
+    GameArchive_Close(&archive);
+    if(!built){
+        printf("Could not build the book %s\n", argv[3]);
+        return 1;
+    }
+
+    OpeningBook book;
+    uint64_t size = 0;
+    if(OpeningBook_Open(&book, argv[3])){
+        size = book.size;
+        OpeningBook_Close(&book);
+    }
+    printf("Read %llu games (%llu skipped), %llu moves\n", (unsigned long long)stats.games, (unsigned long long)stats.skipped,
+        (unsigned long long)stats.moves);
+    printf("%llu positions, %llu book moves, %.1f MB\n", (unsigned long long)stats.positions, (unsigned long long)stats.entries,
+        size / 1e6);
+    printf("%.2f s, %.0f games a second\n", seconds, seconds > 0 ? stats.games / seconds : 0.0);
+    return 0;
+
+}
+
+int Probe(const OpeningBook* book, const char* fen){
+
+    Position position;
+    if(!Position_LoadFen(&position, fen)){
+        printf("Invalid fen: %s\n", fen);
+        return 1;
+    }
+
+    OpeningBookMove moves[MAX_LEGAL_MOVES];
+    int count = OpeningBook_Lookup(book, position.hash, moves, MAX_LEGAL_MOVES);
+    uint64_t total = 0;
+    for(int i = 0; i < count; i++){
+        total += moves[i].weight;
+    }
+    if(count == 0){
+        printf("Not in the book\n");
+        return 0;
+    }
+
+    for(int i = 0; i < count; i++){
+        char san[SAN_MAX_LENGTH];
+        if(Position_IsLegalMove(&position, moves[i].move)) Position_MoveToSan(&position, moves[i].move, san);
+        else strcpy(san, "?");
+        printf("%-8s %5.1f%%  weight %5u  %9u games\n", san, total > 0 ? moves[i].weight*100.0/total : 0.0,
+            moves[i].weight, moves[i].games);
+    }
+    return 0;
+
+}
+
+//Positions along random lines of the book, so picks are timed on positions the engine would really look up
+static int BookPositions(const OpeningBook* book, Position* positions, int maxPositions, uint64_t* randomState){
+
+    int count = 0;
+    for(int line = 0; line < maxPositions*4 && count < maxPositions; line++){
+        Position position;
+        Position_LoadFen(&position, FEN_START_POSITION);
+        while(count < maxPositions){
+            Move move = OpeningBook_Pick(book, &position, randomState);
+            if(move == MOVE_NONE) break;
+            positions[count++] = position;
+            PositionUndo undo;
+            Position_MakeMove(&position, move, &undo);
+        }
+    }
+    return count;
+
+}
+
+int Bench(const OpeningBook* book, int lookups){
+
+    if(book->count == 0){
+        printf("The book is empty\n");
+        return 1;
+    }
+
+    Position* positions = (Position*)malloc(sizeof(Position)*BOOK_BENCH_POSITIONS);
+    if(positions == NULL) return 1;
+    uint64_t randomState = 1;
+    int positionCount = BookPositions(book, positions, BOOK_BENCH_POSITIONS, &randomState);
+
+    //Every stored position, picked at random
+    uint64_t checksum = 0;
+    int hits = 0;
+    uint64_t start = Platform_TimeNanoseconds();
+    for(int i = 0; i < lookups; i++){
+        OpeningBookMove moves[MAX_LEGAL_MOVES];
+        uint64_t entry = NextRandom(&randomState) % book->count;
+        const unsigned char* stored = book->entries + entry*OPENING_BOOK_ENTRY_SIZE;
+        uint64_t hash = ByteOrder_ReadUint64(stored);
+        int found = OpeningBook_Lookup(book, hash, moves, MAX_LEGAL_MOVES);
+        hits += found > 0;
+        checksum += found > 0 ? moves[0].move : 0;
+    }
+    uint64_t lookupTime = Platform_TimeNanoseconds() - start;
+
+    //Picks check every move for legality and draw one
+    int picked = 0;
+    start = Platform_TimeNanoseconds();
+    for(int i = 0; positionCount > 0 && i < lookups; i++){
+        Move move = OpeningBook_Pick(book, &positions[i % positionCount], &randomState);
+        picked += move != MOVE_NONE;
+        checksum += move;
+    }
+    uint64_t pickTime = Platform_TimeNanoseconds() - start;
+
+    printf("%llu book moves, %d positions along its lines\n", (unsigned long long)book->count, positionCount);
+    printf("Lookup: %d of %d found, %.0f ns each\n", hits, lookups, (double)lookupTime / lookups);
+    printf("Pick:   %d of %d picked, %.0f ns each (checksum %llu)\n", picked, lookups, (double)pickTime / lookups,
+        (unsigned long long)checksum);
+    free(positions);
+    return hits == lookups && (positionCount == 0 || picked == lookups) ? 0 : 1;
+
+}
+
+int main(int argc, char** argv){
+
+    int build = argc >= 4 && strcmp(argv[1], "build") == 0;
+    int probe = argc >= 3 && strcmp(argv[1], "probe") == 0;
+    int bench = argc >= 3 && strcmp(argv[1], "bench") == 0;
+    if(!build && !probe && !bench){
+        printf("Usage: %s build <archive> <book> [plies] [minGames] [threads]\n", argv[0]);
+        printf("       %s probe <book> [fen]\n", argv[0]);
+        printf("       %s bench <book> [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    Attacks_Init();
+    Zobrist_Init();
+    if(build) return Build(argc, argv);
+
+    OpeningBook book;
+    if(!OpeningBook_Open(&book, argv[2])){
+        printf("Could not open the opening book %s\n", argv[2]);
+        return 1;
+    }
+    int result;
+    if(probe) result = Probe(&book, argc >= 4 ? argv[3] : FEN_START_POSITION);
+    else result = Bench(&book, argc >= 4 && atoi(argv[3]) > 0 ? atoi(argv[3]) : 1000000);
+    OpeningBook_Close(&book);
+    return result;
+
+}
\ No newline at end of file
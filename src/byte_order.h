@@ -0,0 +1,42 @@
+#ifndef H_BYTE_ORDER
+#define H_BYTE_ORDER
+
+#include <stdint.h>
+
+//Little endian numbers of the files and messages, read and written a byte at a time so they come out the same on
+//any machine and from unaligned offsets into a mapping or payload
+
+static inline void ByteOrder_WriteUint16(unsigned char* out, uint16_t value){
+    out[0] = (unsigned char)(value & 0xFF);
+    out[1] = (unsigned char)(value >> 8);
+}
+
+static inline uint16_t ByteOrder_ReadUint16(const unsigned char* in){
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static inline void ByteOrder_WriteUint32(unsigned char* out, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        out[i] = (unsigned char)(value >> (i*8));
+    }
+}
+
+static inline uint32_t ByteOrder_ReadUint32(const unsigned char* in){
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static inline void ByteOrder_WriteUint64(unsigned char* out, uint64_t value){
+    for(int i = 0; i < 8; i++){
+        out[i] = (unsigned char)(value >> (i*8));
+    }
+}
+
+static inline uint64_t ByteOrder_ReadUint64(const unsigned char* in){
+    uint64_t value = 0;
+    for(int i = 7; i >= 0; i--){
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+#endif
\ No newline at end of file
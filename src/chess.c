@@ -1,4 +1,5 @@
 #include "chess.h"
+#include "zobrist.h"
 #include "./data_structures/chess_coord_pool.h"
 
 #include <stdlib.h>
@@ -318,13 +319,19 @@ int GetBoardIndexFromColumnRow(int column, int row){
 void SetBoardPieceSide(BoardState* boardState, int column, int row, enum CHESS_SIDE side){
 
     int index = GetBoardIndexFromColumnRow(column, row);
-    boardState->board[index].side = side;
+    ChessPiece* piece = &boardState->board[index];
+    boardState->hash ^= zobristPieces[piece->side][piece->type][index] ^ zobristPieces[side][piece->type][index];
+    piece->side = side;
+    ZOBRIST_DEBUG_CHECK(boardState->hash, Zobrist_ComputeBoardState(boardState));
 
 }
 
 void SetBoardPieceType(BoardState* boardState, int column, int row, enum CHESS_PIECE_TYPE type){
 
     int index = GetBoardIndexFromColumnRow(column, row);
-    boardState->board[index].type = type;
+    ChessPiece* piece = &boardState->board[index];
+    boardState->hash ^= zobristPieces[piece->side][piece->type][index] ^ zobristPieces[piece->side][type][index];
+    piece->type = type;
+    ZOBRIST_DEBUG_CHECK(boardState->hash, Zobrist_ComputeBoardState(boardState));
 
 }
@@ -1,6 +1,8 @@
 #ifndef H_CHESS_PIECES
 #define H_CHESS_PIECES
 
+#include <stdint.h>
+
 #include "chess_coord.h"
 #include "./data_structures/chess_coord_pool.h"
 
@@ -32,19 +34,10 @@ typedef struct BoardState{
     int height;
 
     ChessPiece board[64];
+    uint64_t hash; //Zobrist hash of the pieces, kept up to date by SetBoardPieceType and SetBoardPieceSide
 
 } BoardState;
 
-typedef struct ChessMove{
-    int fromCol;
-    int fromRow;
-    int toCol;
-    int toRow;
-    enum CHESS_SIDE toSide;
-    enum CHESS_PIECE_TYPE toType;
-
-} ChessMove;
-
 int GetBoardIndexFromColumnRow(int column, int row);
 void SetBoardPieceType(BoardState* boardState, int column, int row, enum CHESS_PIECE_TYPE type);
 void SetBoardPieceSide(BoardState* boardState, int column, int row, enum CHESS_SIDE side);
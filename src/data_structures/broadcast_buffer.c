@@ -0,0 +1,118 @@
+#include "broadcast_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static BroadcastBuffer* Acquire(BroadcastPool* pool){
+
+    BroadcastBuffer* buffer = pool->free;
+    if(buffer != NULL){
+        pool->free = buffer->next;
+    }
+    else{
+        buffer = (BroadcastBuffer*)malloc(sizeof(BroadcastBuffer));
+        if(buffer == NULL) return NULL;
+        pool->allocated++;
+    }
+
+    buffer->next = NULL;
+    buffer->references = 1;
+    buffer->length = 0;
+    pool->inUse++;
+    return buffer;
+
+}
+
+void BroadcastPool_Init(BroadcastPool* pool){
+    pool->free = NULL;
+    pool->allocated = 0;
+    pool->inUse = 0;
+}
+
+void BroadcastPool_Free(BroadcastPool* pool){
+
+    while(pool->free != NULL){
+        BroadcastBuffer* next = pool->free->next;
+        free(pool->free);
+        pool->free = next;
+        pool->allocated--;
+    }
+
+}
+
+void BroadcastBuffer_Release(BroadcastPool* pool, BroadcastBuffer* buffer){
+
+    //Walked rather than recursed, a long chain nobody reads any more can go in one release
+    while(buffer != NULL && --buffer->references == 0){
+        BroadcastBuffer* next = buffer->next;
+        buffer->next = pool->free;
+        pool->free = buffer;
+        pool->inUse--;
+        buffer = next;
+    }
+
+}
+
+int BroadcastStream_Open(BroadcastPool* pool, BroadcastStream* stream){
+    stream->tail = Acquire(pool);
+    stream->written = 0;
+    return stream->tail != NULL;
+}
+
+void BroadcastStream_Close(BroadcastPool* pool, BroadcastStream* stream){
+    if(stream->tail != NULL) BroadcastBuffer_Release(pool, stream->tail);
+    stream->tail = NULL;
+}
+
+int BroadcastStream_Write(BroadcastPool* pool, BroadcastStream* stream, const void* data, int size){
+
+    BroadcastBuffer* tail = stream->tail;
+    if(tail->length + size > BROADCAST_BUFFER_SIZE){
+        //The new chunk's first reference is the link from the old one, the stream takes a second
+        BroadcastBuffer* next = Acquire(pool);
+        if(next == NULL) return 0;
+        tail->next = next;
+        BroadcastBuffer_Retain(next);
+        BroadcastBuffer_Release(pool, tail);
+        stream->tail = tail = next;
+    }
+
+    memcpy(tail->data + tail->length, data, size);
+    tail->length += size;
+    stream->written += size;
+    return 1;
+
+}
+
+void BroadcastReader_Attach(BroadcastReader* reader, const BroadcastStream* stream){
+    reader->buffer = stream->tail;
+    reader->offset = stream->tail->length;
+    reader->read = stream->written;
+    BroadcastBuffer_Retain(reader->buffer);
+}
+
+void BroadcastReader_Detach(BroadcastPool* pool, BroadcastReader* reader){
+    if(reader->buffer != NULL) BroadcastBuffer_Release(pool, reader->buffer);
+    reader->buffer = NULL;
+}
+
+const unsigned char* BroadcastReader_Span(BroadcastPool* pool, BroadcastReader* reader, int* size){
+
+    BroadcastBuffer* buffer = reader->buffer;
+    while(reader->offset == buffer->length && buffer->next != NULL){
+        BroadcastBuffer* next = buffer->next;
+        BroadcastBuffer_Retain(next);
+        BroadcastBuffer_Release(pool, buffer);
+        reader->buffer = buffer = next;
+        reader->offset = 0;
+    }
+
+    *size = buffer->length - reader->offset;
+    return buffer->data + reader->offset;
+
+}
+
+void BroadcastReader_Consume(BroadcastReader* reader, int size){
+    reader->offset += size;
+    reader->read += size;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef H_BROADCAST_BUFFER
+#define H_BROADCAST_BUFFER
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BROADCAST_BUFFER_SIZE 1024
+
+//A stream of bytes written once and sent as is to any number of readers. It's a chain of reference counted
+//chunks: the writer holds the chunk it appends to, every chunk holds the one after it and every reader holds
+//the chunk it's sending from. Readers send straight out of the chunks, nothing is copied per reader, and a chunk
+//goes back to the pool as soon as the slowest reader has moved past it.
+//The counts aren't atomic, a pool and its streams belong to one thread.
+typedef struct BroadcastBuffer{
+
+    struct BroadcastBuffer* next; //NULL until the writer moves on to a new chunk
+    int32_t references;
+    int32_t length;
+    unsigned char data[BROADCAST_BUFFER_SIZE];
+
+} BroadcastBuffer;
+
+//Recycles chunks so a busy stream doesn't go to malloc for every one
+typedef struct BroadcastPool{
+    BroadcastBuffer* free;
+    int allocated;
+    int inUse;
+} BroadcastPool;
+
+typedef struct BroadcastStream{
+    BroadcastBuffer* tail; //NULL while the stream is closed
+    uint64_t written;      //Every byte ever written
+} BroadcastStream;
+
+typedef struct BroadcastReader{
+    BroadcastBuffer* buffer; //NULL while detached
+    int32_t offset;          //Into buffer->data, everything before it has been sent
+    uint64_t read;           //Stream position reached, compared to written to tell how far behind the reader is
+} BroadcastReader;
+
+void BroadcastPool_Init(BroadcastPool* pool);
+//Frees the pooled chunks, chunks still referenced are left alone
+void BroadcastPool_Free(BroadcastPool* pool);
+
+static inline void BroadcastBuffer_Retain(BroadcastBuffer* buffer){
+    buffer->references++;
+}
+//Drops one reference, a chunk that reaches 0 returns to the pool and drops its hold on the next one
+void BroadcastBuffer_Release(BroadcastPool* pool, BroadcastBuffer* buffer);
+
+//Returns 0 if no chunk could be allocated
+int BroadcastStream_Open(BroadcastPool* pool, BroadcastStream* stream);
+void BroadcastStream_Close(BroadcastPool* pool, BroadcastStream* stream);
+//Appends size bytes, at most BROADCAST_BUFFER_SIZE, to one chunk so they are never split. Returns 0 if out of memory.
+int BroadcastStream_Write(BroadcastPool* pool, BroadcastStream* stream, const void* data, int size);
+
+//Starts reading at the end of what was written so far
+void BroadcastReader_Attach(BroadcastReader* reader, const BroadcastStream* stream);
+void BroadcastReader_Detach(BroadcastPool* pool, BroadcastReader* reader);
+//Contiguous unsent bytes, moving on to the next chunk once this one is used up. size is 0 when the reader is caught up.
+const unsigned char* BroadcastReader_Span(BroadcastPool* pool, BroadcastReader* reader, int* size);
+void BroadcastReader_Consume(BroadcastReader* reader, int size);
+
+static inline int BroadcastReader_Pending(const BroadcastReader* reader){
+    return reader->buffer != NULL && (reader->offset < reader->buffer->length || reader->buffer->next != NULL);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef H_MOVELIST
+#define H_MOVELIST
+
+#include "../move.h"
+
+#define MAX_LEGAL_MOVES 256 //No legal chess position has more than 218 moves
+
+typedef struct MoveList{
+
+    int length;
+    Move moves[MAX_LEGAL_MOVES];
+
+} MoveList;
+
+static inline void MoveList_Reset(MoveList* moveList){
+    moveList->length = 0;
+}
+
+static inline void MoveList_Add(MoveList* moveList, Move move){
+    moveList->moves[moveList->length++] = move;
+}
+
+#endif
\ No newline at end of file
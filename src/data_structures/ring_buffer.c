@@ -0,0 +1,55 @@
+#include "ring_buffer.h"
+
+#include <string.h>
+
+#define RING_BUFFER_MASK (RING_BUFFER_SIZE - 1)
+
+int RingBuffer_Write(RingBuffer* ringBuffer, const void* data, int size){
+
+    if(size > RingBuffer_Space(ringBuffer)) return 0;
+
+    int position = (int)(ringBuffer->tail & RING_BUFFER_MASK);
+    int first = RING_BUFFER_SIZE - position;
+    if(first > size) first = size;
+    memcpy(ringBuffer->data + position, data, first);
+    memcpy(ringBuffer->data, (const unsigned char*)data + first, size - first);
+    ringBuffer->tail += size;
+    return 1;
+
+}
+
+void RingBuffer_Peek(const RingBuffer* ringBuffer, int offset, void* out, int size){
+
+    int position = (int)((ringBuffer->head + offset) & RING_BUFFER_MASK);
+    int first = RING_BUFFER_SIZE - position;
+    if(first > size) first = size;
+    memcpy(out, ringBuffer->data + position, first);
+    memcpy((unsigned char*)out + first, ringBuffer->data, size - first);
+
+}
+
+void RingBuffer_Consume(RingBuffer* ringBuffer, int size){
+    ringBuffer->head += size;
+}
+
+unsigned char* RingBuffer_WriteSpan(RingBuffer* ringBuffer, int* size){
+
+    int position = (int)(ringBuffer->tail & RING_BUFFER_MASK);
+    int space = RingBuffer_Space(ringBuffer);
+    *size = (RING_BUFFER_SIZE - position < space) ? RING_BUFFER_SIZE - position : space;
+    return ringBuffer->data + position;
+
+}
+
+void RingBuffer_Commit(RingBuffer* ringBuffer, int size){
+    ringBuffer->tail += size;
+}
+
+const unsigned char* RingBuffer_ReadSpan(const RingBuffer* ringBuffer, int* size){
+
+    int position = (int)(ringBuffer->head & RING_BUFFER_MASK);
+    int length = RingBuffer_Length(ringBuffer);
+    *size = (RING_BUFFER_SIZE - position < length) ? RING_BUFFER_SIZE - position : length;
+    return ringBuffer->data + position;
+
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef H_RING_BUFFER
+#define H_RING_BUFFER
+
+#include <stdint.h>
+
+#define RING_BUFFER_SIZE 256 //Power of two so positions wrap with a mask
+
+//Fixed size byte queue. head and tail count every byte ever written and read, their difference is the length.
+//Sockets read into and send from it directly through the span calls, no bytes are copied on the way.
+typedef struct RingBuffer{
+
+    uint32_t head; //Read position
+    uint32_t tail; //Write position
+    unsigned char data[RING_BUFFER_SIZE];
+
+} RingBuffer;
+
+static inline void RingBuffer_Reset(RingBuffer* ringBuffer){
+    ringBuffer->head = 0;
+    ringBuffer->tail = 0;
+}
+
+static inline int RingBuffer_Length(const RingBuffer* ringBuffer){
+    return (int)(ringBuffer->tail - ringBuffer->head);
+}
+
+static inline int RingBuffer_Space(const RingBuffer* ringBuffer){
+    return RING_BUFFER_SIZE - RingBuffer_Length(ringBuffer);
+}
+
+//Queues all of data, or nothing and returns 0 if it doesn't fit
+int RingBuffer_Write(RingBuffer* ringBuffer, const void* data, int size);
+//Copies size queued bytes starting offset bytes past the head without consuming them
+void RingBuffer_Peek(const RingBuffer* ringBuffer, int offset, void* out, int size);
+void RingBuffer_Consume(RingBuffer* ringBuffer, int size);
+
+//Contiguous free bytes after the tail, fill some and RingBuffer_Commit them
+unsigned char* RingBuffer_WriteSpan(RingBuffer* ringBuffer, int* size);
+void RingBuffer_Commit(RingBuffer* ringBuffer, int size);
+//Contiguous queued bytes at the head, RingBuffer_Consume what was used
+const unsigned char* RingBuffer_ReadSpan(const RingBuffer* ringBuffer, int* size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "evaluate.h"
+
+const int pieceValues[KING+1] = { [PAWN] = 100, [KNIGHT] = 320, [BISHOP] = 330, [ROOK] = 500, [QUEEN] = 900, [KING] = 20000 };
+
+//Tables are written from white's side with row 0 (rank 8) first, so they index directly by square for white
+//and by square ^ 56 (the mirrored row) for black
+static const int pawnTable[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+     50, 50, 50, 50, 50, 50, 50, 50,
+     10, 10, 20, 30, 30, 20, 10, 10,
+      5,  5, 10, 25, 25, 10,  5,  5,
+      0,  0,  0, 20, 20,  0,  0,  0,
+      5, -5,-10,  0,  0,-10, -5,  5,
+      5, 10, 10,-20,-20, 10, 10,  5,
+      0,  0,  0,  0,  0,  0,  0,  0
+};
+
+static const int knightTable[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50
+};
+
+static const int bishopTable[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20
+};
+
+static const int rookTable[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+      5, 10, 10, 10, 10, 10, 10,  5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+      0,  0,  0,  5,  5,  0,  0,  0
+};
+
+static const int queenTable[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+static const int kingMiddlegameTable[64] = {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20
+};
+
+static const int kingEndgameTable[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+static const int* const pieceTables[KING] = { [PAWN] = pawnTable, [KNIGHT] = knightTable, [BISHOP] = bishopTable, [ROOK] = rookTable, [QUEEN] = queenTable };
+
+//Game phase weight of each piece, 24 with every piece on the board
+static const int phaseWeights[KING+1] = { [KNIGHT] = 1, [BISHOP] = 1, [ROOK] = 2, [QUEEN] = 4 };
+#define PHASE_MAX 24
+
+#define BISHOP_PAIR_BONUS 30
+#define TEMPO_BONUS 10
+
+int Evaluate(const Position* position){
+
+    int score[2] = { 0, 0 };
+    int kingMiddlegame[2], kingEndgame[2];
+    int phase = 0;
+
+    for(int side = WHITE; side <= BLACK; side++){
+
+        int flip = (side == WHITE) ? 0 : 56;
+        Bitboard own = position->sides[side];
+
+        for(int type = PAWN; type < KING; type++){
+            Bitboard pieces = position->pieces[type] & own;
+            const int* table = pieceTables[type];
+            while(pieces){
+                int index = Bitboard_PopLSB(&pieces);
+                score[side] += pieceValues[type] + table[index ^ flip];
+                phase += phaseWeights[type];
+            }
+        }
+
+        if(Bitboard_PopCount(position->pieces[BISHOP] & own) >= 2){
+            score[side] += BISHOP_PAIR_BONUS;
+        }
+
+        int king = Bitboard_LSB(position->pieces[KING] & own) ^ flip;
+        kingMiddlegame[side] = kingMiddlegameTable[king];
+        kingEndgame[side] = kingEndgameTable[king];
+
+    }
+
+    if(phase > PHASE_MAX) phase = PHASE_MAX;
+    for(int side = WHITE; side <= BLACK; side++){
+        score[side] += (kingMiddlegame[side] * phase + kingEndgame[side] * (PHASE_MAX - phase)) / PHASE_MAX;
+    }
+
+    int us = position->sideToMove;
+    return score[us] - score[us ^ 1] + TEMPO_BONUS;
+
+}
\ No newline at end of file
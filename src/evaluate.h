@@ -0,0 +1,13 @@
+#ifndef H_EVALUATE
+#define H_EVALUATE
+
+#include "position.h"
+
+//Centipawn values indexed by CHESS_PIECE_TYPE
+extern const int pieceValues[KING+1];
+
+//Static score of the position in centipawns from the side to move's point of view.
+//Material and piece square tables, the king table blends from middlegame to endgame as pieces come off.
+int Evaluate(const Position* position);
+
+#endif
\ No newline at end of file
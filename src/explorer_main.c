@@ -0,0 +1,233 @@
+//Opening explorer over a game archive, answered from a position index instead of replaying the games.
+//
+//  chess_explorer build <archive> <index> [threads] [plies] [memoryMB]  indexes the first plies plies of every game
+//                                                                      (all of them by default)
+//  chess_explorer query <index> [fen]                                  shows the games through the position and every
+//                                                                      move played from it, from the start by default
+//  chess_explorer bench <index> [lookups]                              times lookups of random indexed and missing positions
+//
+//threads defaults to one per core and memoryMB to POSITION_INDEX_DEFAULT_MEMORY_MB. A move's games are the ones through
+//both the position and the one after the move. A game that comes back to the position and leaves it another way
+//counts for both moves, the results shown are those of every game reaching the position after the move.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "position_index.h"
+#include "san.h"
+#include "fen.h"
+#include "movegen.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "platform.h"
+
+#define EXPLORER_LISTED_GAMES 10
+
+typedef struct ExplorerMove{
+    Move move;
+    uint32_t games;            //Games through both the queried position and the one after the move
+    PositionIndexEntry entry;  //Every game that reached the position after it, by any move order
+} ExplorerMove;
+
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t NextRandom(){
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+//Games in both sorted posting lists
+static uint32_t CommonGames(const PositionIndexEntry* a, const PositionIndexEntry* b){
+
+    uint32_t common = 0;
+    uint32_t i = 0, j = 0;
+    uint32_t gameA = a->games > 0 ? PositionIndexEntry_Game(a, 0) : 0;
+    uint32_t gameB = b->games > 0 ? PositionIndexEntry_Game(b, 0) : 0;
+    while(i < a->games && j < b->games){
+        if(gameA <= gameB){
+            common += gameA == gameB;
+            if(++i < a->games) gameA = PositionIndexEntry_Game(a, i);
+        }
+        else if(++j < b->games) gameB = PositionIndexEntry_Game(b, j);
+    }
+    return common;
+
+}
+
+void PrintEntry(const char* label, const PositionIndexEntry* entry){
+    double games = entry->games > 0 ? entry->games : 1;
+    printf("%-8s %9u games  %5.1f%% white  %5.1f%% draw  %5.1f%% black\n", label, entry->games,
+        entry->whiteWins*100.0/games, entry->draws*100.0/games, entry->blackWins*100.0/games);
+}
+
+int Build(int argc, char** argv){
+
+    int threadCount = argc >= 5 ? atoi(argv[4]) : 0;
+    if(threadCount <= 0) threadCount = Platform_ProcessorCount();
+    int maxPlies = argc >= 6 ? atoi(argv[5]) : 0;
+    int memoryMegabytes = argc >= 7 ? atoi(argv[6]) : POSITION_INDEX_DEFAULT_MEMORY_MB;
+
+    GameArchive archive;
+    if(!GameArchive_Open(&archive, argv[2])){
+        printf("Could not open the game archive %s\n", argv[2]);
+        return 1;
+    }
+
+    PositionIndexBuildStats stats;
+    uint64_t start = Platform_TimeNanoseconds();
+    int built = PositionIndex_Build(&archive, argv[3], threadCount, maxPlies, memoryMegabytes, &stats);
+    double seconds = (Platform_TimeNanoseconds() - start) / 1e9;
+    GameArchive_Close(&archive);
+    if(!built){
+        printf("Could not build the index %s\n", argv[3]);
+        return 1;
+    }
+
+    printf("Indexed %llu games (%llu skipped), %llu positions in %d runs\n", (unsigned long long)stats.games,
+        (unsigned long long)stats.skipped, (unsigned long long)stats.positions, stats.runs);
+    printf("%llu distinct positions, %llu game ids, %.1f MB\n", (unsigned long long)stats.keys, (unsigned long long)stats.postings,
+        (POSITION_INDEX_HEADER_SIZE + stats.keys*POSITION_INDEX_KEY_SIZE + stats.postings*POSITION_INDEX_POSTING_SIZE) / 1e6);
+    printf("%.2f s, %.0f games a second\n", seconds, seconds > 0 ? stats.games / seconds : 0.0);
+    return 0;
+
+}
+
+int Query(PositionIndex* index, const char* fen){
+
+    Position position;
+    if(!Position_LoadFen(&position, fen)){
+        printf("Invalid fen: %s\n", fen);
+        return 1;
+    }
+
+    uint64_t start = Platform_TimeNanoseconds();
+    PositionIndexEntry entry;
+    int found = PositionIndex_Find(index, position.hash, &entry);
+
+    //The index holds positions, not moves. The games that played a move from here are in the postings of both this
+    //position and the one after the move, the rest of the second reached it by another move order.
+    MoveList moves;
+    Position_GenerateLegalMoves(&position, &moves);
+    ExplorerMove played[MAX_LEGAL_MOVES];
+    int playedCount = 0;
+    for(int i = 0; found && i < moves.length; i++){
+        Position after = position;
+        PositionUndo undo;
+        Position_MakeMove(&after, moves.moves[i], &undo);
+        if(!PositionIndex_Find(index, after.hash, &played[playedCount].entry)) continue;
+        played[playedCount].games = CommonGames(&entry, &played[playedCount].entry);
+        if(played[playedCount].games == 0) continue;
+        played[playedCount].move = moves.moves[i];
+        playedCount++;
+    }
+    double microseconds = (Platform_TimeNanoseconds() - start) / 1e3;
+
+    if(!found){
+        printf("No indexed game reached this position (%.1f us)\n", microseconds);
+        return 0;
+    }
+    PrintEntry("Position", &entry);
+    printf("Games:");
+    for(uint32_t i = 0; i < entry.games && i < EXPLORER_LISTED_GAMES; i++){
+        printf(" %u", PositionIndexEntry_Game(&entry, i));
+    }
+    printf(entry.games > EXPLORER_LISTED_GAMES ? " ...\n" : "\n");
+
+    //Most played first
+    for(int i = 1; i < playedCount; i++){
+        ExplorerMove move = played[i];
+        int j = i;
+        while(j > 0 && played[j-1].games < move.games){
+            played[j] = played[j-1];
+            j--;
+        }
+        played[j] = move;
+    }
+    if(playedCount > 0) printf("Move     via here | position after the move, every game reaching it\n");
+    for(int i = 0; i < playedCount; i++){
+        char san[SAN_MAX_LENGTH];
+        Position_MoveToSan(&position, played[i].move, san);
+        printf("%-8s %8u | ", san, played[i].games);
+        PrintEntry("", &played[i].entry);
+    }
+    printf("%d lookups in %.1f us\n", moves.length + 1, microseconds);
+    if(index->maxPlies > 0) printf("Only the first %d plies of each game are indexed\n", index->maxPlies);
+    return 0;
+
+}
+
+int Bench(const PositionIndex* index, int lookups){
+
+    if(index->keyCount == 0){
+        printf("The index is empty\n");
+        return 1;
+    }
+
+    //Hashes of indexed positions, picked up front so the timing is only the lookups
+    uint64_t* hashes = (uint64_t*)malloc(sizeof(uint64_t)*lookups);
+    if(hashes == NULL) return 1;
+    for(int i = 0; i < lookups; i++){
+        uint64_t key = NextRandom() % index->keyCount;
+        hashes[i] = ByteOrder_ReadUint64(index->keys + key*POSITION_INDEX_KEY_SIZE);
+    }
+
+    uint64_t checksum = 0;
+    int hits = 0;
+    uint64_t start = Platform_TimeNanoseconds();
+    for(int i = 0; i < lookups; i++){
+        PositionIndexEntry entry;
+        if(PositionIndex_Find(index, hashes[i], &entry)){
+            hits++;
+            checksum += entry.games + PositionIndexEntry_Game(&entry, 0);
+        }
+    }
+    uint64_t hitTime = Platform_TimeNanoseconds() - start;
+
+    int misses = 0;
+    start = Platform_TimeNanoseconds();
+    for(int i = 0; i < lookups; i++){
+        PositionIndexEntry entry;
+        if(!PositionIndex_Find(index, NextRandom(), &entry)) misses++;
+    }
+    uint64_t missTime = Platform_TimeNanoseconds() - start;
+
+    printf("%llu positions, %llu game ids\n", (unsigned long long)index->keyCount, (unsigned long long)index->postingCount);
+    printf("Indexed:  %d of %d found, %.2f us a lookup (checksum %llu)\n", hits, lookups, hitTime / 1e3 / lookups,
+        (unsigned long long)checksum);
+    printf("Missing:  %d of %d missed, %.2f us a lookup\n", misses, lookups, missTime / 1e3 / lookups);
+    free(hashes);
+    return hits == lookups ? 0 : 1;
+
+}
+
+int main(int argc, char** argv){
+
+    int build = argc >= 4 && strcmp(argv[1], "build") == 0;
+    int query = argc >= 3 && strcmp(argv[1], "query") == 0;
+    int bench = argc >= 3 && strcmp(argv[1], "bench") == 0;
+    if(!build && !query && !bench){
+        printf("Usage: %s build <archive> <index> [threads] [plies] [memoryMB]\n", argv[0]);
+        printf("       %s query <index> [fen]\n", argv[0]);
+        printf("       %s bench <index> [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    Attacks_Init();
+    Zobrist_Init();
+    if(build) return Build(argc, argv);
+
+    PositionIndex index;
+    if(!PositionIndex_Open(&index, argv[2])){
+        printf("Could not open the position index %s\n", argv[2]);
+        return 1;
+    }
+    int result;
+    if(query) result = Query(&index, argc >= 4 ? argv[3] : FEN_START_POSITION);
+    else result = Bench(&index, argc >= 4 && atoi(argv[3]) > 0 ? atoi(argv[3]) : 1000000);
+    PositionIndex_Close(&index);
+    return result;
+
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "fen.h"
+#include "attacks.h"
+#include "movegen.h"
+#include "zobrist.h"
+
+static int PieceTypeFromChar(char c){
+    switch(c | 0x20){ //lower case
+        case 'p': return PAWN;
+        case 'n': return KNIGHT;
+        case 'b': return BISHOP;
+        case 'r': return ROOK;
+        case 'q': return QUEEN;
+        case 'k': return KING;
+    }
+    return NONE;
+}
+
+static const char* ParseNumber(const char* c, int* value){
+    int result = 0;
+    while(*c >= '0' && *c <= '9'){
+        result = result*10 + (*c - '0');
+        c++;
+    }
+    *value = result;
+    return c;
+}
+
+int Position_LoadFen(Position* position, const char* fen){
+
+    Position_Clear(position);
+    const char* c = fen;
+
+    //Placement, fen starts at the eighth rank which is row 0 of the board
+    int index = 0;
+    while(*c && *c != ' '){
+        if(*c == '/'){
+            if(index % 8 != 0) return 0;
+        }
+        else if(*c >= '1' && *c <= '8'){
+            index += *c - '0';
+        }
+        else{
+            int type = PieceTypeFromChar(*c);
+            if(type == NONE || index >= 64) return 0;
+            Position_PutPiece(position, index, (*c >= 'a') ? BLACK : WHITE, (enum CHESS_PIECE_TYPE)type);
+            index++;
+        }
+        if(index > 64) return 0;
+        c++;
+    }
+    if(index != 64) return 0;
+
+    //Side to move
+    if(*c++ != ' ') return 0;
+    if(*c == 'w') position->sideToMove = WHITE;
+    else if(*c == 'b') position->sideToMove = BLACK;
+    else return 0;
+    c++;
+
+    //Castling rights
+    if(*c++ != ' ') return 0;
+    if(*c == '-'){
+        c++;
+    }
+    else{
+        while(*c && *c != ' '){
+            switch(*c){
+                case 'K': position->castlingRights |= CASTLE_WHITE_KINGSIDE; break;
+                case 'Q': position->castlingRights |= CASTLE_WHITE_QUEENSIDE; break;
+                case 'k': position->castlingRights |= CASTLE_BLACK_KINGSIDE; break;
+                case 'q': position->castlingRights |= CASTLE_BLACK_QUEENSIDE; break;
+                default: return 0;
+            }
+            c++;
+        }
+    }
+
+    //Drop rights the piece placement can't back up, the generator assumes king and rook are home
+    Bitboard whiteKing = position->pieces[KING] & position->sides[WHITE];
+    Bitboard blackKing = position->pieces[KING] & position->sides[BLACK];
+    Bitboard whiteRooks = position->pieces[ROOK] & position->sides[WHITE];
+    Bitboard blackRooks = position->pieces[ROOK] & position->sides[BLACK];
+    if(!(whiteKing & BITBOARD_SQUARE(60)) || !(whiteRooks & BITBOARD_SQUARE(63))) position->castlingRights &= ~CASTLE_WHITE_KINGSIDE;
+    if(!(whiteKing & BITBOARD_SQUARE(60)) || !(whiteRooks & BITBOARD_SQUARE(56))) position->castlingRights &= ~CASTLE_WHITE_QUEENSIDE;
+    if(!(blackKing & BITBOARD_SQUARE(4)) || !(blackRooks & BITBOARD_SQUARE(7))) position->castlingRights &= ~CASTLE_BLACK_KINGSIDE;
+    if(!(blackKing & BITBOARD_SQUARE(4)) || !(blackRooks & BITBOARD_SQUARE(0))) position->castlingRights &= ~CASTLE_BLACK_QUEENSIDE;
+
+    //En passant square, on the sixth rank when white moves and the third when black does
+    if(*c++ != ' ') return 0;
+    if(*c == '-'){
+        c++;
+    }
+    else{
+        if(c[0] < 'a' || c[0] > 'h' || c[1] != (position->sideToMove == WHITE ? '6' : '3')) return 0;
+        position->enPassantSquare = (unsigned char)((c[0] - 'a') + ('8' - c[1])*8);
+        c += 2;
+    }
+
+    //Optional move counters
+    if(*c == ' '){
+        int halfmove, fullmove;
+        c = ParseNumber(c + 1, &halfmove);
+        position->halfmoveClock = (unsigned char)(halfmove > 255 ? 255 : halfmove);
+        if(*c == ' '){
+            c = ParseNumber(c + 1, &fullmove);
+            position->fullmoveNumber = (unsigned short)(fullmove < 1 ? 1 : fullmove);
+        }
+    }
+
+    if(!Position_IsValid(position)) return 0;
+
+    //The en passant square is kept only if a pawn can really capture there (same rule as Position_MakeMove)
+    if(position->enPassantSquare != NO_SQUARE){
+        enum CHESS_SIDE us = (enum CHESS_SIDE)position->sideToMove;
+        if(!(pawnAttacks[OppositeChessSide(us)][position->enPassantSquare] & position->pieces[PAWN] & position->sides[us])){
+            position->enPassantSquare = NO_SQUARE;
+        }
+    }
+
+    //Position_PutPiece already hashed the pieces, only the state is left
+    position->hash ^= zobristCastling[position->castlingRights];
+    if(position->sideToMove == BLACK) position->hash ^= zobristBlackToMove;
+    if(position->enPassantSquare != NO_SQUARE) position->hash ^= zobristEnPassantFile[position->enPassantSquare % 8];
+    ZOBRIST_DEBUG_CHECK(position->hash, Position_ComputeHash(position));
+
+    return 1;
+
+}
+
+static char* WriteNumber(char* c, int value){
+
+    char digits[8];
+    int count = 0;
+    do{
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    while(value > 0);
+    while(count > 0){
+        *c++ = digits[--count];
+    }
+    return c;
+
+}
+
+int Position_ToFen(const Position* position, char* buffer){
+
+    static const char pieceChars[2][KING+1] = {
+        { ' ', 'P', 'N', 'R', 'B', 'Q', 'K' },
+        { ' ', 'p', 'n', 'r', 'b', 'q', 'k' }
+    };
+
+    char* c = buffer;
+    for(int row = 0; row < 8; row++){
+        int empty = 0;
+        for(int column = 0; column < 8; column++){
+            int index = column + row*8;
+            enum CHESS_PIECE_TYPE type = Position_PieceTypeAt(position, index);
+            if(type == NONE){
+                empty++;
+                continue;
+            }
+            if(empty > 0){
+                *c++ = (char)('0' + empty);
+                empty = 0;
+            }
+            *c++ = pieceChars[Position_PieceSideAt(position, index)][type];
+        }
+        if(empty > 0) *c++ = (char)('0' + empty);
+        if(row < 7) *c++ = '/';
+    }
+
+    *c++ = ' ';
+    *c++ = (position->sideToMove == WHITE) ? 'w' : 'b';
+
+    *c++ = ' ';
+    if(position->castlingRights == 0) *c++ = '-';
+    if(position->castlingRights & CASTLE_WHITE_KINGSIDE) *c++ = 'K';
+    if(position->castlingRights & CASTLE_WHITE_QUEENSIDE) *c++ = 'Q';
+    if(position->castlingRights & CASTLE_BLACK_KINGSIDE) *c++ = 'k';
+    if(position->castlingRights & CASTLE_BLACK_QUEENSIDE) *c++ = 'q';
+
+    *c++ = ' ';
+    if(position->enPassantSquare == NO_SQUARE){
+        *c++ = '-';
+    }
+    else{
+        *c++ = (char)('a' + position->enPassantSquare % 8);
+        *c++ = (char)('8' - position->enPassantSquare / 8);
+    }
+
+    *c++ = ' ';
+    c = WriteNumber(c, position->halfmoveClock);
+    *c++ = ' ';
+    c = WriteNumber(c, position->fullmoveNumber);
+    *c = '\0';
+
+    return (int)(c - buffer);
+
+}
\ No newline at end of file
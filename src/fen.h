@@ -0,0 +1,17 @@
+#ifndef H_FEN
+#define H_FEN
+
+#include "position.h"
+
+#define FEN_START_POSITION "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define FEN_MAX_LENGTH 96 //64 pieces and 7 slashes, the fields after them and the terminator with room to spare
+
+//Loads a position from Forsyth-Edwards Notation. Returns 1 on success, 0 if the string is malformed or the position
+//fails Position_IsValid. Castling rights the placement can't back up are dropped rather than rejected.
+//The move counters are optional, missing ones default to 0 and 1.
+int Position_LoadFen(Position* position, const char* fen);
+//Writes the position as a null terminated fen into buffer, which needs FEN_MAX_LENGTH bytes. Returns the length.
+//The en passant square is only written when a pawn can capture there, as Position keeps it.
+int Position_ToFen(const Position* position, char* buffer);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "game_archive.h"
+#include "byte_order.h"
+#include "fen.h"
+#include "movegen.h"
+#include "platform.h"
+
+#include <string.h>
+
+//Games are small, a bigger stdio buffer turns thousands of them into one write
+#define GAME_ARCHIVE_BUFFER_SIZE (64*1024)
+
+static void WriteHeader(unsigned char* out, const char* magic){
+    memcpy(out, magic, 4);
+    out[4] = GAME_ARCHIVE_VERSION;
+    out[5] = 0;
+    out[6] = 0;
+    out[7] = 0;
+}
+
+static int CheckHeader(const unsigned char* data, uint64_t size, const char* magic){
+    unsigned char header[GAME_ARCHIVE_HEADER_SIZE];
+    WriteHeader(header, magic);
+    return size >= GAME_ARCHIVE_HEADER_SIZE && memcmp(data, header, GAME_ARCHIVE_HEADER_SIZE) == 0;
+}
+
+static int IndexPath(const char* path, char* indexPath){
+    int length = (int)strlen(path);
+    if(length + 7 >= GAME_ARCHIVE_MAX_PATH) return 0;
+    memcpy(indexPath, path, length);
+    memcpy(indexPath + length, ".index", 7);
+    return 1;
+}
+
+//Sets *end to the offset after the record at offset. Returns 0 if the record runs past the end of the data.
+static int RecordEnd(const unsigned char* data, uint64_t size, uint64_t offset, uint64_t* end){
+
+    if(offset < GAME_ARCHIVE_HEADER_SIZE || offset > size || size - offset < GAME_ARCHIVE_RECORD_HEADER_SIZE) return 0;
+    const unsigned char* record = data + offset;
+    uint64_t length = GAME_ARCHIVE_RECORD_HEADER_SIZE + record[4] + (uint64_t)ByteOrder_ReadUint16(record)*2;
+    if(size - offset < length) return 0;
+    *end = offset + length;
+    return 1;
+
+}
+
+//Index entries of records that haven't fully reached the data yet don't count
+static uint64_t CompleteGames(const unsigned char* data, uint64_t dataSize, const unsigned char* index, uint64_t indexSize, uint64_t* dataEnd){
+
+    uint64_t count = (indexSize - GAME_ARCHIVE_HEADER_SIZE) / GAME_ARCHIVE_INDEX_ENTRY_SIZE;
+    *dataEnd = GAME_ARCHIVE_HEADER_SIZE;
+    while(count > 0){
+        uint64_t offset = ByteOrder_ReadUint64(index + GAME_ARCHIVE_HEADER_SIZE + (count - 1)*GAME_ARCHIVE_INDEX_ENTRY_SIZE);
+        if(RecordEnd(data, dataSize, offset, dataEnd)) break;
+        count--;
+    }
+    return count;
+
+}
+
+//A file that isn't there yet maps as empty
+static int MapOrEmpty(const char* path, const unsigned char** data, uint64_t* size){
+
+    if(Platform_MapFile(path, data, size)) return 1;
+    FILE* file = fopen(path, "rb");
+    if(file == NULL) return 1;
+    fclose(file);
+    return 0;
+
+}
+
+static FILE* OpenForAppend(const char* path, uint64_t size, const char* magic){
+
+    FILE* file = fopen(path, "ab");
+    if(file == NULL) return NULL;
+    setvbuf(file, NULL, _IOFBF, GAME_ARCHIVE_BUFFER_SIZE);
+    if(size == 0){
+        unsigned char header[GAME_ARCHIVE_HEADER_SIZE];
+        WriteHeader(header, magic);
+        if(fwrite(header, 1, sizeof(header), file) != sizeof(header)){
+            fclose(file);
+            return NULL;
+        }
+    }
+    return file;
+
+}
+
+int GameArchiveWriter_Open(GameArchiveWriter* writer, const char* path){
+
+    char indexPath[GAME_ARCHIVE_MAX_PATH];
+    if(!IndexPath(path, indexPath)) return 0;
+
+    const unsigned char* data;
+    const unsigned char* index;
+    uint64_t dataSize, indexSize;
+    if(!MapOrEmpty(path, &data, &dataSize)) return 0;
+    if(!MapOrEmpty(indexPath, &index, &indexSize)){
+        Platform_UnmapFile(data, dataSize);
+        return 0;
+    }
+
+    //Either both files are new or both are archive files, games without their index aren't thrown away
+    int valid = (dataSize == 0 && indexSize == 0) || (CheckHeader(data, dataSize, GAME_ARCHIVE_MAGIC)
+        && (indexSize == 0 ? dataSize == GAME_ARCHIVE_HEADER_SIZE : CheckHeader(index, indexSize, GAME_ARCHIVE_INDEX_MAGIC)));
+    uint64_t count = 0;
+    uint64_t dataEnd = dataSize;
+    if(valid && indexSize > 0){
+        count = CompleteGames(data, dataSize, index, indexSize, &dataEnd);
+    }
+    Platform_UnmapFile(data, dataSize);
+    Platform_UnmapFile(index, indexSize);
+    if(!valid) return 0;
+
+    //Cut off what a crash left half written, appending carries on right after the last complete game
+    uint64_t indexEnd = GAME_ARCHIVE_HEADER_SIZE + count*GAME_ARCHIVE_INDEX_ENTRY_SIZE;
+    if(dataSize > dataEnd && !Platform_TruncateFile(path, dataEnd)) return 0;
+    if(indexSize > indexEnd && !Platform_TruncateFile(indexPath, indexEnd)) return 0;
+
+    writer->data = OpenForAppend(path, dataSize, GAME_ARCHIVE_MAGIC);
+    writer->index = writer->data == NULL ? NULL : OpenForAppend(indexPath, indexSize, GAME_ARCHIVE_INDEX_MAGIC);
+    if(writer->index == NULL){
+        if(writer->data != NULL) fclose(writer->data);
+        writer->data = NULL;
+        return 0;
+    }
+    writer->dataSize = dataSize == 0 ? GAME_ARCHIVE_HEADER_SIZE : dataEnd;
+    writer->count = count;
+    writer->failed = 0;
+    return 1;
+
+}
+
+int64_t GameArchiveWriter_Append(GameArchiveWriter* writer, const char* startFen, const unsigned char* moves, int moveCount,
+    enum GAME_RESULT result, enum GAME_END_REASON reason){
+
+    if(writer->failed || moveCount < 0 || moveCount > GAME_ARCHIVE_MAX_MOVES) return -1;
+
+    //The standard start is the common case and isn't stored
+    int fenLength = 0;
+    if(startFen != NULL && strcmp(startFen, FEN_START_POSITION) != 0){
+        fenLength = (int)strlen(startFen);
+        if(fenLength >= FEN_MAX_LENGTH) return -1;
+    }
+
+    unsigned char header[GAME_ARCHIVE_RECORD_HEADER_SIZE];
+    ByteOrder_WriteUint16(header, (uint16_t)moveCount);
+    header[2] = (unsigned char)result;
+    header[3] = (unsigned char)reason;
+    header[4] = (unsigned char)fenLength;
+    header[5] = 0;
+
+    unsigned char entry[GAME_ARCHIVE_INDEX_ENTRY_SIZE];
+    ByteOrder_WriteUint64(entry, writer->dataSize);
+
+    if(fwrite(header, 1, sizeof(header), writer->data) != sizeof(header)
+        || fwrite(startFen, 1, fenLength, writer->data) != (size_t)fenLength
+        || fwrite(moves, 2, moveCount, writer->data) != (size_t)moveCount
+        || fwrite(entry, 1, sizeof(entry), writer->index) != sizeof(entry)){
+        writer->failed = 1;
+        return -1;
+    }
+
+    writer->dataSize += sizeof(header) + fenLength + (uint64_t)moveCount*2;
+    return (int64_t)writer->count++;
+
+}
+
+void GameArchiveWriter_Flush(GameArchiveWriter* writer){
+    //Records ahead of the offsets pointing at them
+    if(fflush(writer->data) != 0 || fflush(writer->index) != 0) writer->failed = 1;
+}
+
+void GameArchiveWriter_Close(GameArchiveWriter* writer){
+
+    if(writer->data == NULL) return;
+    GameArchiveWriter_Flush(writer);
+    fclose(writer->data);
+    fclose(writer->index);
+    writer->data = NULL;
+    writer->index = NULL;
+
+}
+
+int GameArchive_Open(GameArchive* archive, const char* path){
+
+    char indexPath[GAME_ARCHIVE_MAX_PATH];
+    memset(archive, 0, sizeof(GameArchive));
+    if(!IndexPath(path, indexPath)) return 0;
+
+    if(!Platform_MapFile(path, &archive->data, &archive->dataSize)) return 0;
+    if(!Platform_MapFile(indexPath, &archive->index, &archive->indexSize)
+        || !CheckHeader(archive->data, archive->dataSize, GAME_ARCHIVE_MAGIC)
+        || !CheckHeader(archive->index, archive->indexSize, GAME_ARCHIVE_INDEX_MAGIC)){
+        GameArchive_Close(archive);
+        return 0;
+    }
+
+    //A writer can be appending while the archive is read, its last game may not be in the data yet
+    uint64_t dataEnd;
+    archive->count = CompleteGames(archive->data, archive->dataSize, archive->index, archive->indexSize, &dataEnd);
+    return 1;
+
+}
+
+void GameArchive_Close(GameArchive* archive){
+
+    Platform_UnmapFile(archive->data, archive->dataSize);
+    Platform_UnmapFile(archive->index, archive->indexSize);
+    memset(archive, 0, sizeof(GameArchive));
+
+}
+
+int GameArchive_Game(const GameArchive* archive, uint64_t id, ArchivedGame* game){
+
+    if(id >= archive->count) return 0;
+
+    uint64_t offset = ByteOrder_ReadUint64(archive->index + GAME_ARCHIVE_HEADER_SIZE + id*GAME_ARCHIVE_INDEX_ENTRY_SIZE);
+    uint64_t end;
+    if(!RecordEnd(archive->data, archive->dataSize, offset, &end)) return 0;
+
+    const unsigned char* record = archive->data + offset;
+    game->id = id;
+    game->moveCount = (int)ByteOrder_ReadUint16(record);
+    game->result = (enum GAME_RESULT)record[2];
+    game->reason = (enum GAME_END_REASON)record[3];
+    game->startFenLength = record[4];
+    game->startFen = game->startFenLength > 0 ? (const char*)record + GAME_ARCHIVE_RECORD_HEADER_SIZE : NULL;
+    game->moves = record + GAME_ARCHIVE_RECORD_HEADER_SIZE + game->startFenLength;
+    return 1;
+
+}
+
+int ArchivedGame_StartPosition(const ArchivedGame* game, Position* position){
+
+    if(game->startFen == NULL) return Position_LoadFen(position, FEN_START_POSITION);
+    if(game->startFenLength >= FEN_MAX_LENGTH) return 0;
+
+    char fen[FEN_MAX_LENGTH];
+    memcpy(fen, game->startFen, game->startFenLength);
+    fen[game->startFenLength] = '\0';
+    return Position_LoadFen(position, fen);
+
+}
+
+int GameResult_FromPosition(const Position* position, enum GAME_RESULT* result, enum GAME_END_REASON* reason){
+
+    MoveList moveList;
+    Position_GenerateLegalMoves(position, &moveList);
+    if(moveList.length > 0) return 0;
+
+    if(Position_InCheck(position)){
+        *result = position->sideToMove == WHITE ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS;
+        *reason = GAME_END_CHECKMATE;
+    }
+    else{
+        *result = GAME_RESULT_DRAW;
+        *reason = GAME_END_STALEMATE;
+    }
+    return 1;
+
+}
+
+const char* GameResult_ToString(enum GAME_RESULT result){
+    switch(result){
+        case GAME_RESULT_WHITE_WINS: return "1-0";
+        case GAME_RESULT_BLACK_WINS: return "0-1";
+        case GAME_RESULT_DRAW: return "1/2-1/2";
+        default: return "*";
+    }
+}
\ No newline at end of file
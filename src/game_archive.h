@@ -0,0 +1,107 @@
+#ifndef H_GAME_ARCHIVE
+#define H_GAME_ARCHIVE
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "move.h"
+#include "position.h"
+
+//Finished games are appended to an archive made of two files, written once and never changed:
+//
+//  path        the games, one record after another
+//  path.index  the offset of every record in path, 8 bytes each, so game ids are positions in the index
+//
+//Both start with an 8 byte header, a 4 byte magic and a 4 byte version. A record is a 6 byte header (ply count, result,
+//reason, start fen length and a reserved byte), the start fen when the game didn't start from the standard position,
+//then its moves as 2 bytes each in the Move_Encode format. Numbers are little endian so archives move between machines.
+//
+//A record is written to path before its offset goes to path.index. Readers only trust index entries whose record fits
+//in path, and a writer reopening the archive cuts off whatever a crash left half written, so the archive is always a
+//list of complete games.
+//
+//Readers map both files and get games straight out of the mapping, nothing is copied or parsed until it's asked for.
+
+#define GAME_ARCHIVE_MAGIC "TCGA"
+#define GAME_ARCHIVE_INDEX_MAGIC "TCGI"
+#define GAME_ARCHIVE_VERSION 1
+#define GAME_ARCHIVE_HEADER_SIZE 8
+#define GAME_ARCHIVE_RECORD_HEADER_SIZE 6
+#define GAME_ARCHIVE_INDEX_ENTRY_SIZE 8
+#define GAME_ARCHIVE_MAX_MOVES 0xFFFF
+#define GAME_ARCHIVE_MAX_PATH 512
+
+enum GAME_RESULT{
+    GAME_RESULT_UNFINISHED = 0,
+    GAME_RESULT_WHITE_WINS,
+    GAME_RESULT_BLACK_WINS,
+    GAME_RESULT_DRAW
+};
+
+enum GAME_END_REASON{
+    GAME_END_UNKNOWN = 0,
+    GAME_END_CHECKMATE,
+    GAME_END_STALEMATE,
+    GAME_END_RESIGNATION,
+    GAME_END_DRAW_AGREED,
+    GAME_END_ILLEGAL_MOVE,
+    GAME_END_DISCONNECT
+};
+
+typedef struct GameArchiveWriter{
+    FILE* data;
+    FILE* index;
+    uint64_t dataSize;  //Offset the next record goes to
+    uint64_t count;     //Games in the archive, the id the next one gets
+    int failed;         //A write failed part way, dataSize no longer matches the file
+} GameArchiveWriter;
+
+//Opens the archive at path for appending, creating it if it doesn't exist. Returns 1 on success, 0 if the files
+//can't be opened or aren't an archive.
+int GameArchiveWriter_Open(GameArchiveWriter* writer, const char* path);
+//Appends a game of moveCount moves, encoded by Move_Encode. startFen is NULL for the standard start position.
+//Returns the game's id or -1 if it couldn't be written. Once a write has failed every later append returns -1 too,
+//the games would be indexed at the wrong offsets. Opening the archive again cuts off the half written game.
+int64_t GameArchiveWriter_Append(GameArchiveWriter* writer, const char* startFen, const unsigned char* moves, int moveCount,
+    enum GAME_RESULT result, enum GAME_END_REASON reason);
+//Pushes the buffered games to the os, readers opening the archive after this see them. A failure stops further appends.
+void GameArchiveWriter_Flush(GameArchiveWriter* writer);
+void GameArchiveWriter_Close(GameArchiveWriter* writer);
+
+typedef struct GameArchive{
+    const unsigned char* data;
+    uint64_t dataSize;
+    const unsigned char* index;
+    uint64_t indexSize;
+    uint64_t count;
+} GameArchive;
+
+//A game as it lies in the mapping, valid while the archive is open
+typedef struct ArchivedGame{
+    uint64_t id;
+    int moveCount;
+    enum GAME_RESULT result;
+    enum GAME_END_REASON reason;
+    const char* startFen;       //Not terminated, startFenLength chars. NULL for the standard start position
+    int startFenLength;
+    const unsigned char* moves; //moveCount moves of 2 bytes
+} ArchivedGame;
+
+//Maps the archive at path. Returns 1 on success, 0 if it can't be opened or isn't an archive.
+int GameArchive_Open(GameArchive* archive, const char* path);
+void GameArchive_Close(GameArchive* archive);
+//Fills game with the game of that id. Returns 0 if there's no such game or its record is damaged.
+int GameArchive_Game(const GameArchive* archive, uint64_t id, ArchivedGame* game);
+//Sets position to where the game started. Returns 0 if the stored fen doesn't load.
+int ArchivedGame_StartPosition(const ArchivedGame* game, Position* position);
+
+static inline Move ArchivedGame_Move(const ArchivedGame* game, int ply){
+    return Move_Decode(game->moves + ply*2);
+}
+
+//Checkmate or stalemate when the side to move has no legal moves. Returns 0 and leaves result and reason alone otherwise.
+int GameResult_FromPosition(const Position* position, enum GAME_RESULT* result, enum GAME_END_REASON* reason);
+//"1-0", "0-1", "1/2-1/2" or "*"
+const char* GameResult_ToString(enum GAME_RESULT result);
+
+#endif
\ No newline at end of file
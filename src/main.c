@@ -2,12 +2,27 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <signal.h>
 
 #include "chess.h"
+#include "position.h"
+#include "movegen.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "fen.h"
+#include "game_archive.h"
+#include "opening_book.h"
+#include "search.h"
+#include "transposition_table.h"
+#include "platform.h"
 #include "data_structures/chess_coord_pool.h"
+#include "data_structures/move_list.h"
 #include "terminal_control.h"
+#include "renderer.h"
+#include "protocol.h"
+#include "data_structures/ring_buffer.h"
 #include "ansi_colors.h"
 
 #include <windows.h>
@@ -17,18 +32,29 @@
 
 #pragma comment (lib, "Ws2_32.lib")
 #define DEFAULT_PORT "27015"
-#define DEFAULT_BUFFER_LEN 256
+#define DEFAULT_SPECTATOR_PORT "27016"
+#define CONSOLE_EVENT_BATCH 64
+
+#define COMPUTER_DEFAULT_TIME_MS 1000
+#define COMPUTER_TABLE_MEGABYTES 64
 
 #define CHECKER_WIDTH 6
 #define CHECKER_HEIGHT 3
 
-#define CHECKER_STRING "      \x1B[1B\x1B[6D      \x1B[1B\x1B[6D      "
-#define PAWN_STRING "  ()  \x1B[1B\x1B[6D  ||  \x1B[1B\x1B[6D [  ] "
-#define KNIGHT_STRING " /``) \x1B[1B\x1B[6D/_- | \x1B[1B\x1B[6D[    ]"
-#define ROOK_STRING "|-||-|\x1B[1B\x1B[6D |  | \x1B[1B\x1B[6D[    ]"
-#define BISHOP_STRING " _()_ \x1B[1B\x1B[6D  ||  \x1B[1B\x1B[6D_[||]_"
-#define QUEEN_STRING " ~**~ \x1B[1B\x1B[6D  ||  \x1B[1B\x1B[6D[    ]"
-#define KING_STRING " -ll- \x1B[1B\x1B[6D  ||  \x1B[1B\x1B[6D[    ]"
+//CHECKER_HEIGHT rows of CHECKER_WIDTH characters for every CHESS_PIECE_TYPE
+static const char* const pieceGlyphs[KING+1][CHECKER_HEIGHT] = {
+    [NONE]   = { "      ", "      ", "      " },
+    [PAWN]   = { "  ()  ", "  ||  ", " [  ] " },
+    [KNIGHT] = { " /``) ", "/_- | ", "[    ]" },
+    [ROOK]   = { "|-||-|", " |  | ", "[    ]" },
+    [BISHOP] = { " _()_ ", "  ||  ", "_[||]_" },
+    [QUEEN]  = { " ~**~ ", "  ||  ", "[    ]" },
+    [KING]   = { " -ll- ", "  ||  ", "[    ]" }
+};
+
+static const char* const pieceNames[KING+1] = {
+    [NONE] = "", [PAWN] = "[PAWN]", [KNIGHT] = "[KNIGHT]", [ROOK] = "[ROOK]", [BISHOP] = "[BISHOP]", [QUEEN] = "[QUEEN]", [KING] = "[KING]"
+};
 
 DWORD baseStdoutMode;
 DWORD baseStdinMode;
@@ -36,18 +62,62 @@ DWORD baseStdinMode;
 int running = 1;
 int networkGame = FALSE;
 int connectionClosedFlag = FALSE;
+int computerGame = FALSE;
+int spectating = FALSE; //Watching a server game, the moves of both sides come from the server
+int serverGame = -1;    //Number of the game on the server, for spectators to ask for
 
 enum CHESS_SIDE side = WHITE;
 enum CHESS_SIDE activeSide = WHITE;
+enum CHESS_SIDE computerSide = BLACK;
+//Local and computer games start here, network games always use the standard position
+const char* startFen = FEN_START_POSITION;
 
 const int AVAILABLE_MOVE_COLOR = ANSI_COLOR_ID_FADED_MAG;
 const int DEFAULT_BLACK = ANSI_COLOR_ID_LIGHT_BLK;
 const int DEFAULT_WHITE = ANSI_COLOR_ID_DARK_WHT;
 
+//How a checker is shown, normal squares take the theme colors for the piece on them
+enum CHECKER_STATE{
+    CHECKER_LIGHT,
+    CHECKER_DARK,
+    CHECKER_CURSOR,
+    CHECKER_AVAILABLE_MOVE,
+    CHECKER_STATE_COUNT
+};
+
+//Ready made cells of every checker, rows of CHECKER_WIDTH one after the other. See BuildCheckerCells.
+RenderCell checkerCells[CHECKER_STATE_COUNT][2][KING+1][CHECKER_WIDTH*CHECKER_HEIGHT];
+
 HANDLE wHnd; //Console write handle
 HANDLE rHnd; //Console read handle
 
 BoardState boardState;
+Renderer renderer;
+int renderStats = FALSE;
+int frameRequested = FALSE;
+int resizeRequested = FALSE;
+uint64_t minFrameIntervalNs = 0; //0 draws frames as soon as the events behind them are handled
+uint64_t lastFrameNs = 0;
+uint64_t eventsHandled = 0; //Console input records and peer moves
+uint64_t frameRequests = 0;
+uint64_t framesDrawn = 0;
+Position position; //Authoritative game state, boardState is refreshed from it for drawing
+MoveList legalMoves;
+uint64_t gameHistory[SEARCH_MAX_HISTORY]; //Hashes of the positions before the current one, for the engine's repetition checks
+PositionUndo gameUndo[SEARCH_MAX_HISTORY]; //Undo record of every move played, gameHistoryLength of them
+int gameHistoryLength = 0;
+unsigned char gameMoves[GAME_ARCHIVE_MAX_MOVES*2]; //Every move from the start for the archive, encoded
+int gameMoveCount = 0; //GAME_ARCHIVE_MAX_MOVES + 1 once the game is too long to archive
+const char* gameStartFen = FEN_START_POSITION;
+const char* archivePath = NULL; //Finished games are appended here when set
+enum GAME_RESULT gameResult = GAME_RESULT_UNFINISHED; //How the game ended for the archive, unknown when a player just leaves
+enum GAME_END_REASON gameEndReason = GAME_END_UNKNOWN;
+
+SearchLimits computerLimits;
+TranspositionTable transpositionTable;
+const char* bookPath = NULL; //The computer plays from this opening book while the position is in it
+OpeningBook openingBook;
+uint64_t bookRandomState = 0;
 ChessCoordPool availableMovePool;
 
 int pieceSelected = 0;
@@ -62,32 +132,69 @@ int terminalColumns = 0;
 int terminalRows = 0;
 
 SOCKET peerSocket = INVALID_SOCKET;
+RingBuffer peerIn; //Bytes from the peer that don't make up a whole message yet
+int drawOffered = FALSE;
+int opponentOfferedDraw = FALSE;
+const char* gameOverMessage = NULL; //Printed on exit when the game ended other than by leaving
+char gameOverText[128]; //Backs gameOverMessage when it has to be put together
 
 void RedrawScreen(int terminalColumns, int terminalRows);
-void PrintBoard();
-void PrintInfoBar(int row);
-void PrintChecker(int column, int row, int bgColor, int textColor);
-void PrintAvailableMoveSpaces();
+void RenderFrame();
+void RequestFrame();
+DWORD PresentRequestedFrame();
+void DrawBoard();
+void DrawInfoBar(int row);
+void DrawChecker(int column, int row, enum CHECKER_STATE state);
+void BuildCheckerCells();
+void DrawAvailableMoveSpaces();
 void HandleInput(KEY_EVENT_RECORD keyEvent);
+void GetLegalMoveSpaces(int fromIndex);
+int ApplyPeerMove(Move move);
+void PlayPositionMove(Move move);
+void SetGameResult(enum GAME_RESULT result, enum GAME_END_REASON reason);
+void ArchiveGame();
+void TakeBackMove();
+void PlayComputerMove();
 
 int CalculateBoardStartingColumn(int terminalColumns);
 int CalculateBoardStartingRow(int terminalRows);
-int GetCheckerNormalBGColor(int column, int row);
-int GetCheckerNormalTextColor(int column, int row);
+int GetCheckerNormalBGColor(enum CHESS_SIDE side, enum CHESS_PIECE_TYPE type, int lightSquare);
+int GetCheckerNormalTextColor(enum CHESS_SIDE side, int bgColor);
 int GetCheckerPosX(int column);
 int GetCheckerPosY(int row);
 
-void SetupGame();
-void SetupBoardPieces();
+void SetupGame(const char* fen);
 void LocalGame();
+void ComputerGame();
 void HostGame();
 void JoinGame();
+void JoinServer();
+void WatchGame();
+SOCKET ConnectToHost(const char* port);
+int WaitForMessage(SOCKET socket, ProtocolMessage* message);
 
 void SetupWinsock();
+void RunGameLoop(SOCKET socket);
+void HandleConsoleEvents();
+void HandleSocketEvents(SOCKET socket, WSAEVENT socketEvent);
+void ReceivePeerMessages(SOCKET socket);
+void HandlePeerMessage(const ProtocolMessage* message);
+void SendPeerMessage(int type, const void* payload, int length);
 void ResetConsole();
+void ParseArguments(int argc, char** argv);
 
 int main(int argc, char** argv){
 
+    if(!Renderer_Init(&renderer, 0, 0)){
+        printf("Could not allocate the screen buffers\n");
+        return 1;
+    }
+    BuildCheckerCells();
+    //Before the arguments, checking a --fen position needs the attack tables
+    Attacks_Init();
+    Zobrist_Init();
+    ParseArguments(argc, argv);
+
     wHnd = GetStdHandle(STD_OUTPUT_HANDLE);
     rHnd = GetStdHandle(STD_INPUT_HANDLE);
 
@@ -103,12 +210,15 @@ int main(int argc, char** argv){
     printf("1. Local Game\n");
     printf("2. Host Game\n");
     printf("3. Join Game\n");
+    printf("4. Play vs Computer\n");
+    printf("5. Join Server\n");
+    printf("6. Watch Game\n");
 
     char c = ' ';
     do{
         c = getchar();
     }
-    while(c < 49 || c > 51); //less than 1 and greater than 3 in ascii codes
+    while(c < 49 || c > 54); //less than 1 and greater than 6 in ascii codes
 
     switch(c){
         case '1':
@@ -120,6 +230,15 @@ int main(int argc, char** argv){
         case '3':
             JoinGame();
             break;
+        case '4':
+            ComputerGame();
+            break;
+        case '5':
+            JoinServer();
+            break;
+        case '6':
+            WatchGame();
+            break;
     }
 
     tc_cursor_to_home();
@@ -128,50 +247,125 @@ int main(int argc, char** argv){
     ResetConsole();
     tc_cursor_to_home();
 
-    if(connectionClosedFlag){
+    if(gameOverMessage != NULL){
+        printf("\n%s\n", gameOverMessage);
+    }
+    else if(connectionClosedFlag){
         printf("\nOpponent disconnected :(\n");
     }
+    ArchiveGame();
+
+    if(renderStats && renderer.frames > 0){
+        printf("Events handled: %llu\n", (unsigned long long)eventsHandled);
+        printf("Frame requests: %llu\n", (unsigned long long)frameRequests);
+        printf("Frames drawn: %llu\n", (unsigned long long)framesDrawn);
+        printf("Frames written: %llu\n", (unsigned long long)renderer.frames);
+        printf("Bytes per frame: %.1f\n", (double)renderer.totalBytes / renderer.frames);
+        printf("Writes per frame: %.2f\n", (double)renderer.totalWrites / renderer.frames);
+    }
+    Renderer_Free(&renderer);
 
     return 0;
 
 }
 
-void LocalGame(){
+//  --time <ms>      computer's thinking time per move, 1000 by default
+//  --nodes <count>  stop the computer's search after this many nodes
+//  --depth <plies>  stop the computer's search at this depth
+//  --threads <n>    search threads for the computer, 0 for one per core
+//  --black          play black against the computer
+//  --no-sync        don't wrap frames in synchronized update markers
+//  --fps <n>        draw at most n frames a second, events in between share a frame
+//  --render-stats   print the frame counts and the bytes and writes per frame on exit
+//  --fen "<fen>"    start local and computer games from this position
+//  --archive <path> append the game to this game archive when it ends
+//  --book <path>    let the computer play its opening moves from this opening book
+void ParseArguments(int argc, char** argv){
+
+    memset(&computerLimits, 0, sizeof(computerLimits));
+    computerLimits.timeMs = COMPUTER_DEFAULT_TIME_MS;
+    computerLimits.threads = 1;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--time") == 0 && i + 1 < argc){
+            computerLimits.timeMs = strtoull(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--nodes") == 0 && i + 1 < argc){
+            computerLimits.nodes = strtoull(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--depth") == 0 && i + 1 < argc){
+            computerLimits.depth = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            computerLimits.threads = atoi(argv[++i]);
+            if(computerLimits.threads <= 0) computerLimits.threads = Platform_ProcessorCount();
+        }
+        else if(strcmp(argv[i], "--black") == 0){
+            computerSide = WHITE;
+        }
+        else if(strcmp(argv[i], "--no-sync") == 0){
+            renderer.synchronizedUpdates = 0;
+        }
+        else if(strcmp(argv[i], "--fps") == 0 && i + 1 < argc){
+            int fps = atoi(argv[++i]);
+            minFrameIntervalNs = fps > 0 ? 1000000000ULL / fps : 0;
+        }
+        else if(strcmp(argv[i], "--render-stats") == 0){
+            renderStats = TRUE;
+        }
+        else if(strcmp(argv[i], "--fen") == 0 && i + 1 < argc){
+            Position checked;
+            startFen = argv[++i];
+            if(!Position_LoadFen(&checked, startFen)){
+                printf("Invalid FEN: %s\n", startFen);
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[i], "--archive") == 0 && i + 1 < argc){
+            archivePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--book") == 0 && i + 1 < argc){
+            bookPath = argv[++i];
+        }
+    }
 
-    SetupGame();
+}
 
-    running = 1;
-    INPUT_RECORD inputRecord;
+void ComputerGame(){
 
-    while(running){
-        
-        long unsigned numberOfEvents;
-        long unsigned eventsRead;
-        numberOfEvents = 0;
-        GetNumberOfConsoleInputEvents(rHnd, &numberOfEvents);
-
-        if(numberOfEvents > 0){
-            for(int i = 0; i < numberOfEvents;i++){
-                ReadConsoleInput(rHnd, &inputRecord, 1, &eventsRead);
-                
-                switch(inputRecord.EventType){
-                    case WINDOW_BUFFER_SIZE_EVENT:
-                        terminalColumns = inputRecord.Event.WindowBufferSizeEvent.dwSize.X;
-                        terminalRows = inputRecord.Event.WindowBufferSizeEvent.dwSize.Y;
-                        boardState.x = CalculateBoardStartingColumn(terminalColumns);
-                        boardState.y = CalculateBoardStartingRow(terminalRows);
-                        RedrawScreen(inputRecord.Event.WindowBufferSizeEvent.dwSize.X, inputRecord.Event.WindowBufferSizeEvent.dwSize.Y);
-                        break;
-                    case KEY_EVENT:
-                        HandleInput(inputRecord.Event.KeyEvent);
-                        break;
-                }
-                
-            }
-        }
+    if(!TranspositionTable_Init(&transpositionTable, COMPUTER_TABLE_MEGABYTES)){
+        printf("Could not allocate the transposition table\n");
+        return;
     }
 
+    //The book is mapped, not read, so even a big one opens at once
+    if(bookPath != NULL && !OpeningBook_Open(&openingBook, bookPath)){
+        printf("Could not open the opening book %s\n", bookPath);
+        TranspositionTable_Free(&transpositionTable);
+        return;
+    }
+    bookRandomState = Platform_TimeNanoseconds() | 1;
+
+    computerGame = TRUE;
+    LocalGame();
+    TranspositionTable_Free(&transpositionTable);
+    OpeningBook_Close(&openingBook);
+
 }
+
+void LocalGame(){
+
+    SetupGame(startFen);
+
+    //The computer opens when the player took black
+    if(computerGame && activeSide == computerSide){
+        PlayComputerMove();
+    }
+
+    RunGameLoop(INVALID_SOCKET);
+
+}
+
 void HostGame(){
 
     SetupWinsock();
@@ -236,113 +430,136 @@ void HostGame(){
     }
 
     printf("Connected to client successfully!\n");
-    SetupGame();
+    SetupGame(FEN_START_POSITION);
 
     peerSocket = clientSocket;
     networkGame = TRUE;
-    running = TRUE;
-    INPUT_RECORD inputRecord;
+    RunGameLoop(clientSocket);
 
-    int sendResult, recvResult, selectResult;
-    char sendBuffer[DEFAULT_BUFFER_LEN];
-    ZeroMemory(sendBuffer, DEFAULT_BUFFER_LEN);
-    char recvBuffer[DEFAULT_BUFFER_LEN];
-    ZeroMemory(recvBuffer, DEFAULT_BUFFER_LEN);
+    WSACleanup();
+    closesocket(listenerSocket);
+    closesocket(clientSocket);
 
-    fd_set fdRead;
-    fd_set fdWrite;
+}
+void JoinGame(){
 
-    struct timeval timeInterval;
-    timeInterval.tv_sec = 0;
-    timeInterval.tv_usec = 60;
+    SetupWinsock();
+    side = BLACK;
 
-    while(running){
-        
-        //Console event handling
-        long unsigned numberOfEvents;
-        long unsigned eventsRead;
-        numberOfEvents = 0;
-        GetNumberOfConsoleInputEvents(rHnd, &numberOfEvents);
-        if(numberOfEvents > 0){
-            for(int i = 0; i < numberOfEvents;i++){
-                ReadConsoleInput(rHnd, &inputRecord, 1, &eventsRead);
-                
-                switch(inputRecord.EventType){
-                    case WINDOW_BUFFER_SIZE_EVENT:
-                        terminalColumns = inputRecord.Event.WindowBufferSizeEvent.dwSize.X;
-                        terminalRows = inputRecord.Event.WindowBufferSizeEvent.dwSize.Y;
-                        boardState.x = CalculateBoardStartingColumn(terminalColumns);
-                        boardState.y = CalculateBoardStartingRow(terminalRows);
-                        RedrawScreen(inputRecord.Event.WindowBufferSizeEvent.dwSize.X, inputRecord.Event.WindowBufferSizeEvent.dwSize.Y);
-                        break;
-                    case KEY_EVENT:
-                        HandleInput(inputRecord.Event.KeyEvent);
-                        break;
-                }
-                
-            }
-        }
-        //Console event handling
+    SOCKET connectSocket = ConnectToHost(DEFAULT_PORT);
 
-        //Network handling
-        FD_ZERO(&fdRead);
-        FD_ZERO(&fdWrite);
-        FD_SET(clientSocket, &fdRead);
-        FD_SET(clientSocket, &fdWrite);
+    SetupGame(FEN_START_POSITION);
 
-        if((selectResult = select(0, &fdRead, &fdWrite, NULL, &timeInterval)) == SOCKET_ERROR){
-            printf("Error occured on select(): %d\n", WSAGetLastError());
-            closesocket(clientSocket);
-            WSACleanup();
-            exit(1);
+    peerSocket = connectSocket;
+    networkGame = TRUE;
+    RunGameLoop(connectSocket);
+    
+    closesocket(connectSocket);
+    WSACleanup();
+
+}
+
+//Plays against whoever the headless server pairs us with, the server decides the sides
+void JoinServer(){
+
+    SetupWinsock();
+
+    SOCKET connectSocket = ConnectToHost(DEFAULT_PORT);
+
+    //The side is the first message once we're paired
+    printf("Waiting for an opponent...\n");
+    ProtocolMessage message;
+    uint32_t gameNumber;
+    if(!WaitForMessage(connectSocket, &message) || message.type != MESSAGE_SIDE || !Protocol_DecodeSide(&message, &side, &gameNumber)){
+        printf("Server closed the connection\n");
+        closesocket(connectSocket);
+        WSACleanup();
+        ResetConsole();
+        exit(1);
+    }
+    serverGame = (int)gameNumber;
+
+    SetupGame(FEN_START_POSITION);
+
+    peerSocket = connectSocket;
+    networkGame = TRUE;
+    RunGameLoop(connectSocket);
+
+    closesocket(connectSocket);
+    WSACleanup();
+
+}
+
+//Joins a game on the server as a spectator. The server sends the position the game has reached and then
+//every move as it's played, the keys only move the cursor.
+void WatchGame(){
+
+    SetupWinsock();
+
+    SOCKET connectSocket = ConnectToHost(DEFAULT_SPECTATOR_PORT);
+
+    unsigned int gameNumber = 0;
+    printf("Enter the number of the game to watch: ");
+    if(scanf("%u", &gameNumber) != 1){
+        gameNumber = 0;
+    }
+
+    unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+    unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+    int frameLength = Protocol_Encode(frame, MESSAGE_WATCH, payload, Protocol_EncodeWatch(payload, gameNumber));
+    ProtocolMessage message;
+    message.type = 0;
+    Position watchedPosition;
+    if(send(connectSocket, (const char*)frame, frameLength, 0) != frameLength || !WaitForMessage(connectSocket, &message)
+        || message.type != MESSAGE_POSITION || !Protocol_DecodePosition(&message, &watchedPosition)){
+        if(message.type == MESSAGE_ERROR){
+            printf("%.*s\n", message.length, (const char*)message.payload);
         }
-        if(selectResult > 0){
-            if(FD_ISSET(clientSocket, &fdRead)){
-                //Something to recv
-                ZeroMemory(recvBuffer, DEFAULT_BUFFER_LEN);
-                recvResult = recv(clientSocket, recvBuffer, DEFAULT_BUFFER_LEN, 0);
-                if(recvResult > 0){
-                    //Chess move
-                    
-                    ChessMove *move = (ChessMove*)recvBuffer;
-                    SetBoardPieceType(&boardState, move->fromCol, move->fromRow, NONE);
-                    SetBoardPieceType(&boardState, move->toCol, move->toRow, move->toType);
-                    SetBoardPieceSide(&boardState, move->toCol, move->toRow, move->toSide);
-                    activeSide = OppositeChessSide(activeSide);
-                    PrintBoard();
-                    PrintInfoBar(terminalRows);
-                }
-                else if(recvResult == 0){
-                    connectionClosedFlag = TRUE;
-                    running = FALSE;
-                }
-                else{
-                    printf("Error occured at recv(): %d\n", WSAGetLastError());
-                    closesocket(clientSocket);
-                    WSACleanup();
-                    tc_clear_screen();
-                    tc_reset_style();
-                    ResetConsole();
-                    exit(1);
-                }
-            }
-            if(FD_ISSET(clientSocket, &fdWrite)){
-                //client is available to send to
-            }
+        else{
+            printf("Server closed the connection\n");
         }
-        //Network handling
+        closesocket(connectSocket);
+        WSACleanup();
+        ResetConsole();
+        exit(1);
     }
 
+    SetupGame(FEN_START_POSITION);
+    position = watchedPosition;
+    Position_ToBoardState(&position, &boardState);
+    activeSide = (enum CHESS_SIDE)position.sideToMove;
+    serverGame = (int)gameNumber;
+    spectating = TRUE;
+    RequestFrame();
+
+    peerSocket = connectSocket;
+    RunGameLoop(connectSocket);
+
+    closesocket(connectSocket);
     WSACleanup();
-    closesocket(listenerSocket);
-    closesocket(clientSocket);
 
 }
-void JoinGame(){
 
-    SetupWinsock();
-    side = BLACK;
-    
+//Blocks until the first complete message arrives on a socket that isn't in the game loop yet.
+//Returns 0 if the connection closed first or sent something malformed.
+int WaitForMessage(SOCKET socket, ProtocolMessage* message){
+
+    int result;
+    message->type = 0;
+    while((result = Protocol_Read(&peerIn, message)) == PROTOCOL_INCOMPLETE){
+        int space;
+        unsigned char* span = RingBuffer_WriteSpan(&peerIn, &space);
+        int recvResult = recv(socket, (char*)span, space, 0);
+        if(recvResult <= 0) return 0;
+        RingBuffer_Commit(&peerIn, recvResult);
+    }
+    return result == PROTOCOL_MESSAGE;
+
+}
+
+//Asks for an address and connects to port there, exits if it can't
+SOCKET ConnectToHost(const char* port){
+
     //Flush stdin
     int c;
     while((c=getchar()) != '\n' && c != EOF);
@@ -366,7 +583,7 @@ void JoinGame(){
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;
-    result = getaddrinfo(ipBuffer, DEFAULT_PORT, &hints, &addrResult);
+    result = getaddrinfo(ipBuffer, port, &hints, &addrResult);
     if(result != 0){
         printf("Error at getaddrinfo() ERROR CODE: %d\n", result);
         WSACleanup();
@@ -404,109 +621,246 @@ void JoinGame(){
         exit(1);
     }
 
-    SetupGame();
+    return connectSocket;
 
-    peerSocket = connectSocket;
-    networkGame = TRUE;
-    running = TRUE;
-    INPUT_RECORD inputRecord;
+}
 
-    int sendResult, recvResult, selectResult;
-    char sendBuffer[DEFAULT_BUFFER_LEN];
-    ZeroMemory(sendBuffer, DEFAULT_BUFFER_LEN);
-    char recvBuffer[DEFAULT_BUFFER_LEN];
-    ZeroMemory(recvBuffer, DEFAULT_BUFFER_LEN);
+//Runs the game until it ends, handling console input and the peer's moves when socket is a connection.
+//Blocks until one of them has something, so an idle game uses no cpu.
+void RunGameLoop(SOCKET socket){
 
-    fd_set fdRead;
-    fd_set fdWrite;
+    HANDLE waitHandles[2];
+    DWORD handleCount = 0;
+    waitHandles[handleCount++] = rHnd;
 
-    struct timeval timeInterval;
-    timeInterval.tv_sec = 0;
-    timeInterval.tv_usec = 60;
+    WSAEVENT socketEvent = WSA_INVALID_EVENT;
+    if(socket != INVALID_SOCKET){
+        socketEvent = WSACreateEvent();
+        if(socketEvent == WSA_INVALID_EVENT || WSAEventSelect(socket, socketEvent, FD_READ | FD_CLOSE) == SOCKET_ERROR){
+            printf("Error occured setting up socket events: %d\n", WSAGetLastError());
+            closesocket(socket);
+            WSACleanup();
+            ResetConsole();
+            exit(1);
+        }
+        waitHandles[handleCount++] = socketEvent;
+    }
+
+    //Only runs out early when a frame is being held back by the frame rate cap. Anything requested
+    //before the loop, like the computer's opening move, is drawn first.
+    DWORD timeout = PresentRequestedFrame();
 
+    running = TRUE;
     while(running){
-        
-        //Console event handling
-        long unsigned numberOfEvents;
-        long unsigned eventsRead;
-        numberOfEvents = 0;
-        GetNumberOfConsoleInputEvents(rHnd, &numberOfEvents);
-        if(numberOfEvents > 0){
-            for(int i = 0; i < numberOfEvents;i++){
-                ReadConsoleInput(rHnd, &inputRecord, 1, &eventsRead);
-                
-                switch(inputRecord.EventType){
-                    case WINDOW_BUFFER_SIZE_EVENT:
-                        terminalColumns = inputRecord.Event.WindowBufferSizeEvent.dwSize.X;
-                        terminalRows = inputRecord.Event.WindowBufferSizeEvent.dwSize.Y;
-                        boardState.x = CalculateBoardStartingColumn(terminalColumns);
-                        boardState.y = CalculateBoardStartingRow(terminalRows);
-                        RedrawScreen(inputRecord.Event.WindowBufferSizeEvent.dwSize.X, inputRecord.Event.WindowBufferSizeEvent.dwSize.Y);
-                        break;
-                    case KEY_EVENT:
-                        HandleInput(inputRecord.Event.KeyEvent);
-                        break;
-                }
-                
+
+        if(WaitForMultipleObjects(handleCount, waitHandles, FALSE, timeout) == WAIT_FAILED){
+            printf("Error occured waiting for events: %lu\n", GetLastError());
+            if(socket != INVALID_SOCKET){
+                closesocket(socket);
+                WSACleanup();
             }
+            ResetConsole();
+            exit(1);
+        }
+
+        //Check both, the wait only reports the first signaled handle and typing shouldn't starve the socket
+        if(WaitForSingleObject(rHnd, 0) == WAIT_OBJECT_0){
+            HandleConsoleEvents();
+        }
+        if(running && socketEvent != WSA_INVALID_EVENT && WaitForSingleObject(socketEvent, 0) == WAIT_OBJECT_0){
+            HandleSocketEvents(socket, socketEvent);
         }
-        //Console event handling
 
-        //Network handling
-        FD_ZERO(&fdRead);
-        FD_ZERO(&fdWrite);
-        FD_SET(connectSocket, &fdRead);
-        FD_SET(connectSocket, &fdWrite);
+        //Everything that happened since the last frame shows up in a single one
+        timeout = running ? PresentRequestedFrame() : INFINITE;
+
+    }
+
+    if(socketEvent != WSA_INVALID_EVENT){
+        WSAEventSelect(socket, NULL, 0);
+        WSACloseEvent(socketEvent);
+    }
+
+}
 
-        if((selectResult = select(0, &fdRead, &fdWrite, NULL, &timeInterval)) == SOCKET_ERROR){
-            printf("Error occured on select(): %d\n", WSAGetLastError());
-            closesocket(connectSocket);
+//Reads everything waiting in the console input buffer, which leaves its handle unsignaled again
+void HandleConsoleEvents(){
+
+    INPUT_RECORD inputRecords[CONSOLE_EVENT_BATCH];
+    DWORD numberOfEvents = 0;
+    DWORD eventsRead = 0;
+
+    while(running && GetNumberOfConsoleInputEvents(rHnd, &numberOfEvents) && numberOfEvents > 0){
+
+        if(!ReadConsoleInput(rHnd, inputRecords, CONSOLE_EVENT_BATCH, &eventsRead)) break;
+
+        for(DWORD i = 0; i < eventsRead && running; i++){
+            switch(inputRecords[i].EventType){
+                case WINDOW_BUFFER_SIZE_EVENT:
+                    terminalColumns = inputRecords[i].Event.WindowBufferSizeEvent.dwSize.X;
+                    terminalRows = inputRecords[i].Event.WindowBufferSizeEvent.dwSize.Y;
+                    boardState.x = CalculateBoardStartingColumn(terminalColumns);
+                    boardState.y = CalculateBoardStartingRow(terminalRows);
+                    resizeRequested = TRUE;
+                    RequestFrame();
+                    break;
+                case KEY_EVENT:
+                    HandleInput(inputRecords[i].Event.KeyEvent);
+                    break;
+            }
+            eventsHandled++;
+        }
+
+    }
+
+}
+
+void HandleSocketEvents(SOCKET socket, WSAEVENT socketEvent){
+
+    //Also resets the event
+    WSANETWORKEVENTS networkEvents;
+    if(WSAEnumNetworkEvents(socket, socketEvent, &networkEvents) == SOCKET_ERROR){
+        printf("Error occured at WSAEnumNetworkEvents(): %d\n", WSAGetLastError());
+        closesocket(socket);
+        WSACleanup();
+        ResetConsole();
+        exit(1);
+    }
+
+    //A close can come with the last messages still unread, like a resignation
+    if(networkEvents.lNetworkEvents & (FD_READ | FD_CLOSE)){
+        ReceivePeerMessages(socket);
+    }
+
+    if((networkEvents.lNetworkEvents & FD_CLOSE) && running){
+        connectionClosedFlag = TRUE;
+        running = FALSE;
+    }
+
+}
+
+//Reads until the socket has nothing more and handles every complete message that arrived
+void ReceivePeerMessages(SOCKET socket){
+
+    while(running){
+
+        int space;
+        unsigned char* span = RingBuffer_WriteSpan(&peerIn, &space);
+        int recvResult = recv(socket, (char*)span, space, 0);
+        if(recvResult == 0){
+            connectionClosedFlag = TRUE;
+            running = FALSE;
+            return;
+        }
+        if(recvResult == SOCKET_ERROR){
+            if(WSAGetLastError() == WSAEWOULDBLOCK) return;
+            printf("Error occured at recv(): %d\n", WSAGetLastError());
+            closesocket(socket);
             WSACleanup();
+            tc_cursor_to_home();
+            tc_clear_screen();
+            tc_reset_style();
+            tc_cursor_to_home();
             ResetConsole();
             exit(1);
         }
-        if(selectResult > 0){
-            if(FD_ISSET(connectSocket, &fdRead)){
-                //Something to recv
-                ZeroMemory(recvBuffer, DEFAULT_BUFFER_LEN);
-                recvResult = recv(connectSocket, recvBuffer, DEFAULT_BUFFER_LEN, 0);
-                if(recvResult > 0){
-                    //Chess move
-                    
-                    ChessMove *move = (ChessMove*)recvBuffer;
-                    SetBoardPieceType(&boardState, move->fromCol, move->fromRow, NONE);
-                    SetBoardPieceType(&boardState, move->toCol, move->toRow, move->toType);
-                    SetBoardPieceSide(&boardState, move->toCol, move->toRow, move->toSide);
-                    activeSide = OppositeChessSide(activeSide);
-                    PrintBoard();
-                    PrintInfoBar(terminalRows);
-                    
-                }
-                else if(recvResult == 0){
-                    connectionClosedFlag = TRUE;
+        RingBuffer_Commit(&peerIn, recvResult);
+
+        ProtocolMessage message;
+        int result = PROTOCOL_INCOMPLETE;
+        while(running && (result = Protocol_Read(&peerIn, &message)) == PROTOCOL_MESSAGE){
+            HandlePeerMessage(&message);
+            eventsHandled++;
+        }
+        if(result == PROTOCOL_MALFORMED){
+            gameOverMessage = "Received a malformed message, the game was ended";
+            running = FALSE;
+        }
+
+    }
+
+}
+
+void HandlePeerMessage(const ProtocolMessage* message){
+
+    Move move;
+    int plies;
+    uint64_t hash;
+
+    switch(message->type){
+        case MESSAGE_MOVE:
+            if(!Protocol_DecodeMove(message, &move)){
+                gameOverMessage = "Received a malformed move, the game was ended";
+                running = FALSE;
+                break;
+            }
+            if(!ApplyPeerMove(move)){
+                char moveString[6];
+                Move_ToString(move, moveString);
+                gameOverMessage = gameOverText;
+                if(spectating){
+                    sprintf(gameOverText, "Received an illegal move (%s), stopped watching", moveString);
                     running = FALSE;
+                    break;
                 }
-                else{
-                    printf("Error occured at recv(): %d\n", WSAGetLastError());
-                    closesocket(connectSocket);
-                    WSACleanup();
-                    tc_cursor_to_home();
-                    tc_clear_screen();
-                    tc_reset_style();
-                    tc_cursor_to_home();
-                    ResetConsole();
-                    exit(1);
-                }
+                sprintf(gameOverText, "Opponent sent an illegal move (%s), the game was ended", moveString);
+                SetGameResult(side == WHITE ? GAME_RESULT_WHITE_WINS : GAME_RESULT_BLACK_WINS, GAME_END_ILLEGAL_MOVE);
+                SendPeerMessage(MESSAGE_ERROR, "Illegal move", 12);
+                running = FALSE;
+                break;
             }
-            if(FD_ISSET(connectSocket, &fdWrite)){
-                //client is available to send to
+            activeSide = OppositeChessSide(activeSide);
+            drawOffered = FALSE;
+            RequestFrame();
+            break;
+        case MESSAGE_SYNC:
+            //Sent after every move, both sides have to agree on the position it leads to
+            //Spectators start part way through, they only have the position to compare
+            if(!Protocol_DecodeSync(message, &plies, &hash) || (!spectating && plies != gameHistoryLength) || hash != position.hash){
+                gameOverMessage = "Lost sync with the opponent's board, the game was ended";
+                running = FALSE;
             }
-        }
-        //Network handling
+            break;
+        case MESSAGE_RESIGN:
+            gameOverMessage = spectating ? "A player resigned" : "Opponent resigned, you win!";
+            SetGameResult(side == WHITE ? GAME_RESULT_WHITE_WINS : GAME_RESULT_BLACK_WINS, GAME_END_RESIGNATION);
+            running = FALSE;
+            break;
+        case MESSAGE_DRAW_OFFER:
+            opponentOfferedDraw = TRUE;
+            RequestFrame();
+            break;
+        case MESSAGE_DRAW_ACCEPT:
+            if(drawOffered || spectating){
+                gameOverMessage = "Draw agreed";
+                SetGameResult(GAME_RESULT_DRAW, GAME_END_DRAW_AGREED);
+                running = FALSE;
+            }
+            break;
+        case MESSAGE_ERROR:
+            if(spectating){
+                sprintf(gameOverText, "%.*s", message->length, (const char*)message->payload);
+            }
+            else{
+                sprintf(gameOverText, "Game ended by the opponent or server: %.*s", message->length, (const char*)message->payload);
+            }
+            gameOverMessage = gameOverText;
+            running = FALSE;
+            break;
+    }
+
+}
+
+//Frames and sends one message to the peer, the socket takes small messages whole
+void SendPeerMessage(int type, const void* payload, int length){
+
+    unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+    int frameLength = Protocol_Encode(frame, type, payload, length);
+    if(send(peerSocket, (const char*)frame, frameLength, 0) != frameLength){
+        printf("Error occured at send(): %d", WSAGetLastError());
+        ResetConsole();
+        exit(1);
     }
-    
-    closesocket(connectSocket);
-    WSACleanup();
 
 }
 
@@ -525,6 +879,33 @@ void HandleInput(KEY_EVENT_RECORD keyEvent){
     if(keyEvent.bKeyDown){
 
         switch(keyEvent.wVirtualKeyCode){
+            case VK_BACK:
+                //Take backs would desync the peer's board, local games only
+                if(!networkGame && !spectating && !(computerGame && activeSide == computerSide)){
+                    TakeBackMove();
+                }
+                break;
+            case 'R':
+                if(networkGame){
+                    SendPeerMessage(MESSAGE_RESIGN, NULL, 0);
+                    gameOverMessage = "You resigned";
+                    SetGameResult(side == WHITE ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS, GAME_END_RESIGNATION);
+                    running = FALSE;
+                }
+                break;
+            case 'D':
+                if(networkGame && opponentOfferedDraw){
+                    SendPeerMessage(MESSAGE_DRAW_ACCEPT, NULL, 0);
+                    gameOverMessage = "Draw agreed";
+                    SetGameResult(GAME_RESULT_DRAW, GAME_END_DRAW_AGREED);
+                    running = FALSE;
+                }
+                else if(networkGame && !drawOffered){
+                    SendPeerMessage(MESSAGE_DRAW_OFFER, NULL, 0);
+                    drawOffered = TRUE;
+                    RequestFrame();
+                }
+                break;
             case VK_ESCAPE:
                 tc_clear_screen();
                 tc_cursor_to_home();
@@ -532,59 +913,57 @@ void HandleInput(KEY_EVENT_RECORD keyEvent){
                 break;
             case VK_UP:
                 if(selectedRow - 1 >= 0){
-                    PrintChecker(selectedColumn, selectedRow, GetCheckerNormalBGColor(selectedColumn, selectedRow), GetCheckerNormalTextColor(selectedColumn, selectedRow));
-                    if(pieceSelected) PrintAvailableMoveSpaces();
                     selectedRow--;
-                    PrintChecker(selectedColumn, selectedRow, ANSI_COLOR_ID_FADED_CYN, ANSI_COLOR_ID_BLK);
-                    PrintInfoBar(terminalRows);
+                    RequestFrame();
                 }
                 break;
             case VK_DOWN:
                 if((selectedRow + 1) < 8){
-                    PrintChecker(selectedColumn, selectedRow, GetCheckerNormalBGColor(selectedColumn, selectedRow), GetCheckerNormalTextColor(selectedColumn, selectedRow));
-                    if(pieceSelected) PrintAvailableMoveSpaces();
                     selectedRow++;
-                    PrintChecker(selectedColumn, selectedRow, ANSI_COLOR_ID_FADED_CYN, ANSI_COLOR_ID_BLK);
-                    PrintInfoBar(terminalRows);
+                    RequestFrame();
                 }
                 break;
             case VK_RIGHT:
                 if((selectedColumn + 1) < 8){
-                    PrintChecker(selectedColumn, selectedRow, GetCheckerNormalBGColor(selectedColumn, selectedRow), GetCheckerNormalTextColor(selectedColumn, selectedRow));
-                    if(pieceSelected) PrintAvailableMoveSpaces();
                     selectedColumn++;
-                    PrintChecker(selectedColumn, selectedRow, ANSI_COLOR_ID_FADED_CYN, ANSI_COLOR_ID_BLK);
-                    PrintInfoBar(terminalRows);
+                    RequestFrame();
                 }
                 break;
             case VK_LEFT:
                 if(selectedColumn - 1 >= 0){
-                    PrintChecker(selectedColumn, selectedRow, GetCheckerNormalBGColor(selectedColumn, selectedRow), GetCheckerNormalTextColor(selectedColumn, selectedRow));
-                    if(pieceSelected) PrintAvailableMoveSpaces();
                     selectedColumn--;
-                    PrintChecker(selectedColumn, selectedRow, ANSI_COLOR_ID_FADED_CYN, ANSI_COLOR_ID_BLK);
-                    PrintInfoBar(terminalRows);
+                    RequestFrame();
                 }
                 break;
             case VK_SPACE:
+                if(spectating){
+                    break;
+                }
                 if(networkGame){
                     if(activeSide != side){
                         break;
                     }
                 }
+                if(computerGame && activeSide == computerSide){
+                    break;
+                }
                 if(!pieceSelected){
                     int currentIndex = GetBoardIndexFromColumnRow(selectedColumn, selectedRow);
                     if(boardState.board[currentIndex].type != NONE){
                         
-                        ChessPiece_GetAvailableMoves(&boardState.board[currentIndex], &boardState, &availableMovePool, selectedColumn, selectedRow);
-                        PrintAvailableMoveSpaces();
+                        if(boardState.board[currentIndex].side == activeSide){
+                            GetLegalMoveSpaces(currentIndex);
+                        }else{
+                            //Opponent's piece, only previewed so its pseudo moves are good enough
+                            ChessPiece_GetAvailableMoves(&boardState.board[currentIndex], &boardState, &availableMovePool, selectedColumn, selectedRow);
+                        }
 
                         pieceSelected = TRUE;
                         selectedPiece = &boardState.board[currentIndex];
                         selectedPieceColumn = selectedColumn;
                         selectedPieceRow = selectedRow;
 
-                        PrintInfoBar(terminalRows);
+                        RequestFrame();
                     }
                 }
                 else{
@@ -594,8 +973,7 @@ void HandleInput(KEY_EVENT_RECORD keyEvent){
                         selectedPiece = NULL;
                         selectedPieceColumn = 0;
                         selectedPieceRow = 0;
-                        PrintBoard();
-                        PrintInfoBar(terminalRows);
+                        RequestFrame();
                     }
 
                     int selectedPieceIndex = GetBoardIndexFromColumnRow(selectedPieceColumn, selectedPieceRow);
@@ -614,35 +992,31 @@ void HandleInput(KEY_EVENT_RECORD keyEvent){
                     }
 
                     if(validMove){
+                        //Pawns reaching the last row always promote to a queen
+                        Move legalMove = Position_MoveFromCoordinates(&position, selectedPieceIndex, currentIndex, QUEEN);
+                        if(networkGame){
+                            unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+                            SendPeerMessage(MESSAGE_MOVE, payload, Protocol_EncodeMove(payload, legalMove));
+                        }
+                        PlayPositionMove(legalMove);
                         if(networkGame){
-                            
-                            ChessMove move;
-                            move.fromCol = selectedPieceColumn;
-                            move.fromRow = selectedPieceRow;
-                            move.toCol = selectedColumn;
-                            move.toRow = selectedRow;
-                            move.toSide = selectedPiece->side;
-                            move.toType = selectedPiece->type;
-
-                            char* moveData = (char*)&move;
-
-                            int sendResult = send(peerSocket, moveData, sizeof(move), 0);
-                            if(sendResult == SOCKET_ERROR){
-                                printf("Error occured at send(): %d", WSAGetLastError());
-                                ResetConsole();
-                                exit(1);
-                            }
+                            unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+                            SendPeerMessage(MESSAGE_SYNC, payload, Protocol_EncodeSync(payload, gameHistoryLength, position.hash));
+                            //Moving on turns down an offered draw
+                            opponentOfferedDraw = FALSE;
                         }
-                        SetBoardPieceType(&boardState, selectedColumn, selectedRow, selectedPiece->type);
-                        SetBoardPieceSide(&boardState, selectedColumn, selectedRow, selectedPiece->side);
-                        SetBoardPieceType(&boardState, selectedPieceColumn, selectedPieceRow, NONE);
                         selectedPiece = NULL;
                         selectedPieceColumn = 0;
                         selectedPieceRow = 0;
                         pieceSelected = FALSE;
                         activeSide = OppositeChessSide(activeSide);
-                        PrintBoard();
-                        PrintInfoBar(terminalRows);
+                        RequestFrame();
+
+                        if(computerGame && activeSide == computerSide){
+                            //Show the move before the search holds up the loop
+                            RenderFrame();
+                            PlayComputerMove();
+                        }
                     }
                 }
                 break;
@@ -653,12 +1027,184 @@ void HandleInput(KEY_EVENT_RECORD keyEvent){
 
 }
 
+//Fills availableMovePool with the legal destinations of the piece on fromIndex
+void GetLegalMoveSpaces(int fromIndex){
+
+    ChessCoordPool_Reset(&availableMovePool);
+    Position_GenerateLegalMoves(&position, &legalMoves);
+
+    for(int i = 0; i < legalMoves.length; i++){
+        Move move = legalMoves.moves[i];
+        if(MOVE_FROM(move) != fromIndex) continue;
+        //The four promotions share a square, only keep one of them
+        if(MOVE_IS_PROMOTION(move) && Move_PromotionType(move) != QUEEN) continue;
+        ChessCoordPool_Add(&availableMovePool, MOVE_TO(move) % 8, MOVE_TO(move) / 8);
+    }
+
+}
+
+//Plays a move received from the peer on the local position and mirrors it into boardState for drawing.
+//Returns 0 without playing it if it isn't the peer's turn or the move isn't legal in our own position.
+//Spectators get the moves of both sides.
+int ApplyPeerMove(Move move){
+
+    if((!spectating && position.sideToMove == side) || !Position_IsLegalMove(&position, move)){
+        return 0;
+    }
+    PlayPositionMove(move);
+    return 1;
+
+}
+
+//Every move on the game position goes through here so the repetition history stays complete
+void PlayPositionMove(Move move){
+
+    if(gameHistoryLength == SEARCH_MAX_HISTORY){
+        //Only the positions since the last capture or pawn move matter for repetitions, which is never more than 100.
+        //Moves older than the kept half can no longer be taken back.
+        memmove(gameHistory, gameHistory + SEARCH_MAX_HISTORY/2, sizeof(uint64_t) * (SEARCH_MAX_HISTORY/2));
+        memmove(gameUndo, gameUndo + SEARCH_MAX_HISTORY/2, sizeof(PositionUndo) * (SEARCH_MAX_HISTORY/2));
+        gameHistoryLength = SEARCH_MAX_HISTORY/2;
+    }
+    gameHistory[gameHistoryLength] = position.hash;
+
+    Position_MakeMove(&position, move, &gameUndo[gameHistoryLength]);
+    gameHistoryLength++;
+    Position_ToBoardState(&position, &boardState);
+
+    if(gameMoveCount < GAME_ARCHIVE_MAX_MOVES) Move_Encode(move, gameMoves + gameMoveCount*2);
+    if(gameMoveCount <= GAME_ARCHIVE_MAX_MOVES) gameMoveCount++;
+
+}
+
+void SetGameResult(enum GAME_RESULT result, enum GAME_END_REASON reason){
+    gameResult = result;
+    gameEndReason = reason;
+}
+
+//Appends the game to the archive given with --archive. Spectators only saw part of the game and don't keep it.
+void ArchiveGame(){
+
+    if(archivePath == NULL || spectating || gameMoveCount == 0) return;
+
+    if(gameEndReason == GAME_END_UNKNOWN && !GameResult_FromPosition(&position, &gameResult, &gameEndReason)){
+        gameEndReason = networkGame ? GAME_END_DISCONNECT : GAME_END_UNKNOWN;
+    }
+
+    GameArchiveWriter writer;
+    if(!GameArchiveWriter_Open(&writer, archivePath)){
+        printf("Could not open the game archive %s\n", archivePath);
+        return;
+    }
+    int64_t id = GameArchiveWriter_Append(&writer, gameStartFen, gameMoves, gameMoveCount, gameResult, gameEndReason);
+    GameArchiveWriter_Close(&writer);
+    if(id < 0){
+        printf("Could not add the game to %s\n", archivePath);
+    }
+    else{
+        printf("Saved as game %lld of %s\n", (long long)id, archivePath);
+    }
+
+}
+
+//Undoes the last move, or the computer's reply and the player's move before it so it's the player's turn again
+void TakeBackMove(){
+
+    int plies = (computerGame && activeSide != computerSide) ? 2 : 1;
+    if(gameHistoryLength < plies){
+        return;
+    }
+
+    for(int i = 0; i < plies; i++){
+        gameHistoryLength--;
+        Position_UnmakeMove(&position, &gameUndo[gameHistoryLength]);
+        activeSide = OppositeChessSide(activeSide);
+        if(gameMoveCount <= GAME_ARCHIVE_MAX_MOVES) gameMoveCount--;
+    }
+    Position_ToBoardState(&position, &boardState);
+
+    pieceSelected = FALSE;
+    selectedPiece = NULL;
+    selectedPieceColumn = 0;
+    selectedPieceRow = 0;
+    ChessCoordPool_Reset(&availableMovePool);
+    RequestFrame();
+
+}
+
+//Plays a move from the opening book while the position is in it, otherwise searches the game position within
+//computerLimits and plays the best move found. Input waits until it's done.
+void PlayComputerMove(){
+
+    Move move = bookPath != NULL ? OpeningBook_Pick(&openingBook, &position, &bookRandomState) : MOVE_NONE;
+    if(move == MOVE_NONE){
+        SearchResult result;
+        Search_Run(&position, gameHistory, gameHistoryLength, &computerLimits, &transpositionTable, &result);
+        move = result.bestMove;
+    }
+    if(move == MOVE_NONE){
+        //Checkmate or stalemate, nothing to play
+        return;
+    }
+
+    PlayPositionMove(move);
+    activeSide = OppositeChessSide(activeSide);
+    RequestFrame();
+
+}
+
+//Resizing invalidates the renderer so the next frame clears and repaints the whole screen
 void RedrawScreen(int terminalColumns, int terminalRows){
 
-    tc_clear_screen();
-    PrintBoard();
-    PrintInfoBar(terminalRows);
-    tc_hide_cursor();
+    if(!Renderer_Resize(&renderer, terminalColumns, terminalRows)){
+        ResetConsole();
+        exit(1);
+    }
+    RenderFrame();
+
+}
+
+//Draws the whole screen into the back buffer and presents it, only the cells that changed reach the terminal
+void RenderFrame(){
+
+    Renderer_Clear(&renderer);
+    DrawBoard();
+    DrawInfoBar(terminalRows);
+    Renderer_Present(&renderer);
+
+    frameRequested = FALSE;
+    lastFrameNs = Platform_TimeNanoseconds();
+    framesDrawn++;
+
+}
+
+//Marks the screen as out of date, the event loop draws it once it has handled every pending event
+void RequestFrame(){
+    frameRequested = TRUE;
+    frameRequests++;
+}
+
+//Draws the requested frame, applying a pending resize first. If the frame rate cap says it's too soon
+//nothing is drawn and the milliseconds left are returned, otherwise INFINITE.
+DWORD PresentRequestedFrame(){
+
+    if(!frameRequested) return INFINITE;
+
+    if(minFrameIntervalNs > 0){
+        uint64_t elapsed = Platform_TimeNanoseconds() - lastFrameNs;
+        if(elapsed < minFrameIntervalNs){
+            return (DWORD)((minFrameIntervalNs - elapsed + 999999) / 1000000);
+        }
+    }
+
+    if(resizeRequested){
+        resizeRequested = FALSE;
+        RedrawScreen(terminalColumns, terminalRows);
+    }
+    else{
+        RenderFrame();
+    }
+    return INFINITE;
 
 }
 
@@ -670,7 +1216,7 @@ int CalculateBoardStartingRow(int terminalRows){
     return terminalRows/2 - (CHECKER_HEIGHT*8)/2;
 }
 
-void PrintBoard(){
+void DrawBoard(){
 
     int boardColumn = 0, boardRow = 0;
     for(int i = 0; i < 64; i++){
@@ -678,76 +1224,73 @@ void PrintBoard(){
         boardColumn = i % 8;
         boardRow = i / 8;
 
-        int textColor = GetCheckerNormalTextColor(boardColumn, boardRow);
-        int bgColor = GetCheckerNormalBGColor(boardColumn, boardRow);
-
-        if(boardRow == selectedRow && boardColumn == selectedColumn){
-            bgColor = ANSI_COLOR_ID_FADED_CYN;
-        }
-
-        PrintChecker(boardColumn, boardRow, bgColor, textColor);
+        DrawChecker(boardColumn, boardRow, (boardColumn + boardRow) % 2 == 0 ? CHECKER_LIGHT : CHECKER_DARK);
         
     }
 
+    if(pieceSelected) DrawAvailableMoveSpaces();
+    DrawChecker(selectedColumn, selectedRow, CHECKER_CURSOR);
+
     //Print board locations on the side
-    tc_set_text_color(DEFAULT_WHITE);
+    Renderer_SetColors(&renderer, DEFAULT_WHITE, RENDER_COLOR_DEFAULT);
+    char label[2] = { 0, 0 };
     for(int i = 0; i < 8;i++){
         int posX = GetCheckerPosX(-1);
         int posY = GetCheckerPosY(i);
-        tc_set_cursor_position(posX+CHECKER_WIDTH/2, posY+CHECKER_HEIGHT/2);
-        printf("%d", 8-i);
+        Renderer_MoveTo(&renderer, posX+CHECKER_WIDTH/2 - 1, posY+CHECKER_HEIGHT/2 - 1);
+        label[0] = '8' - i;
+        Renderer_Print(&renderer, label);
     }
     for(int i = 0; i < 8;i++){
         int posX = GetCheckerPosX(i);
         int posY = GetCheckerPosY(8);
-        tc_set_cursor_position(posX+CHECKER_WIDTH/2, posY+CHECKER_HEIGHT/2);
-        printf("%c", i+65);
+        Renderer_MoveTo(&renderer, posX+CHECKER_WIDTH/2 - 1, posY+CHECKER_HEIGHT/2 - 1);
+        label[0] = 'A' + i;
+        Renderer_Print(&renderer, label);
     }
 
-    tc_reset_style();
-    tc_hide_cursor();
+}
+
+//Draws the checker at the column and row of the checker board from its prebuilt cells
+void DrawChecker(int column, int row, enum CHECKER_STATE state){
+
+    ChessPiece* piece = &boardState.board[GetBoardIndexFromColumnRow(column, row)];
+
+    //Checker positions are 1 based terminal coordinates, renderer cells start at 0
+    Renderer_Blit(&renderer, GetCheckerPosX(column) - 1, GetCheckerPosY(row) - 1,
+        checkerCells[state][piece->side][piece->type], CHECKER_WIDTH, CHECKER_HEIGHT);
 
 }
 
-//Prints the checker at the column and row of the checker board
-void PrintChecker(int column, int row, int bgColor, int textColor){
+//Fills checkerCells from the glyphs and the theme colors, the board's position doesn't matter since checkers
+//are placed when drawn. Has to run again if any of the colors change.
+void BuildCheckerCells(){
 
-    tc_set_text_color(textColor);
-    tc_set_bg_color(bgColor);
+    for(int state = 0; state < CHECKER_STATE_COUNT; state++){
+        for(int side = WHITE; side <= BLACK; side++){
+            for(int type = NONE; type <= KING; type++){
 
-    tc_set_cursor_position(boardState.x + (column*CHECKER_WIDTH+1), boardState.y + (row*CHECKER_HEIGHT+1));
+                int textColor = ANSI_COLOR_ID_BLK;
+                int bgColor = (state == CHECKER_CURSOR) ? ANSI_COLOR_ID_FADED_CYN : AVAILABLE_MOVE_COLOR;
+                if(state == CHECKER_LIGHT || state == CHECKER_DARK){
+                    bgColor = GetCheckerNormalBGColor(side, type, state == CHECKER_LIGHT);
+                    textColor = GetCheckerNormalTextColor(side, bgColor);
+                }
 
-    int boardIndex = GetBoardIndexFromColumnRow(column, row);
+                RenderCell* cells = checkerCells[state][side][type];
+                for(int line = 0; line < CHECKER_HEIGHT; line++){
+                    for(int i = 0; i < CHECKER_WIDTH; i++){
+                        RenderCell* cell = &cells[line*CHECKER_WIDTH + i];
+                        cell->glyph = pieceGlyphs[type][line][i];
+                        cell->foreground = (unsigned short)textColor;
+                        cell->background = (unsigned short)bgColor;
+                    }
+                }
 
-    switch(boardState.board[boardIndex].type){
-        case NONE:
-            printf(CHECKER_STRING);
-            break;
-        case PAWN:
-            printf(PAWN_STRING);
-            break;
-        case KNIGHT:
-            printf(KNIGHT_STRING);
-            break;
-        case ROOK:
-            printf(ROOK_STRING);
-            break;
-        case BISHOP:
-            printf(BISHOP_STRING);
-            break;
-        case QUEEN:
-            printf(QUEEN_STRING);
-            break;
-        case KING:
-            printf(KING_STRING);
-            break;
-        default:
-            printf(CHECKER_STRING);
+            }
+        }
     }
 
-    tc_reset_style();
-    tc_hide_cursor();
-
 }
 
 int GetCheckerPosX(int column){
@@ -758,42 +1301,29 @@ int GetCheckerPosY(int row){
     return boardState.y + (row*CHECKER_HEIGHT+1);
 }
 
-void PrintAvailableMoveSpaces(){
+void DrawAvailableMoveSpaces(){
 
     for(int i = 0; i < availableMovePool.length; i++){
         ChessCoord coord = availableMovePool.chessCoords[i];
-        PrintChecker(coord.column, coord.row, AVAILABLE_MOVE_COLOR, ANSI_COLOR_ID_BLK);
+        DrawChecker(coord.column, coord.row, CHECKER_AVAILABLE_MOVE);
     }
 
 }
 
-//Return normal bg color for a given square on the board(wether it should be black or white)
-int GetCheckerNormalBGColor(int column, int row){
-
-    int boardIndex = GetBoardIndexFromColumnRow(column, row);
-    ChessPiece piece = boardState.board[boardIndex];
-
-    int bgColor = DEFAULT_BLACK;
+//Return normal bg color for a checker with this piece on a light or dark square
+int GetCheckerNormalBGColor(enum CHESS_SIDE side, enum CHESS_PIECE_TYPE type, int lightSquare){
 
-    if(row%2 ==0){
-        if(column%2 == 0){
-            bgColor = DEFAULT_WHITE;
-        }
-    }else{
-        if(column%2!=0){
-            bgColor = DEFAULT_WHITE;
-        }
-    }
+    int bgColor = lightSquare ? DEFAULT_WHITE : DEFAULT_BLACK;
 
-    if(piece.type == NONE) return bgColor;
+    if(type == NONE) return bgColor;
 
-    if(piece.side == WHITE && bgColor == DEFAULT_BLACK){
+    if(side == WHITE && bgColor == DEFAULT_BLACK){
         bgColor = ANSI_COLOR_ID_LIGHTER_BLK;
     }
-    else if(piece.side == WHITE && bgColor == DEFAULT_WHITE){
+    else if(side == WHITE && bgColor == DEFAULT_WHITE){
         bgColor = DEFAULT_WHITE;
     }
-    else if(piece.side == BLACK && bgColor == DEFAULT_BLACK){
+    else if(side == BLACK && bgColor == DEFAULT_BLACK){
         bgColor = ANSI_COLOR_ID_DARK_BLK;
     }
     else{
@@ -804,132 +1334,81 @@ int GetCheckerNormalBGColor(int column, int row){
 
 }
 
-int GetCheckerNormalTextColor(int column, int row){
+int GetCheckerNormalTextColor(enum CHESS_SIDE side, int bgColor){
 
-    int boardIndex = GetBoardIndexFromColumnRow(column, row);
-    if(boardState.board[boardIndex].side == WHITE) return 231;
-    else if(GetCheckerNormalBGColor(column, row) == ANSI_COLOR_ID_DARKER_WHT) return ANSI_COLOR_ID_BLK;
+    if(side == WHITE) return 231;
+    else if(bgColor == ANSI_COLOR_ID_DARKER_WHT) return ANSI_COLOR_ID_BLK;
     else return ANSI_COLOR_ID_FADED_BLK;
 
 }
 
-void PrintInfoBar(int row){
+void DrawInfoBar(int row){
 
-    tc_set_cursor_position(0, row);
-    printf("%d,%d ", selectedColumn, selectedRow);
+    char coordinates[16];
+    snprintf(coordinates, sizeof(coordinates), "%d,%d ", selectedColumn, selectedRow);
+    Renderer_MoveTo(&renderer, 0, row - 1);
+    Renderer_SetColors(&renderer, RENDER_COLOR_DEFAULT, RENDER_COLOR_DEFAULT);
+    Renderer_Print(&renderer, coordinates);
     
     int currentPieceIndex = GetBoardIndexFromColumnRow(selectedColumn, selectedRow);
     ChessPiece *piece = &boardState.board[currentPieceIndex];
 
     if(piece->type != NONE){
         if(piece->side == WHITE){
-            tc_set_bg_color(ANSI_COLOR_ID_BRIGHT_WHT);
-            tc_set_text_color(ANSI_COLOR_ID_DARK_WHT);
+            Renderer_SetColors(&renderer, ANSI_COLOR_ID_DARK_WHT, ANSI_COLOR_ID_BRIGHT_WHT);
         }else{
-            tc_set_bg_color(ANSI_COLOR_ID_LIGHT_BLK);
-            tc_set_text_color(ANSI_COLOR_ID_LIGHTER_BLK);
-        }
-        switch(piece->type){
-            case PAWN:
-                printf("[PAWN]");
-                break;
-            case KNIGHT:
-                printf("[KNIGHT]");
-                break;
-            case BISHOP:
-                printf("[BISHOP]");
-                break;
-            case ROOK:
-                printf("[ROOK]");
-                break;
-            case QUEEN:
-                printf("[QUEEN]");
-                break;
-            case KING:
-                printf("[KING]");
-                break;
+            Renderer_SetColors(&renderer, ANSI_COLOR_ID_LIGHTER_BLK, ANSI_COLOR_ID_LIGHT_BLK);
         }
-
-        tc_reset_style();
+        Renderer_Print(&renderer, pieceNames[piece->type]);
+        Renderer_SetColors(&renderer, RENDER_COLOR_DEFAULT, RENDER_COLOR_DEFAULT);
     }
 
     if(pieceSelected){
-        printf(" PIECE");
+        Renderer_Print(&renderer, " PIECE");
         if(selectedPiece->side == WHITE){
-            tc_set_bg_color(ANSI_COLOR_ID_BRIGHT_WHT);
-            tc_set_text_color(ANSI_COLOR_ID_DARK_WHT);
+            Renderer_SetColors(&renderer, ANSI_COLOR_ID_DARK_WHT, ANSI_COLOR_ID_BRIGHT_WHT);
         }else{
-            tc_set_bg_color(ANSI_COLOR_ID_LIGHT_BLK);
-            tc_set_text_color(ANSI_COLOR_ID_LIGHTER_BLK);
-        }
-        switch(selectedPiece->type){
-        case PAWN:
-            printf("[PAWN]");
-            break;
-        case KNIGHT:
-            printf("[KNIGHT]");
-            break;
-        case BISHOP:
-            printf("[BISHOP]");
-            break;
-        case ROOK:
-            printf("[ROOK]");
-            break;
-        case QUEEN:
-            printf("[QUEEN]");
-            break;
-        case KING:
-            printf("[KING]");
-            break;
+            Renderer_SetColors(&renderer, ANSI_COLOR_ID_LIGHTER_BLK, ANSI_COLOR_ID_LIGHT_BLK);
         }
+        Renderer_Print(&renderer, pieceNames[selectedPiece->type]);
+        Renderer_SetColors(&renderer, RENDER_COLOR_DEFAULT, RENDER_COLOR_DEFAULT);
     }
 
-    tc_reset_style();
-
-    if(networkGame){
-        printf(" SIDE");
-        if(side == WHITE){
-            tc_set_bg_color(ANSI_COLOR_ID_BRIGHT_WHT);
-            printf("[]");
-        }else{
-            tc_set_bg_color(ANSI_COLOR_ID_LIGHT_BLK);
-            tc_set_text_color(ANSI_COLOR_ID_LIGHTER_BLK);
-            printf("[]");
-        }
+    enum CHESS_SIDE shownSide = networkGame ? side : activeSide;
+    Renderer_Print(&renderer, networkGame ? " SIDE" : " TURN");
+    if(shownSide == WHITE){
+        Renderer_SetColors(&renderer, RENDER_COLOR_DEFAULT, ANSI_COLOR_ID_BRIGHT_WHT);
     }else{
-        printf(" TURN");
-        if(activeSide == WHITE){
-            tc_set_bg_color(ANSI_COLOR_ID_BRIGHT_WHT);
-            printf("[]");
-        }else{
-            tc_set_bg_color(ANSI_COLOR_ID_LIGHT_BLK);
-            tc_set_text_color(ANSI_COLOR_ID_LIGHTER_BLK);
-            printf("[]");
-        }
+        Renderer_SetColors(&renderer, ANSI_COLOR_ID_LIGHTER_BLK, ANSI_COLOR_ID_LIGHT_BLK);
     }
-
-    tc_reset_style();
+    Renderer_Print(&renderer, "[]");
+    Renderer_SetColors(&renderer, RENDER_COLOR_DEFAULT, RENDER_COLOR_DEFAULT);
 
     if(networkGame){
         if(activeSide != side){
-            printf(" OPPONENTS TURN");
+            Renderer_Print(&renderer, " OPPONENTS TURN");
         }else{
-            printf(" YOUR TURN");
+            Renderer_Print(&renderer, " YOUR TURN");
+        }
+        if(opponentOfferedDraw){
+            Renderer_Print(&renderer, " DRAW OFFERED (D TO ACCEPT)");
+        }
+        else if(drawOffered){
+            Renderer_Print(&renderer, " DRAW OFFER SENT");
         }
     }
-
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    GetConsoleScreenBufferInfo(wHnd, &csbi);
-
-    for(int i = csbi.dwCursorPosition.X; i < csbi.dwSize.X; i++){
-        printf(" ");
+    if(computerGame && activeSide == computerSide){
+        Renderer_Print(&renderer, " COMPUTER THINKING");
+    }
+    if(serverGame >= 0){
+        char gameText[32];
+        sprintf(gameText, spectating ? " WATCHING GAME %d" : " GAME %d", serverGame);
+        Renderer_Print(&renderer, gameText);
     }
-
-    tc_hide_cursor();
 
 }
 
-void SetupGame(){
+void SetupGame(const char* fen){
 
     SetConsoleMode(rHnd, ENABLE_WINDOW_INPUT);
     SetConsoleMode(wHnd, 0x0004 | 0x0001);
@@ -962,46 +1441,20 @@ void SetupGame(){
         ChessPiece_Init(&boardState.board[i], side, type);
     }
 
-    SetupBoardPieces();
-
-    tc_cursor_to_home();
-    tc_clear_screen();
-    
-    tc_set_text_color(ANSI_COLOR_ID_BLK);
-    tc_set_bg_color(ANSI_COLOR_ID_WHT);
-
-    PrintBoard(columns, rows);
-    PrintInfoBar(terminalRows);
-
-}
-void SetupBoardPieces(){
-    SetBoardPieceType(&boardState, 0,0, ROOK);
-    SetBoardPieceType(&boardState, 1,0, KNIGHT);
-    SetBoardPieceType(&boardState, 2,0, BISHOP);
-    SetBoardPieceType(&boardState, 3,0, QUEEN);
-    SetBoardPieceType(&boardState, 4,0, KING);
-    SetBoardPieceType(&boardState, 5,0, ROOK);
-    SetBoardPieceType(&boardState, 6,0, KNIGHT);
-    SetBoardPieceType(&boardState, 7,0, BISHOP);
-
-    for(int i=0;i < 8;i++){
-        SetBoardPieceType(&boardState, i,1, PAWN);
+    //--fen is checked when the arguments are read, this only guards against a bad string from elsewhere
+    if(!Position_LoadFen(&position, fen)){
+        fen = FEN_START_POSITION;
+        Position_LoadFen(&position, fen);
     }
+    Position_ToBoardState(&position, &boardState);
+    activeSide = (enum CHESS_SIDE)position.sideToMove;
+    gameHistoryLength = 0;
+    gameMoveCount = 0;
+    gameStartFen = fen;
 
-    for(int i=0;i < 8;i++){
-        SetBoardPieceType(&boardState, i,6, PAWN);
-    }
+    RedrawScreen(columns, rows);
 
-    SetBoardPieceType(&boardState, 0, 7, ROOK);
-    SetBoardPieceType(&boardState, 1, 7, KNIGHT);
-    SetBoardPieceType(&boardState, 2, 7, BISHOP);
-    SetBoardPieceType(&boardState, 3, 7, QUEEN);
-    SetBoardPieceType(&boardState, 4, 7, KING);
-    SetBoardPieceType(&boardState, 5, 7, BISHOP);
-    SetBoardPieceType(&boardState, 6, 7, KNIGHT);
-    SetBoardPieceType(&boardState, 7, 7, ROOK);
 }
-
 void ResetConsole(){
 
     SetConsoleMode(wHnd, baseStdoutMode);
@@ -0,0 +1,20 @@
+#include "move.h"
+
+void Move_ToString(Move move, char* buffer){
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+
+    //Row 0 is the eighth rank
+    buffer[0] = (char)('a' + from % 8);
+    buffer[1] = (char)('8' - from / 8);
+    buffer[2] = (char)('a' + to % 8);
+    buffer[3] = (char)('8' - to / 8);
+    buffer[4] = '\0';
+
+    if(MOVE_IS_PROMOTION(move)){
+        buffer[4] = "nbrq"[MOVE_FLAGS(move) & 3];
+        buffer[5] = '\0';
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef H_MOVE
+#define H_MOVE
+
+#include <stdint.h>
+
+#include "chess.h"
+
+//Moves generated from a Position are packed into 16 bits:
+//bits 0-5 from square, bits 6-11 to square, bits 12-15 flags
+typedef uint16_t Move;
+
+#define MOVE_NONE 0
+
+#define MOVE_FLAG_QUIET 0
+#define MOVE_FLAG_DOUBLE_PUSH 1
+#define MOVE_FLAG_KING_CASTLE 2
+#define MOVE_FLAG_QUEEN_CASTLE 3
+#define MOVE_FLAG_CAPTURE 4
+#define MOVE_FLAG_EN_PASSANT 5
+#define MOVE_FLAG_PROMOTION 8 //Low two bits pick the piece: knight, bishop, rook, queen. Capture bit can be combined
+
+#define MOVE_CREATE(from, to, flags) ((Move)((from) | ((to) << 6) | ((flags) << 12)))
+#define MOVE_FROM(move) ((move) & 0x3F)
+#define MOVE_TO(move) (((move) >> 6) & 0x3F)
+#define MOVE_FLAGS(move) ((move) >> 12)
+
+#define MOVE_IS_CAPTURE(move) (((move) >> 12) & MOVE_FLAG_CAPTURE)
+#define MOVE_IS_PROMOTION(move) (((move) >> 12) & MOVE_FLAG_PROMOTION)
+
+static inline enum CHESS_PIECE_TYPE Move_PromotionType(Move move){
+    static const enum CHESS_PIECE_TYPE promotionTypes[4] = { KNIGHT, BISHOP, ROOK, QUEEN };
+    return promotionTypes[MOVE_FLAGS(move) & 3];
+}
+
+static inline int Move_PromotionFlag(enum CHESS_PIECE_TYPE type){
+    switch(type){
+        case KNIGHT: return MOVE_FLAG_PROMOTION | 0;
+        case BISHOP: return MOVE_FLAG_PROMOTION | 1;
+        case ROOK: return MOVE_FLAG_PROMOTION | 2;
+        default: return MOVE_FLAG_PROMOTION | 3;
+    }
+}
+
+//Moves leave the program as these two bytes, low byte first, so the wire and stored records read the same on any machine
+static inline void Move_Encode(Move move, unsigned char* out){
+    out[0] = (unsigned char)(move & 0xFF);
+    out[1] = (unsigned char)(move >> 8);
+}
+
+static inline Move Move_Decode(const unsigned char* in){
+    return (Move)(in[0] | (in[1] << 8));
+}
+
+//Writes the move in coordinate notation (e2e4, e7e8q), buffer needs room for 6 chars
+void Move_ToString(Move move, char* buffer);
+
+#endif
\ No newline at end of file
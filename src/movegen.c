@@ -0,0 +1,336 @@
+#include "movegen.h"
+#include "attacks.h"
+
+typedef struct CastleRule{
+    int right;
+    int kingFrom;
+    int kingTo;
+    Bitboard mustBeEmpty;
+    Bitboard mustBeSafe; //Squares the king passes over or lands on
+    int flag;
+} CastleRule;
+
+static const CastleRule castleRules[2][2] = {
+    {
+        { CASTLE_WHITE_KINGSIDE, 60, 62, BITBOARD_SQUARE(61) | BITBOARD_SQUARE(62), BITBOARD_SQUARE(61) | BITBOARD_SQUARE(62), MOVE_FLAG_KING_CASTLE },
+        { CASTLE_WHITE_QUEENSIDE, 60, 58, BITBOARD_SQUARE(57) | BITBOARD_SQUARE(58) | BITBOARD_SQUARE(59), BITBOARD_SQUARE(58) | BITBOARD_SQUARE(59), MOVE_FLAG_QUEEN_CASTLE }
+    },
+    {
+        { CASTLE_BLACK_KINGSIDE, 4, 6, BITBOARD_SQUARE(5) | BITBOARD_SQUARE(6), BITBOARD_SQUARE(5) | BITBOARD_SQUARE(6), MOVE_FLAG_KING_CASTLE },
+        { CASTLE_BLACK_QUEENSIDE, 4, 2, BITBOARD_SQUARE(1) | BITBOARD_SQUARE(2) | BITBOARD_SQUARE(3), BITBOARD_SQUARE(2) | BITBOARD_SQUARE(3), MOVE_FLAG_QUEEN_CASTLE }
+    }
+};
+
+Bitboard Position_AttackersTo(const Position* position, int index, Bitboard occupied){
+
+    Bitboard rookLike = position->pieces[ROOK] | position->pieces[QUEEN];
+    Bitboard bishopLike = position->pieces[BISHOP] | position->pieces[QUEEN];
+
+    return (pawnAttacks[BLACK][index] & position->pieces[PAWN] & position->sides[WHITE])
+         | (pawnAttacks[WHITE][index] & position->pieces[PAWN] & position->sides[BLACK])
+         | (knightAttacks[index] & position->pieces[KNIGHT])
+         | (kingAttacks[index] & position->pieces[KING])
+         | (Attacks_Rook(index, occupied) & rookLike)
+         | (Attacks_Bishop(index, occupied) & bishopLike);
+
+}
+
+int Position_IsSquareAttacked(const Position* position, int index, enum CHESS_SIDE bySide){
+    return (Position_AttackersTo(position, index, position->occupied) & position->sides[bySide]) != 0;
+}
+
+int Position_InCheck(const Position* position){
+    enum CHESS_SIDE us = (enum CHESS_SIDE)position->sideToMove;
+    int king = Bitboard_LSB(position->pieces[KING] & position->sides[us]);
+    return Position_IsSquareAttacked(position, king, OppositeChessSide(us));
+}
+
+int Position_IsValid(const Position* position){
+
+    if(position->sideToMove > BLACK || position->castlingRights > CASTLE_ALL || position->enPassantSquare > NO_SQUARE) return 0;
+    Bitboard whiteKing = position->pieces[KING] & position->sides[WHITE];
+    Bitboard blackKing = position->pieces[KING] & position->sides[BLACK];
+    if(Bitboard_PopCount(whiteKing) != 1 || Bitboard_PopCount(blackKing) != 1) return 0;
+    if(position->pieces[PAWN] & (BITBOARD_ROW(0) | BITBOARD_ROW(7))) return 0;
+
+    //The king of the side that just moved can't be in check, the generator would offer to capture it
+    enum CHESS_SIDE us = (enum CHESS_SIDE)position->sideToMove;
+    enum CHESS_SIDE them = OppositeChessSide(us);
+    int theirKing = Bitboard_LSB(position->pieces[KING] & position->sides[them]);
+    if(Position_AttackersTo(position, theirKing, position->occupied) & position->sides[us]) return 0;
+
+    Bitboard whiteRooks = position->pieces[ROOK] & position->sides[WHITE];
+    Bitboard blackRooks = position->pieces[ROOK] & position->sides[BLACK];
+    if((position->castlingRights & (CASTLE_WHITE_KINGSIDE | CASTLE_WHITE_QUEENSIDE)) && !(whiteKing & BITBOARD_SQUARE(60))) return 0;
+    if((position->castlingRights & (CASTLE_BLACK_KINGSIDE | CASTLE_BLACK_QUEENSIDE)) && !(blackKing & BITBOARD_SQUARE(4))) return 0;
+    if((position->castlingRights & CASTLE_WHITE_KINGSIDE) && !(whiteRooks & BITBOARD_SQUARE(63))) return 0;
+    if((position->castlingRights & CASTLE_WHITE_QUEENSIDE) && !(whiteRooks & BITBOARD_SQUARE(56))) return 0;
+    if((position->castlingRights & CASTLE_BLACK_KINGSIDE) && !(blackRooks & BITBOARD_SQUARE(7))) return 0;
+    if((position->castlingRights & CASTLE_BLACK_QUEENSIDE) && !(blackRooks & BITBOARD_SQUARE(0))) return 0;
+
+    //The square a pawn of the other side skipped, empty like the one it started on, with the pawn in front of it
+    if(position->enPassantSquare != NO_SQUARE){
+        int square = position->enPassantSquare;
+        int forward = us == WHITE ? 8 : -8; //Towards the pawn that moved, white moves to lower indices
+        if(square / 8 != (us == WHITE ? 2 : 5)) return 0;
+        if(!(position->pieces[PAWN] & position->sides[them] & BITBOARD_SQUARE(square + forward))) return 0;
+        if(position->occupied & (BITBOARD_SQUARE(square) | BITBOARD_SQUARE(square - forward))) return 0;
+    }
+    return 1;
+
+}
+
+static void AddMoves(MoveList* moveList, int from, Bitboard targets, Bitboard enemies){
+
+    Bitboard captures = targets & enemies;
+    Bitboard quiets = targets & ~enemies;
+    while(captures){
+        MoveList_Add(moveList, MOVE_CREATE(from, Bitboard_PopLSB(&captures), MOVE_FLAG_CAPTURE));
+    }
+    while(quiets){
+        MoveList_Add(moveList, MOVE_CREATE(from, Bitboard_PopLSB(&quiets), MOVE_FLAG_QUIET));
+    }
+
+}
+
+//Adds the four promotions instead when the pawn reaches the last row
+static void AddPawnMove(MoveList* moveList, int from, int to, int flags){
+
+    int toRow = to / 8;
+    if(toRow == 0 || toRow == 7){
+        for(int piece = 0; piece < 4; piece++){
+            MoveList_Add(moveList, MOVE_CREATE(from, to, flags | MOVE_FLAG_PROMOTION | piece));
+        }
+    }
+    else{
+        MoveList_Add(moveList, MOVE_CREATE(from, to, flags));
+    }
+
+}
+
+//capturesOnly leaves out quiet moves and castling but keeps promotions. Inlined into both wrappers below
+//so the flag is a compile time constant in each.
+static inline void GenerateLegalMoves(const Position* position, MoveList* moveList, const int capturesOnly){
+
+    MoveList_Reset(moveList);
+
+    enum CHESS_SIDE us = (enum CHESS_SIDE)position->sideToMove;
+    enum CHESS_SIDE them = OppositeChessSide(us);
+    Bitboard own = position->sides[us];
+    Bitboard enemies = position->sides[them];
+    Bitboard occupied = position->occupied;
+
+    int king = Bitboard_LSB(position->pieces[KING] & own);
+    Bitboard checkers = Position_AttackersTo(position, king, occupied) & enemies;
+
+    //King moves, with the king lifted off the board so it can't step back along a checking ray
+    Bitboard kinglessOccupied = occupied ^ BITBOARD_SQUARE(king);
+    Bitboard kingTargets = kingAttacks[king] & (capturesOnly ? enemies : ~own);
+    while(kingTargets){
+        int to = Bitboard_PopLSB(&kingTargets);
+        if(!(Position_AttackersTo(position, to, kinglessOccupied) & enemies)){
+            MoveList_Add(moveList, MOVE_CREATE(king, to, (enemies & BITBOARD_SQUARE(to)) ? MOVE_FLAG_CAPTURE : MOVE_FLAG_QUIET));
+        }
+    }
+
+    //Double check, only the king can move
+    if(checkers & (checkers - 1)){
+        return;
+    }
+
+    //Every other move has to capture the checker or block its ray
+    Bitboard checkMask = ~BITBOARD_EMPTY;
+    if(checkers){
+        checkMask = betweenMasks[king][Bitboard_LSB(checkers)] | checkers;
+    }
+
+    //A friendly piece alone between the king and an enemy slider is pinned to that line
+    Bitboard rookLike = (position->pieces[ROOK] | position->pieces[QUEEN]) & enemies;
+    Bitboard bishopLike = (position->pieces[BISHOP] | position->pieces[QUEEN]) & enemies;
+    Bitboard snipers = (Attacks_Rook(king, enemies) & rookLike) | (Attacks_Bishop(king, enemies) & bishopLike);
+    Bitboard pinned = BITBOARD_EMPTY;
+    while(snipers){
+        Bitboard blockers = betweenMasks[king][Bitboard_PopLSB(&snipers)] & occupied;
+        if(blockers && !(blockers & (blockers - 1))){
+            pinned |= blockers & own;
+        }
+    }
+
+    if(!checkers && !capturesOnly){
+        for(int i = 0; i < 2; i++){
+            const CastleRule* rule = &castleRules[us][i];
+            if(!(position->castlingRights & rule->right) || (occupied & rule->mustBeEmpty)){
+                continue;
+            }
+            Bitboard safe = rule->mustBeSafe;
+            int attacked = 0;
+            while(safe && !attacked){
+                attacked = (Position_AttackersTo(position, Bitboard_PopLSB(&safe), occupied) & enemies) != 0;
+            }
+            if(!attacked){
+                MoveList_Add(moveList, MOVE_CREATE(rule->kingFrom, rule->kingTo, rule->flag));
+            }
+        }
+    }
+
+    Bitboard targetMask = (capturesOnly ? enemies : ~own) & checkMask;
+    Bitboard promotionRow = (us == WHITE) ? BITBOARD_ROW(0) : BITBOARD_ROW(7);
+
+    //A pinned knight can never stay on its pin line
+    Bitboard knights = position->pieces[KNIGHT] & own & ~pinned;
+    while(knights){
+        int from = Bitboard_PopLSB(&knights);
+        AddMoves(moveList, from, knightAttacks[from] & targetMask, enemies);
+    }
+
+    Bitboard diagonals = (position->pieces[BISHOP] | position->pieces[QUEEN]) & own;
+    while(diagonals){
+        int from = Bitboard_PopLSB(&diagonals);
+        Bitboard targets = Attacks_Bishop(from, occupied) & targetMask;
+        if(pinned & BITBOARD_SQUARE(from)) targets &= lineMasks[king][from];
+        AddMoves(moveList, from, targets, enemies);
+    }
+
+    Bitboard orthogonals = (position->pieces[ROOK] | position->pieces[QUEEN]) & own;
+    while(orthogonals){
+        int from = Bitboard_PopLSB(&orthogonals);
+        Bitboard targets = Attacks_Rook(from, occupied) & targetMask;
+        if(pinned & BITBOARD_SQUARE(from)) targets &= lineMasks[king][from];
+        AddMoves(moveList, from, targets, enemies);
+    }
+
+    //White pawns move towards row 0
+    int forward = (us == WHITE) ? -8 : 8;
+    Bitboard startRow = (us == WHITE) ? BITBOARD_ROW(6) : BITBOARD_ROW(1);
+
+    Bitboard pawns = position->pieces[PAWN] & own;
+    while(pawns){
+
+        int from = Bitboard_PopLSB(&pawns);
+        Bitboard allowed = checkMask;
+        if(pinned & BITBOARD_SQUARE(from)) allowed &= lineMasks[king][from];
+
+        int to = from + forward;
+        if(!(occupied & BITBOARD_SQUARE(to))){
+            if((allowed & BITBOARD_SQUARE(to)) && (!capturesOnly || (promotionRow & BITBOARD_SQUARE(to)))){
+                AddPawnMove(moveList, from, to, MOVE_FLAG_QUIET);
+            }
+            int doubleTo = to + forward;
+            if(!capturesOnly && (startRow & BITBOARD_SQUARE(from)) && !(occupied & BITBOARD_SQUARE(doubleTo)) && (allowed & BITBOARD_SQUARE(doubleTo))){
+                MoveList_Add(moveList, MOVE_CREATE(from, doubleTo, MOVE_FLAG_DOUBLE_PUSH));
+            }
+        }
+
+        Bitboard captures = pawnAttacks[us][from] & enemies & allowed;
+        while(captures){
+            AddPawnMove(moveList, from, Bitboard_PopLSB(&captures), MOVE_FLAG_CAPTURE);
+        }
+
+        //En passant removes two pieces from one row, so check the king's rays directly rather than trusting the pin mask
+        int enPassant = position->enPassantSquare;
+        if(enPassant != NO_SQUARE && (pawnAttacks[us][from] & BITBOARD_SQUARE(enPassant))){
+            int captured = enPassant - forward;
+            if((checkMask & BITBOARD_SQUARE(enPassant)) || (checkers & BITBOARD_SQUARE(captured))){
+                Bitboard after = (occupied ^ BITBOARD_SQUARE(from) ^ BITBOARD_SQUARE(captured)) | BITBOARD_SQUARE(enPassant);
+                if(!(Attacks_Rook(king, after) & rookLike) && !(Attacks_Bishop(king, after) & bishopLike)){
+                    MoveList_Add(moveList, MOVE_CREATE(from, enPassant, MOVE_FLAG_EN_PASSANT));
+                }
+            }
+        }
+
+    }
+
+}
+
+void Position_GenerateLegalMoves(const Position* position, MoveList* moveList){
+    GenerateLegalMoves(position, moveList, 0);
+}
+
+void Position_GenerateLegalCaptures(const Position* position, MoveList* moveList){
+    GenerateLegalMoves(position, moveList, 1);
+}
+
+int Position_IsLegalMove(const Position* position, Move move){
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+
+    enum CHESS_SIDE us = (enum CHESS_SIDE)position->sideToMove;
+    enum CHESS_SIDE them = OppositeChessSide(us);
+    Bitboard own = position->sides[us];
+    Bitboard enemies = position->sides[them];
+    Bitboard occupied = position->occupied;
+    Bitboard toSquare = BITBOARD_SQUARE(to);
+
+    if(!(own & BITBOARD_SQUARE(from)) || (own & toSquare)){
+        return 0;
+    }
+
+    //The generator flags a from/to pair only one way, anything else is a forged or stale move
+    enum CHESS_PIECE_TYPE promotionType = MOVE_IS_PROMOTION(move) ? Move_PromotionType(move) : NONE;
+    if(Position_MoveFromCoordinates(position, from, to, promotionType) != move){
+        return 0;
+    }
+
+    enum CHESS_PIECE_TYPE moving = Position_PieceTypeAt(position, from);
+    int king = Bitboard_LSB(position->pieces[KING] & own);
+
+    if(flags == MOVE_FLAG_KING_CASTLE || flags == MOVE_FLAG_QUEEN_CASTLE){
+        const CastleRule* rule = &castleRules[us][flags == MOVE_FLAG_QUEEN_CASTLE];
+        if(from != rule->kingFrom || to != rule->kingTo || !(position->castlingRights & rule->right) || (occupied & rule->mustBeEmpty)){
+            return 0;
+        }
+        if(Position_AttackersTo(position, king, occupied) & enemies){
+            return 0;
+        }
+        Bitboard safe = rule->mustBeSafe;
+        while(safe){
+            if(Position_AttackersTo(position, Bitboard_PopLSB(&safe), occupied) & enemies) return 0;
+        }
+        return 1;
+    }
+
+    Bitboard reach;
+    Bitboard fromSquare = BITBOARD_SQUARE(from);
+    int captured = to;
+    switch(moving){
+        case PAWN:{
+            //Shifting rather than adding keeps a pawn on the edge row from stepping off the board
+            Bitboard push = ((us == WHITE) ? fromSquare >> 8 : fromSquare << 8) & ~occupied;
+            if(flags == MOVE_FLAG_EN_PASSANT){
+                reach = pawnAttacks[us][from];
+                captured = (us == WHITE) ? to + 8 : to - 8;
+            }
+            else if(MOVE_IS_CAPTURE(move)){
+                reach = pawnAttacks[us][from] & enemies;
+            }
+            else if(flags == MOVE_FLAG_DOUBLE_PUSH){
+                Bitboard startRow = (us == WHITE) ? BITBOARD_ROW(6) : BITBOARD_ROW(1);
+                reach = (fromSquare & startRow) ? ((us == WHITE) ? push >> 8 : push << 8) & ~occupied : BITBOARD_EMPTY;
+            }
+            else{
+                reach = push;
+            }
+            break;
+        }
+        case KNIGHT: reach = knightAttacks[from]; break;
+        case BISHOP: reach = Attacks_Bishop(from, occupied); break;
+        case ROOK: reach = Attacks_Rook(from, occupied); break;
+        case QUEEN: reach = Attacks_Bishop(from, occupied) | Attacks_Rook(from, occupied); break;
+        case KING:
+            //Lifted off the board so it can't step back along a checking ray
+            return (kingAttacks[from] & toSquare) && !(Position_AttackersTo(position, to, occupied ^ fromSquare) & enemies);
+        default: return 0;
+    }
+    if(!(reach & toSquare)){
+        return 0;
+    }
+
+    //Play the move on the occupancy alone and look for anything left attacking the king.
+    //This covers pins, check evasions and the en passant row discovery in one test.
+    Bitboard capturedSquare = BITBOARD_SQUARE(captured);
+    Bitboard after = (occupied & ~fromSquare & ~capturedSquare) | toSquare;
+    return !(Position_AttackersTo(position, king, after) & enemies & ~capturedSquare);
+
+}
\ No newline at end of file
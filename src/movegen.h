@@ -0,0 +1,28 @@
+#ifndef H_MOVEGEN
+#define H_MOVEGEN
+
+#include "position.h"
+#include "move.h"
+#include "data_structures/move_list.h"
+
+//Writes every legal move for the side to move into moveList.
+//Pins and check evasions are resolved while generating, no move is played to test it.
+void Position_GenerateLegalMoves(const Position* position, MoveList* moveList);
+//Only the legal captures and promotions, for quiescence search
+void Position_GenerateLegalCaptures(const Position* position, MoveList* moveList);
+//1 if move is exactly one of the moves Position_GenerateLegalMoves would write, flags included.
+//Checks the one move on its own, for validating moves that arrive from outside without building the list.
+int Position_IsLegalMove(const Position* position, Move move);
+
+//Pieces of both sides attacking a square, with occupied standing in for the board's occupancy
+Bitboard Position_AttackersTo(const Position* position, int index, Bitboard occupied);
+int Position_IsSquareAttacked(const Position* position, int index, enum CHESS_SIDE bySide);
+int Position_InCheck(const Position* position);
+
+//1 if the position is one the move generator can work on: one king a side, no pawns on the first or last rank, the side
+//that just moved not left in check, castling rights only with king and rook at home and an en passant square only
+//on the rank behind an enemy pawn that just moved two squares. Loaders of positions from outside check them with this.
+//A pawn that can capture en passant isn't required, Position_LoadFen drops a square nothing can capture on.
+int Position_IsValid(const Position* position);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,315 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#endif
+
+#include "net.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#pragma comment (lib, "Ws2_32.lib")
+
+#define CloseSocket closesocket
+#define LastErrorWouldBlock() (WSAGetLastError() == WSAEWOULDBLOCK)
+
+static int SetNonBlocking(NetSocket socket){
+    u_long enabled = 1;
+    return ioctlsocket((SOCKET)socket, FIONBIO, &enabled) == 0;
+}
+
+int Net_Init(){
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2,2), &wsaData) == 0;
+}
+
+void Net_Cleanup(){
+    WSACleanup();
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#define CloseSocket close
+#define LastErrorWouldBlock() (errno == EAGAIN || errno == EWOULDBLOCK)
+
+static int SetNonBlocking(NetSocket socket){
+    int flags = fcntl((int)socket, F_GETFL, 0);
+    return flags != -1 && fcntl((int)socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int Net_Init(){
+    //A peer closing mid send shows up as an error from send instead of killing the process
+    signal(SIGPIPE, SIG_IGN);
+    return 1;
+}
+
+void Net_Cleanup(){
+}
+
+#endif
+
+static void SetNoDelay(NetSocket socket){
+    int enabled = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&enabled, sizeof(enabled));
+}
+
+NetSocket Net_Listen(const char* port, int backlog){
+
+    struct addrinfo hints, *addrResult = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_PASSIVE;
+    if(getaddrinfo(NULL, port, &hints, &addrResult) != 0){
+        return NET_INVALID_SOCKET;
+    }
+
+    NetSocket listener = (NetSocket)socket(addrResult->ai_family, addrResult->ai_socktype, addrResult->ai_protocol);
+    if(listener == NET_INVALID_SOCKET){
+        freeaddrinfo(addrResult);
+        return NET_INVALID_SOCKET;
+    }
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    int failed = bind(listener, addrResult->ai_addr, (int)addrResult->ai_addrlen) != 0
+              || listen(listener, backlog) != 0
+              || !SetNonBlocking(listener);
+    freeaddrinfo(addrResult);
+    if(failed){
+        CloseSocket(listener);
+        return NET_INVALID_SOCKET;
+    }
+    return listener;
+
+}
+
+NetSocket Net_Accept(NetSocket listener){
+
+    NetSocket client = (NetSocket)accept(listener, NULL, NULL);
+    if(client == NET_INVALID_SOCKET) return NET_INVALID_SOCKET;
+
+    if(!SetNonBlocking(client)){
+        CloseSocket(client);
+        return NET_INVALID_SOCKET;
+    }
+    SetNoDelay(client);
+    return client;
+
+}
+
+NetSocket Net_Connect(const char* host, const char* port){
+
+    struct addrinfo hints, *addrResult = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    if(getaddrinfo(host, port, &hints, &addrResult) != 0){
+        return NET_INVALID_SOCKET;
+    }
+
+    NetSocket connection = NET_INVALID_SOCKET;
+    for(struct addrinfo* ptr = addrResult; ptr != NULL && connection == NET_INVALID_SOCKET; ptr = ptr->ai_next){
+        connection = (NetSocket)socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+        if(connection == NET_INVALID_SOCKET) continue;
+        if(connect(connection, ptr->ai_addr, (int)ptr->ai_addrlen) != 0 || !SetNonBlocking(connection)){
+            CloseSocket(connection);
+            connection = NET_INVALID_SOCKET;
+        }
+    }
+    freeaddrinfo(addrResult);
+
+    if(connection != NET_INVALID_SOCKET) SetNoDelay(connection);
+    return connection;
+
+}
+
+void Net_Close(NetSocket socket){
+    CloseSocket(socket);
+}
+
+int Net_Send(NetSocket socket, const void* data, int size){
+    int result = (int)send(socket, (const char*)data, size, 0);
+    if(result >= 0) return result;
+    return LastErrorWouldBlock() ? NET_WOULD_BLOCK : NET_ERROR;
+}
+
+int Net_Recv(NetSocket socket, void* data, int size){
+    int result = (int)recv(socket, (char*)data, size, 0);
+    if(result >= 0) return result;
+    return LastErrorWouldBlock() ? NET_WOULD_BLOCK : NET_ERROR;
+}
+
+#if defined(_WIN32)
+
+static short PollFlags(int events){
+    return (short)(((events & NET_EVENT_READ) ? POLLRDNORM : 0) | ((events & NET_EVENT_WRITE) ? POLLWRNORM : 0));
+}
+
+int NetReactor_Init(NetReactor* reactor, int capacity){
+
+    memset(reactor, 0, sizeof(NetReactor));
+    reactor->pollFds = malloc(sizeof(WSAPOLLFD) * capacity);
+    reactor->pollData = (int*)malloc(sizeof(int) * capacity);
+    reactor->positions = (int*)malloc(sizeof(int) * capacity);
+    if(reactor->pollFds == NULL || reactor->pollData == NULL || reactor->positions == NULL){
+        NetReactor_Free(reactor);
+        return 0;
+    }
+    for(int i = 0; i < capacity; i++) reactor->positions[i] = -1;
+    reactor->capacity = capacity;
+    return 1;
+
+}
+
+void NetReactor_Free(NetReactor* reactor){
+    free(reactor->pollFds);
+    free(reactor->pollData);
+    free(reactor->positions);
+    memset(reactor, 0, sizeof(NetReactor));
+}
+
+int NetReactor_Add(NetReactor* reactor, NetSocket socket, int events, int data){
+
+    if(data < 0 || data >= reactor->capacity || reactor->positions[data] != -1) return 0;
+
+    WSAPOLLFD* pollFd = &((WSAPOLLFD*)reactor->pollFds)[reactor->count];
+    pollFd->fd = (SOCKET)socket;
+    pollFd->events = PollFlags(events);
+    pollFd->revents = 0;
+    reactor->pollData[reactor->count] = data;
+    reactor->positions[data] = reactor->count++;
+    return 1;
+
+}
+
+int NetReactor_Modify(NetReactor* reactor, NetSocket socket, int events, int data){
+    (void)socket;
+    if(data < 0 || data >= reactor->capacity || reactor->positions[data] == -1) return 0;
+    ((WSAPOLLFD*)reactor->pollFds)[reactor->positions[data]].events = PollFlags(events);
+    return 1;
+}
+
+//Moves the last entry into the hole so the registered sockets stay packed
+void NetReactor_Remove(NetReactor* reactor, NetSocket socket, int data){
+
+    (void)socket;
+    if(data < 0 || data >= reactor->capacity || reactor->positions[data] == -1) return;
+
+    WSAPOLLFD* pollFds = (WSAPOLLFD*)reactor->pollFds;
+    int position = reactor->positions[data];
+    int last = --reactor->count;
+    pollFds[position] = pollFds[last];
+    reactor->pollData[position] = reactor->pollData[last];
+    reactor->positions[reactor->pollData[position]] = position;
+    reactor->positions[data] = -1;
+
+}
+
+int NetReactor_Wait(NetReactor* reactor, NetEvent* events, int maxEvents, int timeoutMs){
+
+    if(reactor->count == 0) return 0;
+
+    WSAPOLLFD* pollFds = (WSAPOLLFD*)reactor->pollFds;
+    if(WSAPoll(pollFds, (ULONG)reactor->count, timeoutMs) == SOCKET_ERROR) return -1;
+
+    int eventCount = 0;
+    for(int i = 0; i < reactor->count && eventCount < maxEvents; i++){
+        short revents = pollFds[i].revents;
+        if(revents == 0) continue;
+        events[eventCount].data = reactor->pollData[i];
+        events[eventCount].events = ((revents & POLLRDNORM) ? NET_EVENT_READ : 0)
+                                  | ((revents & POLLWRNORM) ? NET_EVENT_WRITE : 0)
+                                  | ((revents & (POLLERR | POLLHUP)) ? NET_EVENT_CLOSED : 0);
+        eventCount++;
+    }
+    return eventCount;
+
+}
+
+#else
+
+static uint32_t EpollFlags(int events){
+    return ((events & NET_EVENT_READ) ? EPOLLIN : 0) | ((events & NET_EVENT_WRITE) ? EPOLLOUT : 0);
+}
+
+int NetReactor_Init(NetReactor* reactor, int capacity){
+
+    memset(reactor, 0, sizeof(NetReactor));
+    reactor->epollFd = epoll_create1(0);
+    reactor->epollEvents = malloc(sizeof(struct epoll_event) * capacity);
+    if(reactor->epollFd == -1 || reactor->epollEvents == NULL){
+        NetReactor_Free(reactor);
+        return 0;
+    }
+    reactor->capacity = capacity;
+    return 1;
+
+}
+
+void NetReactor_Free(NetReactor* reactor){
+    if(reactor->epollFd > 0) close(reactor->epollFd);
+    free(reactor->epollEvents);
+    memset(reactor, 0, sizeof(NetReactor));
+}
+
+static int Control(NetReactor* reactor, int operation, NetSocket socket, int events, int data){
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EpollFlags(events);
+    event.data.u32 = (uint32_t)data;
+    return epoll_ctl(reactor->epollFd, operation, (int)socket, &event) == 0;
+}
+
+int NetReactor_Add(NetReactor* reactor, NetSocket socket, int events, int data){
+    return Control(reactor, EPOLL_CTL_ADD, socket, events, data);
+}
+
+int NetReactor_Modify(NetReactor* reactor, NetSocket socket, int events, int data){
+    return Control(reactor, EPOLL_CTL_MOD, socket, events, data);
+}
+
+void NetReactor_Remove(NetReactor* reactor, NetSocket socket, int data){
+    (void)data;
+    epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, (int)socket, NULL);
+}
+
+int NetReactor_Wait(NetReactor* reactor, NetEvent* events, int maxEvents, int timeoutMs){
+
+    if(maxEvents > reactor->capacity) maxEvents = reactor->capacity;
+
+    struct epoll_event* epollEvents = (struct epoll_event*)reactor->epollEvents;
+    int ready = epoll_wait(reactor->epollFd, epollEvents, maxEvents, timeoutMs);
+    if(ready < 0) return (errno == EINTR) ? 0 : -1;
+
+    for(int i = 0; i < ready; i++){
+        uint32_t flags = epollEvents[i].events;
+        events[i].data = (int)epollEvents[i].data.u32;
+        events[i].events = ((flags & EPOLLIN) ? NET_EVENT_READ : 0)
+                         | ((flags & EPOLLOUT) ? NET_EVENT_WRITE : 0)
+                         | ((flags & (EPOLLERR | EPOLLHUP)) ? NET_EVENT_CLOSED : 0);
+    }
+    return ready;
+
+}
+
+#endif
\ No newline at end of file
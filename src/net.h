@@ -0,0 +1,64 @@
+#ifndef H_NET
+#define H_NET
+
+#include <stdint.h>
+
+//Non blocking TCP sockets and a readiness reactor for the headless server and its benchmark.
+//The reactor is epoll on Linux and WSAPoll on Windows, level triggered on both.
+
+typedef intptr_t NetSocket;
+
+#define NET_INVALID_SOCKET ((NetSocket)-1)
+
+//Net_Send and Net_Recv results besides a byte count
+#define NET_ERROR -1
+#define NET_WOULD_BLOCK -2
+
+#define NET_EVENT_READ 1
+#define NET_EVENT_WRITE 2
+#define NET_EVENT_CLOSED 4 //Hang up or socket error, reading returns why
+
+//Returns 1 on success. Winsock needs this before anything else, elsewhere it only ignores SIGPIPE.
+int Net_Init();
+void Net_Cleanup();
+
+//Non blocking listener on every interface, NET_INVALID_SOCKET on failure
+NetSocket Net_Listen(const char* port, int backlog);
+//Next pending connection made non blocking with Nagle off, NET_INVALID_SOCKET once there are none
+NetSocket Net_Accept(NetSocket listener);
+//Blocking connect to the first address of host that accepts, then made non blocking with Nagle off
+NetSocket Net_Connect(const char* host, const char* port);
+void Net_Close(NetSocket socket);
+
+//Bytes moved, 0 from Net_Recv when the peer closed, otherwise NET_ERROR or NET_WOULD_BLOCK
+int Net_Send(NetSocket socket, const void* data, int size);
+int Net_Recv(NetSocket socket, void* data, int size);
+
+typedef struct NetEvent{
+    int data;   //What the socket was registered with
+    int events; //NET_EVENT_ flags
+} NetEvent;
+
+typedef struct NetReactor{
+    int capacity;
+#if defined(_WIN32)
+    void* pollFds;   //WSAPOLLFD[capacity], registered sockets packed at the front
+    int* pollData;   //data of each pollFds entry
+    int* positions;  //pollFds index of each data value, -1 if not registered
+    int count;
+#else
+    int epollFd;
+    void* epollEvents; //struct epoll_event[capacity] for Wait
+#endif
+} NetReactor;
+
+//Sockets are registered with a data value in [0, capacity) that identifies them in events, one socket per value
+int NetReactor_Init(NetReactor* reactor, int capacity);
+void NetReactor_Free(NetReactor* reactor);
+int NetReactor_Add(NetReactor* reactor, NetSocket socket, int events, int data);
+int NetReactor_Modify(NetReactor* reactor, NetSocket socket, int events, int data);
+void NetReactor_Remove(NetReactor* reactor, NetSocket socket, int data);
+//Waits up to timeoutMs (-1 for ever) for registered sockets to become ready, returns how many events were written or -1
+int NetReactor_Wait(NetReactor* reactor, NetEvent* events, int maxEvents, int timeoutMs);
+
+#endif
\ No newline at end of file
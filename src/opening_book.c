@@ -0,0 +1,387 @@
+#include "opening_book.h"
+#include "byte_order.h"
+#include "movegen.h"
+#include "platform.h"
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Games a task replays, the pool hands tasks out as threads free up so long and short games even out
+#define OPENING_BOOK_GAMES_PER_TASK 1024
+#define OPENING_BOOK_RADIX_BITS 16
+//About this many entries a bucket, the binary search in one stays within a cache line or two
+#define OPENING_BOOK_ENTRIES_PER_BUCKET 4
+#define OPENING_BOOK_MAX_BUCKET_BITS 24
+#define OPENING_BOOK_WRITE_SIZE (1024*1024)
+
+//A move collected from a game and, once sorted and summed up, a move of the book. games is 0 for the slots of games
+//that couldn't be replayed.
+typedef struct BookEntry{
+    uint64_t hash;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t games;
+    uint32_t points;
+} BookEntry;
+
+typedef struct BuildContext{
+    const GameArchive* archive;
+    int maxPlies;
+    BookEntry* entries;
+    const uint64_t* taskOffsets; //Where each task's games go in entries
+    uint64_t* games;             //Per task
+    uint64_t* skipped;
+} BuildContext;
+
+static int GamePlies(const ArchivedGame* game, int maxPlies){
+    return maxPlies > 0 && maxPlies < game->moveCount ? maxPlies : game->moveCount;
+}
+
+//Replays the game into its slots. Returns 0 if it doesn't load or holds an illegal move, its slots are left unused then.
+static int CollectGame(const ArchivedGame* game, int maxPlies, BookEntry* out){
+
+    int plies = GamePlies(game, maxPlies);
+    for(int ply = 0; ply < plies; ply++){
+        out[ply].games = 0;
+    }
+
+    Position position;
+    if(!ArchivedGame_StartPosition(game, &position)) return 0;
+    for(int ply = 0; ply < plies; ply++){
+        Move move = ArchivedGame_Move(game, ply);
+        if(!Position_IsLegalMove(&position, move)){
+            for(int i = 0; i < ply; i++){
+                out[i].games = 0;
+            }
+            return 0;
+        }
+
+        int side = position.sideToMove;
+        out[ply].hash = position.hash;
+        out[ply].move = move;
+        out[ply].games = 1;
+        out[ply].points = game->result == GAME_RESULT_DRAW ? 1
+            : (game->result == GAME_RESULT_WHITE_WINS && side == WHITE) || (game->result == GAME_RESULT_BLACK_WINS && side == BLACK) ? 2 : 0;
+
+        PositionUndo undo;
+        Position_MakeMove(&position, move, &undo);
+    }
+    return 1;
+
+}
+
+static void CollectTask(void* context, int taskIndex, int threadIndex){
+
+    (void)threadIndex;
+    BuildContext* build = (BuildContext*)context;
+    BookEntry* out = build->entries + build->taskOffsets[taskIndex];
+    build->games[taskIndex] = 0;
+    build->skipped[taskIndex] = 0;
+
+    uint64_t first = (uint64_t)taskIndex*OPENING_BOOK_GAMES_PER_TASK;
+    for(uint64_t id = first; id < first + OPENING_BOOK_GAMES_PER_TASK && id < build->archive->count; id++){
+        ArchivedGame game;
+        if(!GameArchive_Game(build->archive, id, &game)){
+            build->skipped[taskIndex]++;
+            continue;
+        }
+        if(CollectGame(&game, build->maxPlies, out)) build->games[taskIndex]++;
+        else build->skipped[taskIndex]++;
+        out += GamePlies(&game, build->maxPlies);
+    }
+
+}
+
+static unsigned RadixDigit(const BookEntry* entry, int pass){
+    if(pass == 0) return entry->move;
+    return (unsigned)(entry->hash >> ((pass - 1)*OPENING_BOOK_RADIX_BITS)) & ((1u << OPENING_BOOK_RADIX_BITS) - 1);
+}
+
+//Least significant digit radix sort by move and then hash, so the moves of a position and the games of a move end up together.
+//Passes where every entry has the same digit are skipped. Returns the sorted array, entries or scratch.
+static BookEntry* SortEntries(BookEntry* entries, BookEntry* scratch, size_t count, size_t* counts){
+
+    for(int pass = 0; count > 0 && pass < 5; pass++){
+
+        memset(counts, 0, sizeof(size_t) << OPENING_BOOK_RADIX_BITS);
+        for(size_t i = 0; i < count; i++){
+            counts[RadixDigit(&entries[i], pass)]++;
+        }
+        if(counts[RadixDigit(&entries[0], pass)] == count) continue;
+
+        size_t offset = 0;
+        for(size_t digit = 0; digit < ((size_t)1 << OPENING_BOOK_RADIX_BITS); digit++){
+            size_t digitCount = counts[digit];
+            counts[digit] = offset;
+            offset += digitCount;
+        }
+        for(size_t i = 0; i < count; i++){
+            scratch[counts[RadixDigit(&entries[i], pass)]++] = entries[i];
+        }
+
+        BookEntry* sorted = scratch;
+        scratch = entries;
+        entries = sorted;
+
+    }
+    return entries;
+
+}
+
+//Sums the games and points of every move of every position into out, dropping moves below minGames games or without
+//points and weighting the rest. Returns the number of book entries.
+static size_t SumMoves(const BookEntry* entries, size_t count, int minGames, BookEntry* out, uint64_t* positions){
+
+    size_t outCount = 0;
+    size_t i = 0;
+    while(i < count){
+
+        uint64_t hash = entries[i].hash;
+        size_t positionStart = outCount;
+        uint64_t heaviest = 0;
+        while(i < count && entries[i].hash == hash){
+            BookEntry move = entries[i];
+            for(i++; i < count && entries[i].hash == hash && entries[i].move == move.move; i++){
+                move.games += entries[i].games;
+                move.points += entries[i].points;
+            }
+            if(move.games < (uint32_t)minGames || move.points == 0) continue;
+            if(move.points > heaviest) heaviest = move.points;
+            out[outCount++] = move;
+        }
+        if(outCount == positionStart) continue;
+        (*positions)++;
+
+        //Heaviest first, a position has few moves
+        for(size_t j = positionStart; j < outCount; j++){
+            uint64_t weight = heaviest > 0xFFFF ? (uint64_t)out[j].points*0xFFFF/heaviest : out[j].points;
+            out[j].weight = (uint16_t)(weight > 0 ? weight : 1);
+            BookEntry move = out[j];
+            size_t k = j;
+            while(k > positionStart && out[k-1].weight < move.weight){
+                out[k] = out[k-1];
+                k--;
+            }
+            out[k] = move;
+        }
+
+    }
+    return outCount;
+
+}
+
+static uint64_t BucketOf(uint64_t hash, int bucketBits){
+    return bucketBits == 0 ? 0 : hash >> (64 - bucketBits);
+}
+
+static int WriteBook(const char* path, const BookEntry* entries, uint64_t count){
+
+    int bucketBits = 0;
+    while(bucketBits < OPENING_BOOK_MAX_BUCKET_BITS && ((uint64_t)OPENING_BOOK_ENTRIES_PER_BUCKET << (bucketBits + 1)) <= count){
+        bucketBits++;
+    }
+
+    unsigned char* buffer = (unsigned char*)malloc(OPENING_BOOK_WRITE_SIZE);
+    FILE* file = fopen(path, "wb");
+    int success = buffer != NULL && file != NULL;
+
+    if(success){
+        memset(buffer, 0, OPENING_BOOK_HEADER_SIZE);
+        memcpy(buffer, OPENING_BOOK_MAGIC, 4);
+        ByteOrder_WriteUint32(buffer + 4, OPENING_BOOK_VERSION);
+        ByteOrder_WriteUint64(buffer + 8, count);
+        ByteOrder_WriteUint32(buffer + 16, (uint32_t)bucketBits);
+        success = fwrite(buffer, 1, OPENING_BOOK_HEADER_SIZE, file) == OPENING_BOOK_HEADER_SIZE;
+    }
+
+    //The first entry of every bucket, and the entry count after the last
+    size_t length = 0;
+    uint64_t entry = 0;
+    for(uint64_t bucket = 0; success && bucket <= ((uint64_t)1 << bucketBits); bucket++){
+        while(entry < count && BucketOf(entries[entry].hash, bucketBits) < bucket) entry++;
+        if(length + OPENING_BOOK_BUCKET_SIZE > OPENING_BOOK_WRITE_SIZE){
+            success = fwrite(buffer, 1, length, file) == length;
+            length = 0;
+        }
+        ByteOrder_WriteUint64(buffer + length, entry);
+        length += OPENING_BOOK_BUCKET_SIZE;
+    }
+
+    for(uint64_t i = 0; success && i < count; i++){
+        if(length + OPENING_BOOK_ENTRY_SIZE > OPENING_BOOK_WRITE_SIZE){
+            success = fwrite(buffer, 1, length, file) == length;
+            length = 0;
+        }
+        unsigned char* out = buffer + length;
+        ByteOrder_WriteUint64(out, entries[i].hash);
+        Move_Encode(entries[i].move, out + 8);
+        ByteOrder_WriteUint16(out + 10, entries[i].weight);
+        ByteOrder_WriteUint32(out + 12, entries[i].games);
+        length += OPENING_BOOK_ENTRY_SIZE;
+    }
+    if(success && length > 0) success = fwrite(buffer, 1, length, file) == length;
+
+    if(file != NULL && fclose(file) != 0) success = 0;
+    if(!success && file != NULL) remove(path);
+    free(buffer);
+    return success;
+
+}
+
+int OpeningBook_Build(const GameArchive* archive, const char* path, int threadCount, int maxPlies, int minGames,
+    OpeningBookBuildStats* stats){
+
+    memset(stats, 0, sizeof(OpeningBookBuildStats));
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+    if(maxPlies < 0) maxPlies = 0;
+    if(minGames < 1) minGames = 1;
+
+    //Every game gets its slots up front, so the tasks fill them in without sharing anything
+    uint64_t taskCount = (archive->count + OPENING_BOOK_GAMES_PER_TASK - 1) / OPENING_BOOK_GAMES_PER_TASK;
+    uint64_t* taskOffsets = (uint64_t*)malloc(sizeof(uint64_t)*(taskCount + 1));
+    if(taskOffsets == NULL) return 0;
+    uint64_t slots = 0;
+    for(uint64_t id = 0; id < archive->count; id++){
+        if(id % OPENING_BOOK_GAMES_PER_TASK == 0) taskOffsets[id / OPENING_BOOK_GAMES_PER_TASK] = slots;
+        ArchivedGame game;
+        if(GameArchive_Game(archive, id, &game)) slots += GamePlies(&game, maxPlies);
+    }
+    taskOffsets[taskCount] = slots;
+
+    BuildContext build;
+    build.archive = archive;
+    build.maxPlies = maxPlies;
+    build.taskOffsets = taskOffsets;
+    build.entries = (BookEntry*)malloc(sizeof(BookEntry)*(slots > 0 ? slots : 1));
+    BookEntry* scratch = (BookEntry*)malloc(sizeof(BookEntry)*(slots > 0 ? slots : 1));
+    size_t* counts = (size_t*)malloc(sizeof(size_t) << OPENING_BOOK_RADIX_BITS);
+    build.games = (uint64_t*)calloc(taskCount > 0 ? taskCount : 1, sizeof(uint64_t));
+    build.skipped = (uint64_t*)calloc(taskCount > 0 ? taskCount : 1, sizeof(uint64_t));
+    int success = build.entries != NULL && scratch != NULL && counts != NULL && build.games != NULL && build.skipped != NULL;
+
+    if(success){
+        ThreadPool_Run(threadCount, (int)taskCount, CollectTask, &build);
+        for(uint64_t i = 0; i < taskCount; i++){
+            stats->games += build.games[i];
+            stats->skipped += build.skipped[i];
+        }
+
+        size_t count = 0;
+        for(uint64_t i = 0; i < slots; i++){
+            if(build.entries[i].games > 0) build.entries[count++] = build.entries[i];
+        }
+        stats->moves = count;
+
+        BookEntry* sorted = SortEntries(build.entries, scratch, count, counts);
+        BookEntry* book = sorted == build.entries ? scratch : build.entries;
+        stats->entries = SumMoves(sorted, count, minGames, book, &stats->positions);
+        success = WriteBook(path, book, stats->entries);
+    }
+
+    free(taskOffsets);
+    free(build.entries);
+    free(scratch);
+    free(counts);
+    free(build.games);
+    free(build.skipped);
+    return success;
+
+}
+
+int OpeningBook_Open(OpeningBook* book, const char* path){
+
+    memset(book, 0, sizeof(OpeningBook));
+    if(!Platform_MapFile(path, &book->data, &book->size)) return 0;
+
+    const unsigned char* header = book->data;
+    if(book->size < OPENING_BOOK_HEADER_SIZE || memcmp(header, OPENING_BOOK_MAGIC, 4) != 0
+        || ByteOrder_ReadUint32(header + 4) != OPENING_BOOK_VERSION || ByteOrder_ReadUint32(header + 16) > OPENING_BOOK_MAX_BUCKET_BITS){
+        OpeningBook_Close(book);
+        return 0;
+    }
+    uint64_t count = ByteOrder_ReadUint64(header + 8);
+    int bucketBits = (int)ByteOrder_ReadUint32(header + 16);
+    uint64_t bucketBytes = (((uint64_t)1 << bucketBits) + 1)*OPENING_BOOK_BUCKET_SIZE;
+    if(book->size - OPENING_BOOK_HEADER_SIZE < bucketBytes
+        || (book->size - OPENING_BOOK_HEADER_SIZE - bucketBytes) / OPENING_BOOK_ENTRY_SIZE != count
+        || (book->size - OPENING_BOOK_HEADER_SIZE - bucketBytes) % OPENING_BOOK_ENTRY_SIZE != 0){
+        OpeningBook_Close(book);
+        return 0;
+    }
+
+    book->count = count;
+    book->bucketBits = bucketBits;
+    book->buckets = book->data + OPENING_BOOK_HEADER_SIZE;
+    book->entries = book->buckets + bucketBytes;
+    return 1;
+
+}
+
+void OpeningBook_Close(OpeningBook* book){
+
+    Platform_UnmapFile(book->data, book->size);
+    memset(book, 0, sizeof(OpeningBook));
+
+}
+
+int OpeningBook_Lookup(const OpeningBook* book, uint64_t hash, OpeningBookMove* moves, int maxMoves){
+
+    if(book->count == 0) return 0;
+    uint64_t bucket = BucketOf(hash, book->bucketBits);
+    uint64_t low = ByteOrder_ReadUint64(book->buckets + bucket*OPENING_BOOK_BUCKET_SIZE);
+    uint64_t high = ByteOrder_ReadUint64(book->buckets + (bucket + 1)*OPENING_BOOK_BUCKET_SIZE);
+    if(high > book->count || low > high) return 0;
+
+    while(low < high){
+        uint64_t middle = low + (high - low)/2;
+        if(ByteOrder_ReadUint64(book->entries + middle*OPENING_BOOK_ENTRY_SIZE) < hash) low = middle + 1;
+        else high = middle;
+    }
+
+    int found = 0;
+    for(uint64_t i = low; i < book->count && found < maxMoves; i++){
+        const unsigned char* entry = book->entries + i*OPENING_BOOK_ENTRY_SIZE;
+        if(ByteOrder_ReadUint64(entry) != hash) break;
+        moves[found].move = Move_Decode(entry + 8);
+        moves[found].weight = ByteOrder_ReadUint16(entry + 10);
+        moves[found].games = ByteOrder_ReadUint32(entry + 12);
+        found++;
+    }
+    return found;
+
+}
+
+static uint64_t NextRandom(uint64_t* state){
+    if(*state == 0) *state = 0x9E3779B97F4A7C15ULL;
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+//The stored moves are checked against the position, a hash collision can't make the engine play an illegal move
+Move OpeningBook_Pick(const OpeningBook* book, const Position* position, uint64_t* randomState){
+
+    OpeningBookMove moves[MAX_LEGAL_MOVES];
+    int count = OpeningBook_Lookup(book, position->hash, moves, MAX_LEGAL_MOVES);
+
+    uint64_t total = 0;
+    int legal = 0;
+    for(int i = 0; i < count; i++){
+        if(!Position_IsLegalMove(position, moves[i].move)) continue;
+        moves[legal++] = moves[i];
+        total += moves[i].weight;
+    }
+    if(total == 0) return MOVE_NONE;
+
+    uint64_t pick = NextRandom(randomState) % total;
+    for(int i = 0; i < legal; i++){
+        if(pick < moves[i].weight) return moves[i].move;
+        pick -= moves[i].weight;
+    }
+    return moves[legal-1].move;
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef H_OPENING_BOOK
+#define H_OPENING_BOOK
+
+#include <stdint.h>
+
+#include "position.h"
+#include "move.h"
+#include "game_archive.h"
+
+//Opening book of moves by position, built from the games of an archive.
+//
+//The file is a 32 byte header (magic, version, entry count, bucket bits), a bucket table and the entries. An entry is
+//16 bytes: the Zobrist hash of the position, the move as the engine encodes it, its weight and the number of games
+//that played it. Entries are sorted by hash, the moves of one position by weight, heaviest first. The bucket table
+//holds the index of the first entry of every value of the hash's top bucket bits and one past the last, so a lookup
+//reads one bucket and binary searches the few entries in it. Numbers are little endian. The book is mapped, opening
+//it takes the same time however big it is and only the pages lookups touch are ever read.
+//
+//A move's weight is two points for every game its side won and one for every draw, scaled down for a position
+//whose heaviest move doesn't fit 16 bits. Moves below the builder's minimum number of games or without a single
+//point aren't kept.
+
+#define OPENING_BOOK_MAGIC "TCOB"
+#define OPENING_BOOK_VERSION 1
+#define OPENING_BOOK_HEADER_SIZE 32
+#define OPENING_BOOK_ENTRY_SIZE 16
+#define OPENING_BOOK_BUCKET_SIZE 8
+#define OPENING_BOOK_DEFAULT_PLIES 24
+#define OPENING_BOOK_DEFAULT_MIN_GAMES 2
+
+typedef struct OpeningBook{
+    const unsigned char* data;
+    uint64_t size;
+    const unsigned char* buckets;
+    const unsigned char* entries;
+    uint64_t count;
+    int bucketBits;
+} OpeningBook;
+
+typedef struct OpeningBookMove{
+    Move move;
+    uint32_t weight;
+    uint32_t games;
+} OpeningBookMove;
+
+typedef struct OpeningBookBuildStats{
+    uint64_t games;
+    uint64_t skipped;          //Games that didn't load or held an illegal move
+    uint64_t moves;            //Moves collected from the games
+    uint64_t positions;        //Positions in the book
+    uint64_t entries;          //Moves in the book
+} OpeningBookBuildStats;
+
+//Builds a book at path from the first maxPlies plies of every game in the archive, keeping the moves played in at
+//least minGames games. The games are replayed on threadCount threads and every collected move is held in memory
+//twice while it's sorted, 48 bytes a ply. Returns 1 on success, 0 if the file couldn't be written or memory ran out.
+int OpeningBook_Build(const GameArchive* archive, const char* path, int threadCount, int maxPlies, int minGames,
+    OpeningBookBuildStats* stats);
+
+//Maps the book at path. Returns 1 on success, 0 if it can't be opened or isn't a book.
+int OpeningBook_Open(OpeningBook* book, const char* path);
+void OpeningBook_Close(OpeningBook* book);
+//Writes up to maxMoves moves stored for the hash into moves, heaviest first, and returns how many there are.
+//The moves aren't checked against a position, see OpeningBook_Pick.
+int OpeningBook_Lookup(const OpeningBook* book, uint64_t hash, OpeningBookMove* moves, int maxMoves);
+//Picks one of the position's legal book moves at random, each in proportion to its weight, advancing *randomState
+//(any value but 0 to start). Returns MOVE_NONE when the position isn't in the book.
+Move OpeningBook_Pick(const OpeningBook* book, const Position* position, uint64_t* randomState);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "perft.h"
+#include "movegen.h"
+#include "thread_pool.h"
+
+#include <stdlib.h>
+
+typedef struct PerftTask{
+    Position position;
+    int rootIndex;
+    uint64_t nodes;
+} PerftTask;
+
+typedef struct PerftTaskSet{
+    PerftTask* tasks;
+    int depth;
+} PerftTaskSet;
+
+//Walks the tree on one position with make and unmake, it's back as it was when this returns
+static uint64_t PerftRecursive(Position* position, int depth){
+
+    MoveList moveList;
+    Position_GenerateLegalMoves(position, &moveList);
+
+    //Bulk count, the moves at the last ply don't need to be played
+    if(depth <= 1){
+        return depth == 1 ? (uint64_t)moveList.length : 1;
+    }
+
+    uint64_t nodes = 0;
+    PositionUndo undo;
+    for(int i = 0; i < moveList.length; i++){
+        Position_MakeMove(position, moveList.moves[i], &undo);
+        nodes += PerftRecursive(position, depth - 1);
+        Position_UnmakeMove(position, &undo);
+    }
+
+    return nodes;
+
+}
+
+uint64_t Perft(const Position* position, int depth){
+    Position working = *position;
+    return PerftRecursive(&working, depth);
+}
+
+uint64_t Perft_Divide(const Position* position, int depth, MoveList* rootMoves, uint64_t* moveNodes){
+
+    Position working = *position;
+    Position_GenerateLegalMoves(&working, rootMoves);
+
+    uint64_t nodes = 0;
+    PositionUndo undo;
+    for(int i = 0; i < rootMoves->length; i++){
+        Position_MakeMove(&working, rootMoves->moves[i], &undo);
+        moveNodes[i] = PerftRecursive(&working, depth - 1);
+        Position_UnmakeMove(&working, &undo);
+        nodes += moveNodes[i];
+    }
+
+    return nodes;
+
+}
+
+static void RunPerftTask(void* context, int taskIndex, int threadIndex){
+    (void)threadIndex;
+    PerftTaskSet* taskSet = (PerftTaskSet*)context;
+    PerftTask* task = &taskSet->tasks[taskIndex];
+    task->nodes = PerftRecursive(&task->position, taskSet->depth);
+}
+
+uint64_t Perft_DivideParallel(const Position* position, int depth, int threadCount, MoveList* rootMoves, uint64_t* moveNodes){
+
+    //Too shallow to be worth splitting
+    if(depth < 3 || threadCount <= 1){
+        return Perft_Divide(position, depth, rootMoves, moveNodes);
+    }
+
+    Position_GenerateLegalMoves(position, rootMoves);
+
+    //Every root move has fewer than MAX_LEGAL_MOVES replies
+    PerftTask* tasks = (PerftTask*)malloc(sizeof(PerftTask) * rootMoves->length * MAX_LEGAL_MOVES);
+    if(tasks == NULL){
+        return Perft_Divide(position, depth, rootMoves, moveNodes);
+    }
+
+    //Each task gets its own copy of the position two plies down to make and unmake on
+    Position working = *position;
+    PositionUndo rootUndo, replyUndo;
+    int taskCount = 0;
+    for(int i = 0; i < rootMoves->length; i++){
+        Position_MakeMove(&working, rootMoves->moves[i], &rootUndo);
+
+        MoveList replies;
+        Position_GenerateLegalMoves(&working, &replies);
+        for(int j = 0; j < replies.length; j++){
+            PerftTask* task = &tasks[taskCount++];
+            Position_MakeMove(&working, replies.moves[j], &replyUndo);
+            task->position = working;
+            Position_UnmakeMove(&working, &replyUndo);
+            task->rootIndex = i;
+            task->nodes = 0;
+        }
+
+        Position_UnmakeMove(&working, &rootUndo);
+    }
+
+    PerftTaskSet taskSet;
+    taskSet.tasks = tasks;
+    taskSet.depth = depth - 2;
+    ThreadPool_Run(threadCount, taskCount, RunPerftTask, &taskSet);
+
+    uint64_t nodes = 0;
+    for(int i = 0; i < rootMoves->length; i++){
+        moveNodes[i] = 0;
+    }
+    for(int i = 0; i < taskCount; i++){
+        moveNodes[tasks[i].rootIndex] += tasks[i].nodes;
+        nodes += tasks[i].nodes;
+    }
+
+    free(tasks);
+    return nodes;
+
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef H_PERFT
+#define H_PERFT
+
+#include <stdint.h>
+
+#include "position.h"
+#include "data_structures/move_list.h"
+
+//Counts the leaf nodes of the legal move tree to the given depth
+uint64_t Perft(const Position* position, int depth);
+
+//Same as Perft but also writes the node count below every root move, in the order of rootMoves
+uint64_t Perft_Divide(const Position* position, int depth, MoveList* rootMoves, uint64_t* moveNodes);
+
+//Perft_Divide spread over threadCount threads. The tree is split two plies down into one task per
+//root move and reply, tasks are handed out by the work stealing ThreadPool and the per task counts are
+//summed in a fixed order, so the result never depends on scheduling.
+uint64_t Perft_DivideParallel(const Position* position, int depth, int threadCount, MoveList* rootMoves, uint64_t* moveNodes);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,570 @@
+#include "pgn.h"
+#include "san.h"
+#include "movegen.h"
+#include "thread_pool.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Slices per thread, uneven slices are evened out by the pool's stealing
+#define PGN_SLICES_PER_THREAD 4
+#define PGN_MAX_SLICES (THREAD_POOL_MAX_THREADS*PGN_SLICES_PER_THREAD)
+#define PGN_EXPORT_GAMES_PER_TASK 1024
+
+//Doubles *capacity until needed elements of size fit. Returns 0 if out of memory.
+static int Reserve(void** data, size_t* capacity, size_t needed, size_t size){
+
+    if(needed <= *capacity) return 1;
+    size_t grown = *capacity == 0 ? 1024 : *capacity;
+    while(grown < needed) grown *= 2;
+    void* resized = realloc(*data, grown*size);
+    if(resized == NULL) return 0;
+    *data = resized;
+    *capacity = grown;
+    return 1;
+
+}
+
+void PgnBatch_Init(PgnBatch* batch){
+    memset(batch, 0, sizeof(PgnBatch));
+}
+
+void PgnBatch_Free(PgnBatch* batch){
+    free(batch->games);
+    free(batch->moves);
+    PgnBatch_Init(batch);
+}
+
+void PgnBatch_Reset(PgnBatch* batch){
+    batch->count = 0;
+    batch->moveBytes = 0;
+    batch->skipped = 0;
+    batch->positions = 0;
+}
+
+static int IsSpace(char c){
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//Past the end of the line, newline included
+static const char* SkipLine(const char* p, const char* end){
+    const char* newline = (const char*)memchr(p, '\n', end - p);
+    return newline == NULL ? end : newline + 1;
+}
+
+//"1-0", "0-1", "1/2-1/2" or "*" at p, sets *length to its length
+static int ReadResult(const char* p, const char* end, enum GAME_RESULT* result, int* length){
+
+    size_t left = end - p;
+    if(left >= 7 && memcmp(p, "1/2-1/2", 7) == 0){
+        *result = GAME_RESULT_DRAW;
+        *length = 7;
+        return 1;
+    }
+    if(left >= 3 && memcmp(p, "1-0", 3) == 0){
+        *result = GAME_RESULT_WHITE_WINS;
+        *length = 3;
+        return 1;
+    }
+    if(left >= 3 && memcmp(p, "0-1", 3) == 0){
+        *result = GAME_RESULT_BLACK_WINS;
+        *length = 3;
+        return 1;
+    }
+    if(left >= 1 && *p == '*'){
+        *result = GAME_RESULT_UNFINISHED;
+        *length = 1;
+        return 1;
+    }
+    return 0;
+
+}
+
+//Reads [Name "Value"] lines, keeping the two tags that matter. Returns where the movetext starts.
+static const char* ParseTags(const char* p, const char* end, PgnGame* game, int* fenTooLong){
+
+    while(p < end && *p == '['){
+
+        const char* lineEnd = SkipLine(p, end);
+        const char* name = p + 1;
+        const char* nameEnd = name;
+        while(nameEnd < lineEnd && !IsSpace(*nameEnd) && *nameEnd != '"') nameEnd++;
+        const char* value = (const char*)memchr(nameEnd, '"', lineEnd - nameEnd);
+
+        if(value != NULL){
+            value++;
+            const char* valueEnd = value;
+            while(valueEnd < lineEnd && *valueEnd != '"'){
+                valueEnd += (*valueEnd == '\\' && valueEnd + 1 < lineEnd) ? 2 : 1;
+            }
+            size_t nameLength = nameEnd - name;
+            size_t valueLength = valueEnd - value;
+            if(nameLength == 3 && memcmp(name, "FEN", 3) == 0){
+                if(valueLength >= FEN_MAX_LENGTH) *fenTooLong = 1;
+                else{
+                    memcpy(game->startFen, value, valueLength);
+                    game->startFen[valueLength] = '\0';
+                }
+            }
+            else if(nameLength == 6 && memcmp(name, "Result", 6) == 0){
+                enum GAME_RESULT result;
+                int length;
+                if(ReadResult(value, valueEnd, &result, &length)) game->result = result;
+            }
+        }
+
+        p = lineEnd;
+        while(p < end && IsSpace(*p)) p++;
+
+    }
+    return p;
+
+}
+
+//Parses one game from p, adding it to the batch unless its FEN doesn't load or a move can't be resolved. Returns where the next game starts
+//or NULL if the batch ran out of memory.
+static const char* ParseGame(const char* text, const char* p, const char* end, PgnBatch* batch){
+
+    PgnGame game;
+    game.moveOffset = batch->moveBytes;
+    game.moveCount = 0;
+    game.result = GAME_RESULT_UNFINISHED;
+    game.reason = GAME_END_UNKNOWN;
+    game.startFen[0] = '\0';
+
+    const char* gameStart = p;
+    int fenTooLong = 0;
+    p = ParseTags(p, end, &game, &fenTooLong);
+
+    Position position;
+    int broken = fenTooLong || !Position_LoadFen(&position, game.startFen[0] != '\0' ? game.startFen : FEN_START_POSITION);
+    int ended = 0;
+
+    while(p < end && !ended){
+
+        char c = *p;
+        if(IsSpace(c)){
+            p++;
+            continue;
+        }
+        int lineStart = p == text || p[-1] == '\n';
+
+        //A tag line after the moves belongs to the next game, this one had no result token and keeps the tag's
+        if(c == '[' && lineStart) break;
+        if(c == '%' && lineStart){
+            p = SkipLine(p, end);
+            continue;
+        }
+        if(c == '{'){
+            const char* close = (const char*)memchr(p, '}', end - p);
+            p = close == NULL ? end : close + 1;
+            continue;
+        }
+        if(c == ';'){
+            p = SkipLine(p, end);
+            continue;
+        }
+        //Variations can nest and hold comments with parentheses in them
+        if(c == '('){
+            int depth = 0;
+            while(p < end){
+                if(*p == '{'){
+                    const char* close = (const char*)memchr(p, '}', end - p);
+                    p = close == NULL ? end - 1 : close;
+                }
+                else if(*p == '(') depth++;
+                else if(*p == ')' && --depth == 0){
+                    p++;
+                    break;
+                }
+                p++;
+            }
+            continue;
+        }
+        if(c == '$' || c == '.' || c == ')'){
+            p++;
+            while(p < end && *p >= '0' && *p <= '9') p++;
+            continue;
+        }
+
+        enum GAME_RESULT result;
+        int resultLength;
+        if(ReadResult(p, end, &result, &resultLength)){
+            game.result = result;
+            p += resultLength;
+            ended = 1;
+            continue;
+        }
+        //Move numbers, with their dots taken as separators above. 0-0 is castling written with zeros.
+        if(c >= '0' && c <= '9' && !(end - p >= 3 && p[0] == '0' && p[1] == '-' && p[2] == '0')){
+            while(p < end && *p >= '0' && *p <= '9') p++;
+            continue;
+        }
+
+        const char* token = p;
+        while(p < end && !IsSpace(*p) && *p != '{' && *p != '(' && *p != ')' && *p != ';' && *p != '$') p++;
+        if(broken) continue;
+
+        Move move = Position_MoveFromSan(&position, token, (int)(p - token));
+        if(move == MOVE_NONE || game.moveCount == GAME_ARCHIVE_MAX_MOVES){
+            broken = 1;
+            continue;
+        }
+        if(!Reserve((void**)&batch->moves, &batch->moveCapacity, batch->moveBytes + 2, 1)) return NULL;
+        Move_Encode(move, batch->moves + batch->moveBytes);
+        batch->moveBytes += 2;
+        game.moveCount++;
+        PositionUndo undo;
+        Position_MakeMove(&position, move, &undo);
+
+    }
+
+    if(broken){
+        batch->moveBytes = game.moveOffset;
+        batch->skipped++;
+        return p;
+    }
+    //Whitespace or a stray line isn't a game
+    if(game.moveCount == 0 && !ended && p - gameStart > 0 && *gameStart != '['){
+        return p;
+    }
+
+    GameResult_FromPosition(&position, &game.result, &game.reason);
+    if(!Reserve((void**)&batch->games, &batch->capacity, (size_t)batch->count + 1, sizeof(PgnGame))) return NULL;
+    batch->games[batch->count++] = game;
+    batch->positions += game.moveCount;
+    return p;
+
+}
+
+int Pgn_ParseGames(const char* text, size_t length, PgnBatch* batch){
+
+    const char* p = text;
+    const char* end = text + length;
+    while(p < end){
+        while(p < end && IsSpace(*p)) p++;
+        if(p == end) break;
+        p = ParseGame(text, p, end, batch);
+        if(p == NULL) return 0;
+    }
+    return 1;
+
+}
+
+//A game starts at a tag line that doesn't follow another tag line, the first in the file or the first after movetext
+static int IsGameStart(const char* text, size_t lineStart){
+
+    if(text[lineStart] != '[') return 0;
+    size_t i = lineStart;
+    while(i > 0 && IsSpace(text[i-1])) i--;
+    if(i == 0) return 1;
+    while(i > 0 && text[i-1] != '\n') i--;
+    return text[i] != '[';
+
+}
+
+//First game that starts at or after offset, length if none does
+static size_t NextGameStart(const char* text, size_t length, size_t offset){
+
+    if(offset == 0) return 0;
+    size_t lineStart = offset;
+    if(text[lineStart-1] != '\n') lineStart = SkipLine(text + offset, text + length) - text;
+    while(lineStart < length){
+        if(IsGameStart(text, lineStart)) return lineStart;
+        lineStart = SkipLine(text + lineStart, text + length) - text;
+    }
+    return length;
+
+}
+
+//Start of the last game in the text, 0 if there's only one
+static size_t LastGameStart(const char* text, size_t length){
+
+    size_t i = length;
+    while(i > 1){
+        i--;
+        if(text[i] == '[' && text[i-1] == '\n' && IsGameStart(text, i)) return i;
+    }
+    return 0;
+
+}
+
+typedef struct ParseContext{
+    const char* text;
+    size_t bounds[PGN_MAX_SLICES + 1];
+    PgnBatch* batches;
+    volatile int32_t failed;
+} ParseContext;
+
+static void ParseSlice(void* context, int taskIndex, int threadIndex){
+
+    (void)threadIndex;
+    ParseContext* parse = (ParseContext*)context;
+    PgnBatch* batch = &parse->batches[taskIndex];
+    PgnBatch_Reset(batch);
+    if(!Pgn_ParseGames(parse->text + parse->bounds[taskIndex], parse->bounds[taskIndex+1] - parse->bounds[taskIndex], batch)){
+        Platform_AtomicFetchAdd(&parse->failed, 1);
+    }
+
+}
+
+int Pgn_Import(const char* path, GameArchiveWriter* archive, int threadCount, PgnStats* stats){
+
+    memset(stats, 0, sizeof(PgnStats));
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+    int sliceCount = threadCount*PGN_SLICES_PER_THREAD;
+
+    FILE* file = fopen(path, "rb");
+    if(file == NULL) return 0;
+
+    size_t capacity = PGN_CHUNK_SIZE;
+    char* buffer = (char*)malloc(capacity);
+    ParseContext* parse = (ParseContext*)malloc(sizeof(ParseContext));
+    PgnBatch* batches = (PgnBatch*)malloc(sizeof(PgnBatch) * sliceCount);
+    if(buffer == NULL || parse == NULL || batches == NULL){
+        free(buffer);
+        free(parse);
+        free(batches);
+        fclose(file);
+        return 0;
+    }
+    for(int i = 0; i < sliceCount; i++){
+        PgnBatch_Init(&batches[i]);
+    }
+    parse->batches = batches;
+
+    int success = 1;
+    size_t filled = 0;
+    while(success){
+
+        size_t read = fread(buffer + filled, 1, capacity - filled, file);
+        filled += read;
+        stats->bytes += read;
+        if(ferror(file)){
+            success = 0;
+            break;
+        }
+        int atEnd = filled < capacity || feof(file);
+
+        //The last game of a chunk may go on in the next one, it waits for the next read
+        size_t usable = atEnd ? filled : LastGameStart(buffer, filled);
+        if(usable == 0 && !atEnd){
+            //A single game bigger than the buffer
+            char* grown = (char*)realloc(buffer, capacity*2);
+            if(grown == NULL){
+                success = 0;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+            continue;
+        }
+
+        parse->text = buffer;
+        parse->failed = 0;
+        parse->bounds[0] = 0;
+        for(int i = 1; i < sliceCount; i++){
+            parse->bounds[i] = NextGameStart(buffer, usable, usable / sliceCount * i);
+            if(parse->bounds[i] < parse->bounds[i-1]) parse->bounds[i] = parse->bounds[i-1];
+        }
+        parse->bounds[sliceCount] = usable;
+        ThreadPool_Run(threadCount, sliceCount, ParseSlice, parse);
+        if(parse->failed){
+            success = 0;
+            break;
+        }
+
+        //Slices in file order keep the game ids in file order
+        for(int i = 0; i < sliceCount && success; i++){
+            PgnBatch* batch = &batches[i];
+            for(int g = 0; g < batch->count; g++){
+                const PgnGame* game = &batch->games[g];
+                if(GameArchiveWriter_Append(archive, game->startFen[0] != '\0' ? game->startFen : NULL, batch->moves + game->moveOffset,
+                    game->moveCount, game->result, game->reason) < 0){
+                    success = 0;
+                    break;
+                }
+            }
+            stats->games += batch->count;
+            stats->skipped += batch->skipped;
+            stats->moves += batch->positions;
+        }
+
+        if(atEnd) break;
+        memmove(buffer, buffer + usable, filled - usable);
+        filled -= usable;
+
+    }
+
+    for(int i = 0; i < sliceCount; i++){
+        PgnBatch_Free(&batches[i]);
+    }
+    free(batches);
+    free(parse);
+    free(buffer);
+    fclose(file);
+    return success;
+
+}
+
+typedef struct PgnText{
+    char* data;
+    size_t length;
+    size_t capacity;
+} PgnText;
+
+static void AppendText(PgnText* text, const char* string, size_t length){
+    memcpy(text->data + text->length, string, length);
+    text->length += length;
+}
+
+//Renders the game's tags and movetext. Returns 0 if the game doesn't load or holds an illegal move, -1 if memory runs out.
+static int RenderGame(const ArchivedGame* game, PgnText* text){
+
+    //Enough for the tags and the longest SAN with its move number and separator on every ply
+    if(!Reserve((void**)&text->data, &text->capacity, text->length + 512 + (size_t)game->moveCount*24, 1)) return -1;
+    size_t gameStart = text->length;
+
+    Position position;
+    if(!ArchivedGame_StartPosition(game, &position)) return 0;
+
+    const char* result = GameResult_ToString(game->result);
+    char line[256];
+    int lineLength = sprintf(line, "[Event \"?\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"?\"]\n[White \"?\"]\n[Black \"?\"]\n[Result \"%s\"]\n", result);
+    AppendText(text, line, lineLength);
+    if(game->startFen != NULL){
+        lineLength = sprintf(line, "[SetUp \"1\"]\n[FEN \"%.*s\"]\n", game->startFenLength, game->startFen);
+        AppendText(text, line, lineLength);
+    }
+    AppendText(text, "\n", 1);
+
+    int column = 0;
+    for(int ply = 0; ply <= game->moveCount; ply++){
+
+        char token[32];
+        int tokenLength = 0;
+        if(ply == game->moveCount){
+            tokenLength = (int)strlen(result);
+            memcpy(token, result, tokenLength);
+        }
+        else{
+            Move move = ArchivedGame_Move(game, ply);
+            if(!Position_IsLegalMove(&position, move)){
+                text->length = gameStart;
+                return 0;
+            }
+            if(position.sideToMove == WHITE) tokenLength = sprintf(token, "%d. ", position.fullmoveNumber);
+            else if(ply == 0) tokenLength = sprintf(token, "%d... ", position.fullmoveNumber);
+            tokenLength += Position_MoveToSan(&position, move, token + tokenLength);
+            PositionUndo undo;
+            Position_MakeMove(&position, move, &undo);
+        }
+
+        if(column > 0 && column + 1 + tokenLength > PGN_LINE_LENGTH){
+            AppendText(text, "\n", 1);
+            column = 0;
+        }
+        else if(column > 0){
+            AppendText(text, " ", 1);
+            column++;
+        }
+        AppendText(text, token, tokenLength);
+        column += tokenLength;
+
+    }
+    AppendText(text, "\n\n", 2);
+    return 1;
+
+}
+
+typedef struct ExportContext{
+    const GameArchive* archive;
+    uint64_t firstGame;
+    PgnText* texts;
+    uint64_t* skipped;
+    uint64_t* moves;
+    volatile int32_t failed;
+} ExportContext;
+
+static void ExportTask(void* context, int taskIndex, int threadIndex){
+
+    (void)threadIndex;
+    ExportContext* export = (ExportContext*)context;
+    PgnText* text = &export->texts[taskIndex];
+    text->length = 0;
+    export->skipped[taskIndex] = 0;
+    export->moves[taskIndex] = 0;
+
+    uint64_t first = export->firstGame + (uint64_t)taskIndex*PGN_EXPORT_GAMES_PER_TASK;
+    for(uint64_t id = first; id < first + PGN_EXPORT_GAMES_PER_TASK && id < export->archive->count; id++){
+        ArchivedGame game;
+        int rendered = GameArchive_Game(export->archive, id, &game) ? RenderGame(&game, text) : 0;
+        if(rendered < 0){
+            Platform_AtomicFetchAdd(&export->failed, 1);
+            return;
+        }
+        if(rendered == 0){
+            export->skipped[taskIndex]++;
+            continue;
+        }
+        export->moves[taskIndex] += game.moveCount;
+    }
+
+}
+
+int Pgn_Export(const GameArchive* archive, const char* path, int threadCount, PgnStats* stats){
+
+    memset(stats, 0, sizeof(PgnStats));
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+    int taskCount = threadCount*PGN_SLICES_PER_THREAD;
+
+    FILE* file = fopen(path, "wb");
+    if(file == NULL) return 0;
+
+    ExportContext export;
+    export.archive = archive;
+    export.texts = (PgnText*)calloc(taskCount, sizeof(PgnText));
+    export.skipped = (uint64_t*)calloc(taskCount, sizeof(uint64_t));
+    export.moves = (uint64_t*)calloc(taskCount, sizeof(uint64_t));
+    int success = export.texts != NULL && export.skipped != NULL && export.moves != NULL;
+
+    uint64_t perRound = (uint64_t)taskCount*PGN_EXPORT_GAMES_PER_TASK;
+    for(uint64_t first = 0; success && first < archive->count; first += perRound){
+
+        export.firstGame = first;
+        export.failed = 0;
+        ThreadPool_Run(threadCount, taskCount, ExportTask, &export);
+        if(export.failed){
+            success = 0;
+            break;
+        }
+
+        for(int i = 0; i < taskCount; i++){
+            if(fwrite(export.texts[i].data, 1, export.texts[i].length, file) != export.texts[i].length){
+                success = 0;
+                break;
+            }
+            stats->bytes += export.texts[i].length;
+            stats->skipped += export.skipped[i];
+            stats->moves += export.moves[i];
+        }
+
+    }
+    stats->games = archive->count - stats->skipped;
+
+    if(export.texts != NULL){
+        for(int i = 0; i < taskCount; i++){
+            free(export.texts[i].data);
+        }
+    }
+    free(export.texts);
+    free(export.skipped);
+    free(export.moves);
+    if(fclose(file) != 0) success = 0;
+    return success;
+
+}
\ No newline at end of file
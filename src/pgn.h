@@ -0,0 +1,68 @@
+#ifndef H_PGN
+#define H_PGN
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fen.h"
+#include "game_archive.h"
+
+//Portable Game Notation import into game archives and export out of them.
+//
+//Importing reads the file PGN_CHUNK_SIZE bytes at a time, so files of any size take the same memory. Each chunk is cut
+//at game boundaries into slices that are parsed on the thread pool, and the slices are appended to the archive in file
+//order, so game ids follow the order of the file whatever the thread count. Moves are resolved from SAN against the
+//position one at a time (see san.h). Tags other than FEN and Result, comments, variations and NAGs are skipped.
+//A game with a move that can't be resolved or a FEN tag that fails Position_LoadFen, which turns down positions the
+//move generator can't work on, is counted and skipped, the rest of the file is still imported.
+//
+//Exporting writes the seven tag roster, with what an archive doesn't know as "?", the FEN tags for games that didn't
+//start from the standard position and the moves in SAN wrapped at PGN_LINE_LENGTH. Games are rendered on the thread pool
+//in batches and written in id order.
+
+#define PGN_CHUNK_SIZE (16*1024*1024)
+#define PGN_LINE_LENGTH 80
+
+//One parsed game, its moves are in the batch's move buffer
+typedef struct PgnGame{
+    size_t moveOffset;
+    int moveCount;
+    enum GAME_RESULT result;
+    enum GAME_END_REASON reason;
+    char startFen[FEN_MAX_LENGTH]; //Empty for the standard start position
+} PgnGame;
+
+typedef struct PgnBatch{
+    PgnGame* games;
+    int count;
+    size_t capacity;
+    unsigned char* moves;    //Every game's moves encoded by Move_Encode, back to back
+    size_t moveBytes;
+    size_t moveCapacity;
+    uint64_t skipped;        //Games with a move that couldn't be resolved or a broken FEN
+    uint64_t positions;      //Moves played
+} PgnBatch;
+
+typedef struct PgnStats{
+    uint64_t games;          //Imported or exported
+    uint64_t skipped;
+    uint64_t moves;
+    uint64_t bytes;          //Of PGN read or written
+} PgnStats;
+
+void PgnBatch_Init(PgnBatch* batch);
+void PgnBatch_Free(PgnBatch* batch);
+//Empties the batch, keeping its memory
+void PgnBatch_Reset(PgnBatch* batch);
+
+//Parses every game in the length bytes of text into batch. The text has to hold whole games.
+//Returns 0 only if the batch ran out of memory.
+int Pgn_ParseGames(const char* text, size_t length, PgnBatch* batch);
+
+//Appends every game of the PGN file at path to the archive, parsing on threadCount threads. Returns 1 if the whole
+//file was read, 0 on a read, write or memory failure. stats is filled in either way.
+int Pgn_Import(const char* path, GameArchiveWriter* archive, int threadCount, PgnStats* stats);
+//Writes every game of the archive to the PGN file at path, rendering on threadCount threads. Returns 1 on success.
+int Pgn_Export(const GameArchive* archive, const char* path, int threadCount, PgnStats* stats);
+
+#endif
\ No newline at end of file
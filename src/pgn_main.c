@@ -0,0 +1,75 @@
+//PGN import into game archives and export out of them.
+//
+//  chess_pgn import <pgn> <archive> [threads]  appends every game of the pgn file to the archive, creating it if needed
+//  chess_pgn export <archive> <pgn> [threads]  writes every game of the archive to the pgn file
+//
+//threads defaults to one per core. Both print the games, moves and bytes handled and how fast.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pgn.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "platform.h"
+
+void PrintStats(const char* action, const PgnStats* stats, uint64_t elapsed){
+
+    double seconds = elapsed / 1e9;
+    printf("%s %llu games (%llu skipped), %llu moves, %.1f MB\n", action, (unsigned long long)stats->games,
+        (unsigned long long)stats->skipped, (unsigned long long)stats->moves, stats->bytes / 1e6);
+    printf("%.2f s, %.0f games per minute, %.0f MB/s\n", seconds, seconds > 0 ? stats->games / seconds * 60 : 0.0,
+        seconds > 0 ? stats->bytes / 1e6 / seconds : 0.0);
+
+}
+
+int main(int argc, char** argv){
+
+    if(argc < 4 || (strcmp(argv[1], "import") != 0 && strcmp(argv[1], "export") != 0)){
+        printf("Usage: %s import <pgn> <archive> [threads]\n", argv[0]);
+        printf("       %s export <archive> <pgn> [threads]\n", argv[0]);
+        return 1;
+    }
+    int threadCount = argc >= 5 ? atoi(argv[4]) : 0;
+    if(threadCount <= 0) threadCount = Platform_ProcessorCount();
+
+    Attacks_Init();
+    Zobrist_Init();
+
+    PgnStats stats;
+    uint64_t start = Platform_TimeNanoseconds();
+
+    if(strcmp(argv[1], "import") == 0){
+
+        GameArchiveWriter writer;
+        if(!GameArchiveWriter_Open(&writer, argv[3])){
+            printf("Could not open the game archive %s\n", argv[3]);
+            return 1;
+        }
+        int imported = Pgn_Import(argv[2], &writer, threadCount, &stats);
+        GameArchiveWriter_Close(&writer);
+        PrintStats("Imported", &stats, Platform_TimeNanoseconds() - start);
+        if(!imported){
+            printf("Could not read all of %s\n", argv[2]);
+            return 1;
+        }
+        return 0;
+
+    }
+
+    GameArchive archive;
+    if(!GameArchive_Open(&archive, argv[2])){
+        printf("Could not open the game archive %s\n", argv[2]);
+        return 1;
+    }
+    int exported = Pgn_Export(&archive, argv[3], threadCount, &stats);
+    GameArchive_Close(&archive);
+    PrintStats("Exported", &stats, Platform_TimeNanoseconds() - start);
+    if(!exported){
+        printf("Could not write %s\n", argv[3]);
+        return 1;
+    }
+    return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#endif
+
+#include "platform.h"
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <malloc.h>
+
+struct PlatformThread{
+    HANDLE handle;
+    PlatformThreadFunction function;
+    void* argument;
+};
+
+uint64_t Platform_TimeNanoseconds(){
+
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if(frequency.QuadPart == 0){
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+
+    uint64_t seconds = (uint64_t)counter.QuadPart / (uint64_t)frequency.QuadPart;
+    uint64_t remainder = (uint64_t)counter.QuadPart % (uint64_t)frequency.QuadPart;
+    return seconds*1000000000ULL + remainder*1000000000ULL / (uint64_t)frequency.QuadPart;
+
+}
+
+int Platform_ProcessorCount(){
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return (int)systemInfo.dwNumberOfProcessors;
+}
+
+static DWORD WINAPI ThreadEntry(LPVOID argument){
+    PlatformThread* thread = (PlatformThread*)argument;
+    thread->function(thread->argument);
+    return 0;
+}
+
+PlatformThread* Platform_CreateThread(PlatformThreadFunction function, void* argument){
+
+    PlatformThread* thread = (PlatformThread*)malloc(sizeof(PlatformThread));
+    if(thread == NULL) return NULL;
+
+    thread->function = function;
+    thread->argument = argument;
+    thread->handle = CreateThread(NULL, 0, ThreadEntry, thread, 0, NULL);
+    if(thread->handle == NULL){
+        free(thread);
+        return NULL;
+    }
+    return thread;
+
+}
+
+void Platform_JoinThread(PlatformThread* thread){
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    free(thread);
+}
+
+int32_t Platform_AtomicFetchAdd(volatile int32_t* value, int32_t add){
+    return (int32_t)InterlockedExchangeAdd((volatile LONG*)value, (LONG)add);
+}
+
+void* Platform_AlignedAlloc(size_t size, size_t alignment){
+    return _aligned_malloc(size, alignment);
+}
+
+void Platform_AlignedFree(void* memory){
+    _aligned_free(memory);
+}
+
+int Platform_WriteStdout(const char* data, int size){
+    DWORD written = 0;
+    if(!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, (DWORD)size, &written, NULL)) return -1;
+    return (int)written;
+}
+
+int Platform_MapFile(const char* path, const unsigned char** data, uint64_t* size){
+
+    *data = NULL;
+    *size = 0;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || (uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX){
+        CloseHandle(file);
+        return 0;
+    }
+    if(fileSize.QuadPart == 0){
+        CloseHandle(file);
+        return 1;
+    }
+
+    //The view keeps the mapping alive, neither handle is needed after it's made
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL) return 0;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(view == NULL) return 0;
+
+    *data = (const unsigned char*)view;
+    *size = (uint64_t)fileSize.QuadPart;
+    return 1;
+
+}
+
+void Platform_UnmapFile(const unsigned char* data, uint64_t size){
+    (void)size;
+    if(data != NULL) UnmapViewOfFile(data);
+}
+
+int Platform_TruncateFile(const char* path, uint64_t size){
+
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER distance;
+    distance.QuadPart = (LONGLONG)size;
+    int truncated = SetFilePointerEx(file, distance, NULL, FILE_BEGIN) && SetEndOfFile(file);
+    CloseHandle(file);
+    return truncated;
+
+}
+
+#else
+
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct PlatformThread{
+    pthread_t handle;
+    PlatformThreadFunction function;
+    void* argument;
+};
+
+uint64_t Platform_TimeNanoseconds(){
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec*1000000000ULL + (uint64_t)time.tv_nsec;
+
+}
+
+int Platform_ProcessorCount(){
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+static void* ThreadEntry(void* argument){
+    PlatformThread* thread = (PlatformThread*)argument;
+    thread->function(thread->argument);
+    return NULL;
+}
+
+PlatformThread* Platform_CreateThread(PlatformThreadFunction function, void* argument){
+
+    PlatformThread* thread = (PlatformThread*)malloc(sizeof(PlatformThread));
+    if(thread == NULL) return NULL;
+
+    thread->function = function;
+    thread->argument = argument;
+    if(pthread_create(&thread->handle, NULL, ThreadEntry, thread) != 0){
+        free(thread);
+        return NULL;
+    }
+    return thread;
+
+}
+
+void Platform_JoinThread(PlatformThread* thread){
+    pthread_join(thread->handle, NULL);
+    free(thread);
+}
+
+int32_t Platform_AtomicFetchAdd(volatile int32_t* value, int32_t add){
+    return __atomic_fetch_add(value, add, __ATOMIC_SEQ_CST);
+}
+
+void* Platform_AlignedAlloc(size_t size, size_t alignment){
+    void* memory = NULL;
+    if(posix_memalign(&memory, alignment, size) != 0) return NULL;
+    return memory;
+}
+
+void Platform_AlignedFree(void* memory){
+    free(memory);
+}
+
+int Platform_WriteStdout(const char* data, int size){
+    ssize_t written;
+    do{
+        written = write(STDOUT_FILENO, data, (size_t)size);
+    }while(written < 0 && errno == EINTR);
+    return (int)written;
+}
+
+int Platform_MapFile(const char* path, const unsigned char** data, uint64_t* size){
+
+    *data = NULL;
+    *size = 0;
+    int file = open(path, O_RDONLY);
+    if(file < 0) return 0;
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || (uint64_t)status.st_size > (uint64_t)SIZE_MAX){
+        close(file);
+        return 0;
+    }
+    if(status.st_size == 0){
+        close(file);
+        return 1;
+    }
+
+    //The mapping holds its own reference to the file
+    void* view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if(view == MAP_FAILED) return 0;
+
+    *data = (const unsigned char*)view;
+    *size = (uint64_t)status.st_size;
+    return 1;
+
+}
+
+void Platform_UnmapFile(const unsigned char* data, uint64_t size){
+    if(data != NULL) munmap((void*)data, (size_t)size);
+}
+
+int Platform_TruncateFile(const char* path, uint64_t size){
+    return truncate(path, (off_t)size) == 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef H_PLATFORM
+#define H_PLATFORM
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Thin wrappers over the few os services the tools and engine need, so that the
+//chess code itself stays free of windows.h and builds on other platforms too.
+
+//Monotonic clock for benchmarks and search time limits
+uint64_t Platform_TimeNanoseconds();
+
+int Platform_ProcessorCount();
+
+typedef struct PlatformThread PlatformThread;
+typedef void (*PlatformThreadFunction)(void* argument);
+
+//Starts a thread running function(argument), returns NULL if the thread could not be created
+PlatformThread* Platform_CreateThread(PlatformThreadFunction function, void* argument);
+//Waits for the thread to finish and frees it
+void Platform_JoinThread(PlatformThread* thread);
+
+//Atomically adds to *value and returns what it held before
+int32_t Platform_AtomicFetchAdd(volatile int32_t* value, int32_t add);
+
+//Memory aligned to alignment bytes (a power of two), release with Platform_AlignedFree
+void* Platform_AlignedAlloc(size_t size, size_t alignment);
+void Platform_AlignedFree(void* memory);
+
+//One unbuffered write to standard output, bypassing stdio. Returns the bytes written, which can be
+//fewer than size, or -1 on error. Flush stdout first if printf output has to come before it.
+int Platform_WriteStdout(const char* data, int size);
+
+//Maps a whole file read only. The pages are shared with the os file cache, nothing is copied until they're touched.
+//An empty file maps to NULL with size 0. Returns 1 on success, 0 if the file can't be opened or mapped.
+int Platform_MapFile(const char* path, const unsigned char** data, uint64_t* size);
+void Platform_UnmapFile(const unsigned char* data, uint64_t size);
+//Cuts the file down to size bytes. Returns 1 on success, 0 otherwise.
+int Platform_TruncateFile(const char* path, uint64_t size);
+
+#endif
\ No newline at end of file
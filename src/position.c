@@ -0,0 +1,301 @@
+#include "position.h"
+#include "attacks.h"
+#include "zobrist.h"
+
+#include <string.h>
+
+//Rights that survive a move touching each square, a king or rook leaving home (or a rook being captured) drops them
+static const unsigned char castlingRightsMask[64] = {
+    15 & ~CASTLE_BLACK_QUEENSIDE, 15, 15, 15, 15 & ~(CASTLE_BLACK_KINGSIDE | CASTLE_BLACK_QUEENSIDE), 15, 15, 15 & ~CASTLE_BLACK_KINGSIDE,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15 & ~CASTLE_WHITE_QUEENSIDE, 15, 15, 15, 15 & ~(CASTLE_WHITE_KINGSIDE | CASTLE_WHITE_QUEENSIDE), 15, 15, 15 & ~CASTLE_WHITE_KINGSIDE
+};
+
+void Position_Clear(Position* position){
+    memset(position, 0, sizeof(Position));
+    position->sideToMove = WHITE;
+    position->enPassantSquare = NO_SQUARE;
+    position->fullmoveNumber = 1;
+}
+
+//Part of the hash that isn't pieces
+static uint64_t StateHash(const Position* position){
+
+    uint64_t hash = zobristCastling[position->castlingRights];
+    if(position->sideToMove == BLACK) hash ^= zobristBlackToMove;
+    if(position->enPassantSquare != NO_SQUARE) hash ^= zobristEnPassantFile[position->enPassantSquare % 8];
+    return hash;
+
+}
+
+uint64_t Position_ComputeHash(const Position* position){
+
+    uint64_t hash = StateHash(position);
+    Bitboard occupied = position->occupied;
+    while(occupied){
+        int index = Bitboard_PopLSB(&occupied);
+        hash ^= zobristPieces[Position_PieceSideAt(position, index)][Position_PieceTypeAt(position, index)][index];
+    }
+    return hash;
+
+}
+
+void Position_FromBoardState(Position* position, const BoardState* boardState, enum CHESS_SIDE sideToMove){
+
+    Position_Clear(position);
+    position->sideToMove = (unsigned char)sideToMove;
+
+    for(int i = 0; i < 64; i++){
+        const ChessPiece* piece = &boardState->board[i];
+        if(piece->type != NONE){
+            Position_PutPiece(position, i, piece->side, piece->type);
+        }
+    }
+
+    //BoardState has no move history, assume any king and rook still on their home squares have not moved
+    Bitboard whiteRooks = position->pieces[ROOK] & position->sides[WHITE];
+    Bitboard blackRooks = position->pieces[ROOK] & position->sides[BLACK];
+    if(position->pieces[KING] & position->sides[WHITE] & BITBOARD_SQUARE(60)){
+        if(whiteRooks & BITBOARD_SQUARE(63)) position->castlingRights |= CASTLE_WHITE_KINGSIDE;
+        if(whiteRooks & BITBOARD_SQUARE(56)) position->castlingRights |= CASTLE_WHITE_QUEENSIDE;
+    }
+    if(position->pieces[KING] & position->sides[BLACK] & BITBOARD_SQUARE(4)){
+        if(blackRooks & BITBOARD_SQUARE(7)) position->castlingRights |= CASTLE_BLACK_KINGSIDE;
+        if(blackRooks & BITBOARD_SQUARE(0)) position->castlingRights |= CASTLE_BLACK_QUEENSIDE;
+    }
+
+    position->hash = Position_ComputeHash(position);
+
+}
+
+//Only writes the pieces, the on screen placement of the board is left alone
+void Position_ToBoardState(const Position* position, BoardState* boardState){
+
+    for(int i = 0; i < 64; i++){
+        enum CHESS_PIECE_TYPE type = Position_PieceTypeAt(position, i);
+        boardState->board[i].type = type;
+        if(type != NONE){
+            boardState->board[i].side = Position_PieceSideAt(position, i);
+        }
+    }
+    boardState->hash = position->hash ^ StateHash(position);
+
+}
+
+void Position_PutPiece(Position* position, int index, enum CHESS_SIDE side, enum CHESS_PIECE_TYPE type){
+
+    Bitboard bit = BITBOARD_SQUARE(index);
+    position->pieces[type] |= bit;
+    position->sides[side] |= bit;
+    position->occupied |= bit;
+    position->squares[index] = (unsigned char)type;
+    position->hash ^= zobristPieces[side][type][index];
+
+}
+
+void Position_RemovePiece(Position* position, int index){
+
+    Bitboard bit = BITBOARD_SQUARE(index);
+    position->hash ^= zobristPieces[Position_PieceSideAt(position, index)][position->squares[index]][index];
+    position->pieces[position->squares[index]] &= ~bit;
+    position->sides[WHITE] &= ~bit;
+    position->sides[BLACK] &= ~bit;
+    position->occupied &= ~bit;
+    position->squares[index] = NONE;
+
+}
+
+//Hash-free versions of PutPiece and RemovePiece for unmaking, the hash is restored whole from the undo record
+static inline void SetSquare(Position* position, int index, enum CHESS_SIDE side, enum CHESS_PIECE_TYPE type){
+    Bitboard bit = BITBOARD_SQUARE(index);
+    position->pieces[type] |= bit;
+    position->sides[side] |= bit;
+    position->occupied |= bit;
+    position->squares[index] = (unsigned char)type;
+}
+
+static inline void ClearSquare(Position* position, int index){
+    Bitboard bit = BITBOARD_SQUARE(index);
+    position->pieces[position->squares[index]] &= ~bit;
+    position->sides[WHITE] &= ~bit;
+    position->sides[BLACK] &= ~bit;
+    position->occupied &= ~bit;
+    position->squares[index] = NONE;
+}
+
+void Position_MakeMove(Position* position, Move move, PositionUndo* undo){
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+    enum CHESS_SIDE us = (enum CHESS_SIDE)position->sideToMove;
+    enum CHESS_SIDE them = OppositeChessSide(us);
+    enum CHESS_PIECE_TYPE moving = Position_PieceTypeAt(position, from);
+
+    //White pawns move towards row 0
+    int forward = (us == WHITE) ? -8 : 8;
+
+    undo->hash = position->hash;
+    undo->move = move;
+    undo->captured = NONE;
+    undo->castlingRights = position->castlingRights;
+    undo->enPassantSquare = position->enPassantSquare;
+    undo->halfmoveClock = position->halfmoveClock;
+
+    position->halfmoveClock++;
+    position->hash ^= StateHash(position);
+
+    if(flags == MOVE_FLAG_EN_PASSANT){
+        undo->captured = PAWN;
+        Position_RemovePiece(position, to - forward);
+    }
+    else if(flags & MOVE_FLAG_CAPTURE){
+        undo->captured = position->squares[to];
+        Position_RemovePiece(position, to);
+        position->halfmoveClock = 0;
+    }
+
+    Position_RemovePiece(position, from);
+    Position_PutPiece(position, to, us, (flags & MOVE_FLAG_PROMOTION) ? Move_PromotionType(move) : moving);
+
+    if(flags == MOVE_FLAG_KING_CASTLE){
+        Position_RemovePiece(position, to + 1);
+        Position_PutPiece(position, to - 1, us, ROOK);
+    }
+    else if(flags == MOVE_FLAG_QUEEN_CASTLE){
+        Position_RemovePiece(position, to - 2);
+        Position_PutPiece(position, to + 1, us, ROOK);
+    }
+
+    if(moving == PAWN){
+        position->halfmoveClock = 0;
+    }
+
+    position->enPassantSquare = NO_SQUARE;
+    if(flags == MOVE_FLAG_DOUBLE_PUSH){
+        int skipped = from + forward;
+        if(pawnAttacks[us][skipped] & position->pieces[PAWN] & position->sides[them]){
+            position->enPassantSquare = (unsigned char)skipped;
+        }
+    }
+
+    position->castlingRights &= castlingRightsMask[from] & castlingRightsMask[to];
+
+    if(us == BLACK){
+        position->fullmoveNumber++;
+    }
+    position->sideToMove = (unsigned char)them;
+    position->hash ^= StateHash(position);
+
+    ZOBRIST_DEBUG_CHECK(position->hash, Position_ComputeHash(position));
+
+}
+
+void Position_UnmakeMove(Position* position, const PositionUndo* undo){
+
+    Move move = undo->move;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+    enum CHESS_SIDE them = (enum CHESS_SIDE)position->sideToMove;
+    enum CHESS_SIDE us = OppositeChessSide(them);
+    int forward = (us == WHITE) ? -8 : 8;
+
+    enum CHESS_PIECE_TYPE moved = (flags & MOVE_FLAG_PROMOTION) ? PAWN : Position_PieceTypeAt(position, to);
+    ClearSquare(position, to);
+    SetSquare(position, from, us, moved);
+
+    if(flags == MOVE_FLAG_KING_CASTLE){
+        ClearSquare(position, to - 1);
+        SetSquare(position, to + 1, us, ROOK);
+    }
+    else if(flags == MOVE_FLAG_QUEEN_CASTLE){
+        ClearSquare(position, to + 1);
+        SetSquare(position, to - 2, us, ROOK);
+    }
+
+    if(flags == MOVE_FLAG_EN_PASSANT){
+        SetSquare(position, to - forward, them, PAWN);
+    }
+    else if(undo->captured != NONE){
+        SetSquare(position, to, them, (enum CHESS_PIECE_TYPE)undo->captured);
+    }
+
+    if(us == BLACK){
+        position->fullmoveNumber--;
+    }
+    position->sideToMove = (unsigned char)us;
+    position->castlingRights = undo->castlingRights;
+    position->enPassantSquare = undo->enPassantSquare;
+    position->halfmoveClock = undo->halfmoveClock;
+    position->hash = undo->hash;
+
+    ZOBRIST_DEBUG_CHECK(position->hash, Position_ComputeHash(position));
+
+}
+
+void Position_MakeNullMove(Position* position, PositionUndo* undo){
+
+    undo->hash = position->hash;
+    undo->move = MOVE_NONE;
+    undo->captured = NONE;
+    undo->castlingRights = position->castlingRights;
+    undo->enPassantSquare = position->enPassantSquare;
+    undo->halfmoveClock = position->halfmoveClock;
+
+    position->hash ^= StateHash(position);
+    position->halfmoveClock++;
+    position->enPassantSquare = NO_SQUARE;
+    position->sideToMove ^= 1;
+    position->hash ^= StateHash(position);
+
+    ZOBRIST_DEBUG_CHECK(position->hash, Position_ComputeHash(position));
+
+}
+
+void Position_UnmakeNullMove(Position* position, const PositionUndo* undo){
+
+    position->sideToMove ^= 1;
+    position->enPassantSquare = undo->enPassantSquare;
+    position->halfmoveClock = undo->halfmoveClock;
+    position->hash = undo->hash;
+
+}
+
+Move Position_MoveFromCoordinates(const Position* position, int from, int to, enum CHESS_PIECE_TYPE promotionType){
+
+    enum CHESS_PIECE_TYPE moving = Position_PieceTypeAt(position, from);
+    int flags = MOVE_FLAG_QUIET;
+
+    if(position->occupied & BITBOARD_SQUARE(to)){
+        flags = MOVE_FLAG_CAPTURE;
+    }
+
+    if(moving == PAWN){
+        int toRow = to / 8;
+        if(to - from == 16 || from - to == 16){
+            flags = MOVE_FLAG_DOUBLE_PUSH;
+        }
+        else if(to == position->enPassantSquare && (to - from) % 8 != 0){
+            flags = MOVE_FLAG_EN_PASSANT;
+        }
+        else if(toRow == 0 || toRow == 7){
+            if(promotionType == NONE || promotionType == PAWN || promotionType == KING){
+                promotionType = QUEEN;
+            }
+            flags |= Move_PromotionFlag(promotionType);
+        }
+    }
+    else if(moving == KING){
+        if(to - from == 2) flags = MOVE_FLAG_KING_CASTLE;
+        else if(from - to == 2) flags = MOVE_FLAG_QUEEN_CASTLE;
+    }
+
+    return MOVE_CREATE(from, to, flags);
+
+}
\ No newline at end of file
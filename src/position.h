@@ -0,0 +1,75 @@
+#ifndef H_POSITION
+#define H_POSITION
+
+#include "chess.h"
+#include "bitboard.h"
+#include "move.h"
+
+#define CASTLE_WHITE_KINGSIDE 1
+#define CASTLE_WHITE_QUEENSIDE 2
+#define CASTLE_BLACK_KINGSIDE 4
+#define CASTLE_BLACK_QUEENSIDE 8
+#define CASTLE_ALL 15
+
+#define NO_SQUARE 64
+
+//Compact bitboard representation of a chess position.
+//BoardState is kept for rendering, Position is what the move generators and analysis code work on.
+typedef struct Position{
+
+    Bitboard pieces[KING+1]; //Indexed by CHESS_PIECE_TYPE, pieces[NONE] is always empty
+    Bitboard sides[2];       //Indexed by CHESS_SIDE
+    Bitboard occupied;
+
+    unsigned char squares[64]; //CHESS_PIECE_TYPE on every square for quick lookups
+    unsigned char sideToMove;
+    unsigned char castlingRights;
+    unsigned char enPassantSquare; //Only set when a pawn can actually capture there, NO_SQUARE otherwise
+    unsigned char halfmoveClock;
+    unsigned short fullmoveNumber;
+
+    uint64_t hash; //Zobrist key over pieces, side to move, castling rights and en passant file
+
+} Position;
+
+//What Position_MakeMove can't work out again from the move alone, enough for Position_UnmakeMove to restore the
+//position exactly. 16 bytes, callers keep them in small fixed arrays indexed by ply.
+typedef struct PositionUndo{
+    uint64_t hash;
+    Move move;
+    unsigned char captured; //CHESS_PIECE_TYPE taken by the move, NONE if nothing was
+    unsigned char castlingRights;
+    unsigned char enPassantSquare;
+    unsigned char halfmoveClock;
+} PositionUndo;
+
+void Position_Clear(Position* position);
+//Full Zobrist recompute, Position functions keep position->hash current incrementally
+uint64_t Position_ComputeHash(const Position* position);
+void Position_FromBoardState(Position* position, const BoardState* boardState, enum CHESS_SIDE sideToMove);
+void Position_ToBoardState(const Position* position, BoardState* boardState);
+
+void Position_PutPiece(Position* position, int index, enum CHESS_SIDE side, enum CHESS_PIECE_TYPE type);
+void Position_RemovePiece(Position* position, int index);
+
+//Plays a move produced by the move generator, the move is not checked for legality.
+//undo receives what Position_UnmakeMove needs to take the move back.
+void Position_MakeMove(Position* position, Move move, PositionUndo* undo);
+//Takes back the last move made, with the undo record that move filled in
+void Position_UnmakeMove(Position* position, const PositionUndo* undo);
+//Passes the turn without moving, for null move pruning in the search. Must not be called while in check.
+void Position_MakeNullMove(Position* position, PositionUndo* undo);
+void Position_UnmakeNullMove(Position* position, const PositionUndo* undo);
+//Builds the flagged Move for a from/to pair, working out captures, castling and en passant from the position
+Move Position_MoveFromCoordinates(const Position* position, int from, int to, enum CHESS_PIECE_TYPE promotionType);
+
+static inline enum CHESS_PIECE_TYPE Position_PieceTypeAt(const Position* position, int index){
+    return (enum CHESS_PIECE_TYPE)position->squares[index];
+}
+
+//Only meaningful when the square is occupied
+static inline enum CHESS_SIDE Position_PieceSideAt(const Position* position, int index){
+    return (enum CHESS_SIDE)Bitboard_Test(position->sides[BLACK], index);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,589 @@
+#include "position_index.h"
+#include "movegen.h"
+#include "platform.h"
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Games replayed per task, small enough for the threads to share the archive evenly
+#define POSITION_INDEX_GAMES_PER_TASK 1024
+//Hash ranges merged per thread, so a range with more keys than the others doesn't hold up the rest
+#define POSITION_INDEX_RANGES_PER_THREAD 4
+#define POSITION_INDEX_RADIX_BITS 16
+#define POSITION_INDEX_COPY_SIZE (1024*1024)
+//Runs below this many entries would mean thousands of them, the budget is raised instead
+#define POSITION_INDEX_MIN_RUN_ENTRIES (256*1024)
+
+//Runs are temporary and only read back on the same machine, so entries go to them as they are in memory
+typedef struct IndexEntry{
+    uint64_t hash;
+    uint32_t game;
+    uint32_t result;
+} IndexEntry;
+
+typedef struct RunBuffer{
+    IndexEntry* entries;
+    IndexEntry* scratch;
+    size_t count;
+    size_t capacity;
+    size_t* counts;            //One per radix digit
+    uint64_t games;
+    uint64_t skipped;
+    uint64_t positions;
+} RunBuffer;
+
+typedef struct BuildContext{
+    const GameArchive* archive;
+    const char* path;
+    int maxPlies;
+    RunBuffer* buffers;        //One per thread
+    volatile int32_t runCount;
+    volatile int32_t failed;
+} BuildContext;
+
+typedef struct MappedRun{
+    const IndexEntry* entries;
+    uint64_t count;
+    uint64_t size;
+} MappedRun;
+
+typedef struct MergeContext{
+    const char* path;
+    MappedRun* runs;
+    int runCount;
+    int rangeCount;
+    uint64_t* keyCounts;       //Per range
+    uint64_t* postingCounts;
+    volatile int32_t failed;
+} MergeContext;
+
+//Keys and postings are collected here and written in blocks, a stdio call per 4 byte posting would cost more than the merge
+typedef struct MergeOutput{
+    FILE* file;
+    unsigned char* data;
+    size_t length;
+    int failed;
+} MergeOutput;
+
+typedef struct MergeCursor{
+    const IndexEntry* next;
+    const IndexEntry* end;
+} MergeCursor;
+
+//path with the suffix and number appended, for the run and part files next to the index
+static int TempPath(const char* path, const char* suffix, int number, char* out){
+    int length = snprintf(out, GAME_ARCHIVE_MAX_PATH, "%s.%s%d", path, suffix, number);
+    return length > 0 && length < GAME_ARCHIVE_MAX_PATH;
+}
+
+static int EntryLess(const IndexEntry* a, const IndexEntry* b){
+    return a->hash < b->hash || (a->hash == b->hash && a->game < b->game);
+}
+
+static unsigned RadixDigit(const IndexEntry* entry, int pass){
+    if(pass < 2) return (entry->game >> (pass*POSITION_INDEX_RADIX_BITS)) & ((1u << POSITION_INDEX_RADIX_BITS) - 1);
+    return (unsigned)(entry->hash >> ((pass - 2)*POSITION_INDEX_RADIX_BITS)) & ((1u << POSITION_INDEX_RADIX_BITS) - 1);
+}
+
+//Least significant digit radix sort by game and then hash, each pass is stable so the result is ordered by (hash, game).
+//Threads mostly replay their games in id order, then the entries already are in game order and only the hash is sorted.
+//Passes where every entry has the same digit are skipped too.
+static void SortRun(RunBuffer* buffer){
+
+    int firstPass = 2;
+    for(size_t i = 1; i < buffer->count; i++){
+        if(buffer->entries[i].game < buffer->entries[i-1].game){
+            firstPass = 0;
+            break;
+        }
+    }
+
+    for(int pass = firstPass; pass < 6; pass++){
+
+        memset(buffer->counts, 0, sizeof(size_t) << POSITION_INDEX_RADIX_BITS);
+        for(size_t i = 0; i < buffer->count; i++){
+            buffer->counts[RadixDigit(&buffer->entries[i], pass)]++;
+        }
+        if(buffer->counts[RadixDigit(&buffer->entries[0], pass)] == buffer->count) continue;
+
+        size_t offset = 0;
+        for(size_t digit = 0; digit < ((size_t)1 << POSITION_INDEX_RADIX_BITS); digit++){
+            size_t count = buffer->counts[digit];
+            buffer->counts[digit] = offset;
+            offset += count;
+        }
+        for(size_t i = 0; i < buffer->count; i++){
+            buffer->scratch[buffer->counts[RadixDigit(&buffer->entries[i], pass)]++] = buffer->entries[i];
+        }
+
+        IndexEntry* sorted = buffer->scratch;
+        buffer->scratch = buffer->entries;
+        buffer->entries = sorted;
+
+    }
+
+}
+
+//Sorts the thread's entries and writes them out as the next run. A game's entries all go to the same run, so a position
+//the game reached more than once is dropped to one entry here and every (hash, game) pair is in only one run.
+static int SpillRun(BuildContext* build, RunBuffer* buffer){
+
+    if(buffer->count == 0) return 1;
+    SortRun(buffer);
+
+    size_t unique = 1;
+    for(size_t i = 1; i < buffer->count; i++){
+        if(buffer->entries[i].hash == buffer->entries[unique-1].hash && buffer->entries[i].game == buffer->entries[unique-1].game) continue;
+        buffer->entries[unique++] = buffer->entries[i];
+    }
+    buffer->count = unique;
+
+    char runPath[GAME_ARCHIVE_MAX_PATH];
+    if(!TempPath(build->path, "run", Platform_AtomicFetchAdd(&build->runCount, 1), runPath)) return 0;
+    FILE* file = fopen(runPath, "wb");
+    if(file == NULL) return 0;
+    int written = fwrite(buffer->entries, sizeof(IndexEntry), buffer->count, file) == buffer->count;
+    if(fclose(file) != 0) written = 0;
+    buffer->count = 0;
+    return written;
+
+}
+
+//Adds the entries of every position in the game up to maxPlies. Returns 0 if the game doesn't load or holds an illegal move.
+static int CollectGame(const ArchivedGame* game, int maxPlies, RunBuffer* buffer){
+
+    Position position;
+    if(!ArchivedGame_StartPosition(game, &position)) return 0;
+
+    int plies = maxPlies > 0 && maxPlies < game->moveCount ? maxPlies : game->moveCount;
+    IndexEntry* out = buffer->entries + buffer->count;
+    out->hash = position.hash;
+    out->game = (uint32_t)game->id;
+    out->result = game->result;
+    out++;
+    for(int ply = 0; ply < plies; ply++){
+        Move move = ArchivedGame_Move(game, ply);
+        if(!Position_IsLegalMove(&position, move)) return 0;
+        PositionUndo undo;
+        Position_MakeMove(&position, move, &undo);
+        out->hash = position.hash;
+        out->game = (uint32_t)game->id;
+        out->result = game->result;
+        out++;
+    }
+    buffer->count += (size_t)plies + 1;
+    return 1;
+
+}
+
+static void CollectTask(void* context, int taskIndex, int threadIndex){
+
+    BuildContext* build = (BuildContext*)context;
+    RunBuffer* buffer = &build->buffers[threadIndex];
+
+    uint64_t first = (uint64_t)taskIndex*POSITION_INDEX_GAMES_PER_TASK;
+    for(uint64_t id = first; id < first + POSITION_INDEX_GAMES_PER_TASK && id < build->archive->count; id++){
+        if(build->failed) return;
+
+        ArchivedGame game;
+        if(!GameArchive_Game(build->archive, id, &game)){
+            buffer->skipped++;
+            continue;
+        }
+        //The buffer always has room for the longest game, a full one is written out before the game is replayed
+        int plies = build->maxPlies > 0 && build->maxPlies < game.moveCount ? build->maxPlies : game.moveCount;
+        if(buffer->count + (size_t)plies + 1 > buffer->capacity && !SpillRun(build, buffer)){
+            Platform_AtomicFetchAdd(&build->failed, 1);
+            return;
+        }
+        if(!CollectGame(&game, build->maxPlies, buffer)){
+            buffer->skipped++;
+            continue;
+        }
+        buffer->games++;
+        buffer->positions += (uint64_t)plies + 1;
+    }
+
+}
+
+static void SpillTask(void* context, int taskIndex, int threadIndex){
+
+    (void)threadIndex;
+    BuildContext* build = (BuildContext*)context;
+    if(!SpillRun(build, &build->buffers[taskIndex])) Platform_AtomicFetchAdd(&build->failed, 1);
+
+}
+
+//First entry of the run with a hash of at least hash
+static uint64_t RunLowerBound(const MappedRun* run, uint64_t hash){
+    uint64_t low = 0;
+    uint64_t high = run->count;
+    while(low < high){
+        uint64_t middle = low + (high - low)/2;
+        if(run->entries[middle].hash < hash) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+static uint64_t RangeStart(int range, int rangeCount){
+    return range == 0 ? 0 : (UINT64_MAX / (uint64_t)rangeCount) * (uint64_t)range + 1;
+}
+
+static void SiftDown(MergeCursor* heap, int count, int i){
+    while(1){
+        int smallest = i;
+        int left = i*2 + 1;
+        int right = left + 1;
+        if(left < count && EntryLess(heap[left].next, heap[smallest].next)) smallest = left;
+        if(right < count && EntryLess(heap[right].next, heap[smallest].next)) smallest = right;
+        if(smallest == i) return;
+        MergeCursor swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+static void FlushOutput(MergeOutput* output){
+    if(output->length > 0 && fwrite(output->data, 1, output->length, output->file) != output->length) output->failed = 1;
+    output->length = 0;
+}
+
+//Room for size more bytes at the end of the output
+static unsigned char* ReserveOutput(MergeOutput* output, size_t size){
+    if(output->length + size > POSITION_INDEX_COPY_SIZE) FlushOutput(output);
+    unsigned char* out = output->data + output->length;
+    output->length += size;
+    return out;
+}
+
+static void WriteKey(MergeOutput* keys, uint64_t hash, uint64_t firstPosting, const uint32_t* counts){
+    unsigned char* key = ReserveOutput(keys, POSITION_INDEX_KEY_SIZE);
+    ByteOrder_WriteUint64(key, hash);
+    ByteOrder_WriteUint64(key + 8, firstPosting);
+    for(int i = 0; i < 4; i++){
+        ByteOrder_WriteUint32(key + 16 + i*4, counts[i]);
+    }
+}
+
+//Merges the part of every run inside the task's hash range into a key part and a posting part. Key counts are
+//games, white wins, black wins and draws, posting offsets are from the start of the part until the parts are joined.
+static int MergeRange(MergeContext* merge, int range, MergeOutput* keys, MergeOutput* postings){
+
+    MergeCursor* heap = (MergeCursor*)malloc(sizeof(MergeCursor) * (merge->runCount > 0 ? merge->runCount : 1));
+    if(heap == NULL) return 0;
+
+    int heapCount = 0;
+    for(int i = 0; i < merge->runCount; i++){
+        const MappedRun* run = &merge->runs[i];
+        uint64_t start = RunLowerBound(run, RangeStart(range, merge->rangeCount));
+        uint64_t end = range == merge->rangeCount - 1 ? run->count : RunLowerBound(run, RangeStart(range + 1, merge->rangeCount));
+        if(start == end) continue;
+        heap[heapCount].next = run->entries + start;
+        heap[heapCount].end = run->entries + end;
+        heapCount++;
+    }
+    for(int i = heapCount/2 - 1; i >= 0; i--){
+        SiftDown(heap, heapCount, i);
+    }
+
+    uint64_t keyCount = 0;
+    uint64_t postingCount = 0;
+    uint64_t hash = 0;
+    uint64_t firstPosting = 0;
+    uint32_t counts[4] = { 0, 0, 0, 0 };
+    while(heapCount > 0){
+
+        IndexEntry entry = *heap[0].next;
+        if(++heap[0].next == heap[0].end) heap[0] = heap[--heapCount];
+        SiftDown(heap, heapCount, 0);
+
+        if(counts[0] == 0 || entry.hash != hash){
+            if(counts[0] > 0){
+                WriteKey(keys, hash, firstPosting, counts);
+                keyCount++;
+                memset(counts, 0, sizeof(counts));
+            }
+            hash = entry.hash;
+            firstPosting = postingCount;
+        }
+
+        ByteOrder_WriteUint32(ReserveOutput(postings, POSITION_INDEX_POSTING_SIZE), entry.game);
+        postingCount++;
+        counts[0]++;
+        if(entry.result == GAME_RESULT_WHITE_WINS) counts[1]++;
+        else if(entry.result == GAME_RESULT_BLACK_WINS) counts[2]++;
+        else if(entry.result == GAME_RESULT_DRAW) counts[3]++;
+
+    }
+    if(counts[0] > 0){
+        WriteKey(keys, hash, firstPosting, counts);
+        keyCount++;
+    }
+    FlushOutput(keys);
+    FlushOutput(postings);
+
+    free(heap);
+    merge->keyCounts[range] = keyCount;
+    merge->postingCounts[range] = postingCount;
+    return !keys->failed && !postings->failed;
+
+}
+
+static void MergeTask(void* context, int taskIndex, int threadIndex){
+
+    (void)threadIndex;
+    MergeContext* merge = (MergeContext*)context;
+    char keysPath[GAME_ARCHIVE_MAX_PATH];
+    char postingsPath[GAME_ARCHIVE_MAX_PATH];
+    if(!TempPath(merge->path, "keys", taskIndex, keysPath) || !TempPath(merge->path, "postings", taskIndex, postingsPath)){
+        Platform_AtomicFetchAdd(&merge->failed, 1);
+        return;
+    }
+
+    MergeOutput keys = { fopen(keysPath, "wb"), (unsigned char*)malloc(POSITION_INDEX_COPY_SIZE), 0, 0 };
+    MergeOutput postings = { fopen(postingsPath, "wb"), (unsigned char*)malloc(POSITION_INDEX_COPY_SIZE), 0, 0 };
+    int success = keys.file != NULL && postings.file != NULL && keys.data != NULL && postings.data != NULL
+        && MergeRange(merge, taskIndex, &keys, &postings);
+    if(keys.file != NULL && fclose(keys.file) != 0) success = 0;
+    if(postings.file != NULL && fclose(postings.file) != 0) success = 0;
+    free(keys.data);
+    free(postings.data);
+    if(!success) Platform_AtomicFetchAdd(&merge->failed, 1);
+
+}
+
+//Appends the parts to the index in range order, moving each part's keys to where its postings end up
+static int JoinParts(FILE* out, const MergeContext* merge, unsigned char* buffer){
+
+    uint64_t base = 0;
+    for(int range = 0; range < merge->rangeCount; range++){
+
+        char keysPath[GAME_ARCHIVE_MAX_PATH];
+        TempPath(merge->path, "keys", range, keysPath);
+        FILE* keys = fopen(keysPath, "rb");
+        if(keys == NULL) return 0;
+
+        size_t read;
+        int success = 1;
+        while(success && (read = fread(buffer, POSITION_INDEX_KEY_SIZE, POSITION_INDEX_COPY_SIZE / POSITION_INDEX_KEY_SIZE, keys)) > 0){
+            for(size_t i = 0; i < read; i++){
+                unsigned char* key = buffer + i*POSITION_INDEX_KEY_SIZE;
+                ByteOrder_WriteUint64(key + 8, ByteOrder_ReadUint64(key + 8) + base);
+            }
+            success = fwrite(buffer, POSITION_INDEX_KEY_SIZE, read, out) == read;
+        }
+        fclose(keys);
+        if(!success) return 0;
+        base += merge->postingCounts[range];
+
+    }
+
+    for(int range = 0; range < merge->rangeCount; range++){
+
+        char postingsPath[GAME_ARCHIVE_MAX_PATH];
+        TempPath(merge->path, "postings", range, postingsPath);
+        FILE* postings = fopen(postingsPath, "rb");
+        if(postings == NULL) return 0;
+
+        size_t read;
+        int success = 1;
+        while(success && (read = fread(buffer, 1, POSITION_INDEX_COPY_SIZE, postings)) > 0){
+            success = fwrite(buffer, 1, read, out) == read;
+        }
+        fclose(postings);
+        if(!success) return 0;
+
+    }
+    return 1;
+
+}
+
+static int MergeRuns(const char* path, int threadCount, int runCount, int maxPlies, PositionIndexBuildStats* stats){
+
+    MergeContext merge;
+    merge.path = path;
+    merge.runCount = runCount;
+    merge.rangeCount = threadCount*POSITION_INDEX_RANGES_PER_THREAD;
+    merge.failed = 0;
+    merge.runs = (MappedRun*)calloc(runCount > 0 ? runCount : 1, sizeof(MappedRun));
+    merge.keyCounts = (uint64_t*)calloc(merge.rangeCount, sizeof(uint64_t));
+    merge.postingCounts = (uint64_t*)calloc(merge.rangeCount, sizeof(uint64_t));
+    unsigned char* buffer = (unsigned char*)malloc(POSITION_INDEX_COPY_SIZE);
+    int success = merge.runs != NULL && merge.keyCounts != NULL && merge.postingCounts != NULL && buffer != NULL;
+
+    for(int i = 0; success && i < runCount; i++){
+        char runPath[GAME_ARCHIVE_MAX_PATH];
+        const unsigned char* data;
+        success = TempPath(path, "run", i, runPath) && Platform_MapFile(runPath, &data, &merge.runs[i].size);
+        if(!success) break;
+        merge.runs[i].entries = (const IndexEntry*)data;
+        merge.runs[i].count = merge.runs[i].size / sizeof(IndexEntry);
+    }
+
+    if(success){
+        ThreadPool_Run(threadCount, merge.rangeCount, MergeTask, &merge);
+        success = !merge.failed;
+    }
+
+    if(success){
+        for(int range = 0; range < merge.rangeCount; range++){
+            stats->keys += merge.keyCounts[range];
+            stats->postings += merge.postingCounts[range];
+        }
+
+        unsigned char header[POSITION_INDEX_HEADER_SIZE];
+        memset(header, 0, sizeof(header));
+        memcpy(header, POSITION_INDEX_MAGIC, 4);
+        ByteOrder_WriteUint32(header + 4, POSITION_INDEX_VERSION);
+        ByteOrder_WriteUint64(header + 8, stats->keys);
+        ByteOrder_WriteUint64(header + 16, stats->postings);
+        ByteOrder_WriteUint32(header + 24, (uint32_t)maxPlies);
+
+        FILE* out = fopen(path, "wb");
+        success = out != NULL && fwrite(header, 1, sizeof(header), out) == sizeof(header) && JoinParts(out, &merge, buffer);
+        if(out != NULL && fclose(out) != 0) success = 0;
+        if(!success) remove(path);
+    }
+
+    for(int i = 0; merge.runs != NULL && i < runCount; i++){
+        Platform_UnmapFile((const unsigned char*)merge.runs[i].entries, merge.runs[i].size);
+    }
+    for(int range = 0; range < merge.rangeCount; range++){
+        char partPath[GAME_ARCHIVE_MAX_PATH];
+        if(TempPath(path, "keys", range, partPath)) remove(partPath);
+        if(TempPath(path, "postings", range, partPath)) remove(partPath);
+    }
+    free(merge.runs);
+    free(merge.keyCounts);
+    free(merge.postingCounts);
+    free(buffer);
+    return success;
+
+}
+
+int PositionIndex_Build(const GameArchive* archive, const char* path, int threadCount, int maxPlies, int memoryMegabytes,
+    PositionIndexBuildStats* stats){
+
+    memset(stats, 0, sizeof(PositionIndexBuildStats));
+    if(archive->count > UINT32_MAX) return 0;
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+    if(maxPlies < 0) maxPlies = 0;
+    if(memoryMegabytes <= 0) memoryMegabytes = POSITION_INDEX_DEFAULT_MEMORY_MB;
+
+    //Every entry is held twice while it's sorted
+    size_t capacity = (size_t)memoryMegabytes*1024*1024 / threadCount / (sizeof(IndexEntry)*2);
+    if(capacity < POSITION_INDEX_MIN_RUN_ENTRIES) capacity = POSITION_INDEX_MIN_RUN_ENTRIES;
+
+    BuildContext build;
+    build.archive = archive;
+    build.path = path;
+    build.maxPlies = maxPlies;
+    build.runCount = 0;
+    build.failed = 0;
+    build.buffers = (RunBuffer*)calloc(threadCount, sizeof(RunBuffer));
+    int success = build.buffers != NULL;
+    for(int i = 0; success && i < threadCount; i++){
+        RunBuffer* buffer = &build.buffers[i];
+        buffer->capacity = capacity;
+        buffer->entries = (IndexEntry*)malloc(sizeof(IndexEntry)*capacity);
+        buffer->scratch = (IndexEntry*)malloc(sizeof(IndexEntry)*capacity);
+        buffer->counts = (size_t*)malloc(sizeof(size_t) << POSITION_INDEX_RADIX_BITS);
+        success = buffer->entries != NULL && buffer->scratch != NULL && buffer->counts != NULL;
+    }
+
+    if(success){
+        uint64_t taskCount = (archive->count + POSITION_INDEX_GAMES_PER_TASK - 1) / POSITION_INDEX_GAMES_PER_TASK;
+        ThreadPool_Run(threadCount, (int)taskCount, CollectTask, &build);
+        if(!build.failed) ThreadPool_Run(threadCount, threadCount, SpillTask, &build);
+        success = !build.failed;
+    }
+
+    if(build.buffers != NULL){
+        for(int i = 0; i < threadCount; i++){
+            stats->games += build.buffers[i].games;
+            stats->skipped += build.buffers[i].skipped;
+            stats->positions += build.buffers[i].positions;
+            free(build.buffers[i].entries);
+            free(build.buffers[i].scratch);
+            free(build.buffers[i].counts);
+        }
+    }
+    free(build.buffers);
+    stats->runs = build.runCount;
+
+    if(success) success = MergeRuns(path, threadCount, build.runCount, maxPlies, stats);
+    for(int i = 0; i < build.runCount; i++){
+        char runPath[GAME_ARCHIVE_MAX_PATH];
+        if(TempPath(path, "run", i, runPath)) remove(runPath);
+    }
+    return success;
+
+}
+
+int PositionIndex_Open(PositionIndex* index, const char* path){
+
+    memset(index, 0, sizeof(PositionIndex));
+    if(!Platform_MapFile(path, &index->data, &index->size)) return 0;
+
+    const unsigned char* header = index->data;
+    if(index->size < POSITION_INDEX_HEADER_SIZE || memcmp(header, POSITION_INDEX_MAGIC, 4) != 0
+        || ByteOrder_ReadUint32(header + 4) != POSITION_INDEX_VERSION){
+        PositionIndex_Close(index);
+        return 0;
+    }
+    uint64_t keyCount = ByteOrder_ReadUint64(header + 8);
+    uint64_t postingCount = ByteOrder_ReadUint64(header + 16);
+    uint64_t maxKeys = (index->size - POSITION_INDEX_HEADER_SIZE) / POSITION_INDEX_KEY_SIZE;
+    if(keyCount > maxKeys || postingCount != (index->size - POSITION_INDEX_HEADER_SIZE - keyCount*POSITION_INDEX_KEY_SIZE) / POSITION_INDEX_POSTING_SIZE
+        || (index->size - POSITION_INDEX_HEADER_SIZE - keyCount*POSITION_INDEX_KEY_SIZE) % POSITION_INDEX_POSTING_SIZE != 0){
+        PositionIndex_Close(index);
+        return 0;
+    }
+
+    index->keyCount = keyCount;
+    index->postingCount = postingCount;
+    index->maxPlies = (int)ByteOrder_ReadUint32(header + 24);
+    index->keys = index->data + POSITION_INDEX_HEADER_SIZE;
+    index->postings = index->keys + keyCount*POSITION_INDEX_KEY_SIZE;
+    return 1;
+
+}
+
+void PositionIndex_Close(PositionIndex* index){
+
+    Platform_UnmapFile(index->data, index->size);
+    memset(index, 0, sizeof(PositionIndex));
+
+}
+
+//Zobrist hashes are spread evenly, so the search only touches a few dozen cache lines of the key table
+int PositionIndex_Find(const PositionIndex* index, uint64_t hash, PositionIndexEntry* entry){
+
+    uint64_t low = 0;
+    uint64_t high = index->keyCount;
+    while(low < high){
+        uint64_t middle = low + (high - low)/2;
+        uint64_t middleHash = ByteOrder_ReadUint64(index->keys + middle*POSITION_INDEX_KEY_SIZE);
+        if(middleHash < hash) low = middle + 1;
+        else high = middle;
+    }
+    if(low == index->keyCount) return 0;
+
+    const unsigned char* key = index->keys + low*POSITION_INDEX_KEY_SIZE;
+    if(ByteOrder_ReadUint64(key) != hash) return 0;
+    uint64_t firstPosting = ByteOrder_ReadUint64(key + 8);
+    entry->hash = hash;
+    entry->games = ByteOrder_ReadUint32(key + 16);
+    entry->whiteWins = ByteOrder_ReadUint32(key + 20);
+    entry->blackWins = ByteOrder_ReadUint32(key + 24);
+    entry->draws = ByteOrder_ReadUint32(key + 28);
+    if(firstPosting > index->postingCount || index->postingCount - firstPosting < entry->games) return 0;
+    entry->gameIds = index->postings + firstPosting*POSITION_INDEX_POSTING_SIZE;
+    return 1;
+
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef H_POSITION_INDEX
+#define H_POSITION_INDEX
+
+#include <stdint.h>
+
+#include "game_archive.h"
+#include "byte_order.h"
+
+//Index of every position reached in a game archive, keyed by Zobrist hash, for finding the games that went through
+//a position and how they ended.
+//
+//The file is a 32 byte header (magic, version, key count, posting count, ply limit), the keys sorted by hash and then
+//the postings, every game id of every key back to back. A key is 32 bytes: the hash, the index of its first posting,
+//and the number of games, white wins, black wins and draws. A posting is a 4 byte game id, in increasing order within
+//a key. Numbers are little endian. Readers map the file and binary search the keys, nothing is loaded up front.
+//
+//Building replays the games on the thread pool. Each thread collects (hash, game, result) entries until its share of
+//the memory budget is full, sorts them, drops the repeats of positions a game returned to and writes them out as a run
+//file. The runs are then mapped and merged, split into hash ranges merged in parallel. So the index can be built for
+//archives far larger than memory, the budget only sets how many runs there are.
+//
+//Games are stored by 32 bit id, archives with more than 4 billion games can't be indexed.
+
+#define POSITION_INDEX_MAGIC "TCPI"
+#define POSITION_INDEX_VERSION 1
+#define POSITION_INDEX_HEADER_SIZE 32
+#define POSITION_INDEX_KEY_SIZE 32
+#define POSITION_INDEX_POSTING_SIZE 4
+#define POSITION_INDEX_DEFAULT_MEMORY_MB 256
+
+typedef struct PositionIndex{
+    const unsigned char* data;
+    uint64_t size;
+    const unsigned char* keys;
+    const unsigned char* postings;
+    uint64_t keyCount;
+    uint64_t postingCount;
+    int maxPlies;              //Plies of each game indexed, 0 for all of them
+} PositionIndex;
+
+//What the index holds for one position
+typedef struct PositionIndexEntry{
+    uint64_t hash;
+    uint32_t games;
+    uint32_t whiteWins;
+    uint32_t blackWins;
+    uint32_t draws;
+    const unsigned char* gameIds; //Game ids of 4 bytes, read with PositionIndexEntry_Game
+} PositionIndexEntry;
+
+typedef struct PositionIndexBuildStats{
+    uint64_t games;
+    uint64_t skipped;          //Games that didn't load or held an illegal move
+    uint64_t positions;        //Entries collected, every position of every game
+    uint64_t keys;             //Distinct positions
+    uint64_t postings;         //Game ids stored, repeats within a game removed
+    int runs;
+} PositionIndexBuildStats;
+
+//Indexes the first maxPlies plies of every game in the archive (0 for whole games) into the file at path, replaying and
+//merging on threadCount threads within about memoryMegabytes of memory for the runs. The runs are written next to path
+//and removed once merged. Returns 1 on success, 0 if a file couldn't be written or memory ran out.
+int PositionIndex_Build(const GameArchive* archive, const char* path, int threadCount, int maxPlies, int memoryMegabytes,
+    PositionIndexBuildStats* stats);
+
+//Maps the index at path. Returns 1 on success, 0 if it can't be opened or isn't an index.
+int PositionIndex_Open(PositionIndex* index, const char* path);
+void PositionIndex_Close(PositionIndex* index);
+//Fills entry for the position with that hash. Returns 0 if no indexed game reached it.
+int PositionIndex_Find(const PositionIndex* index, uint64_t hash, PositionIndexEntry* entry);
+
+static inline uint32_t PositionIndexEntry_Game(const PositionIndexEntry* entry, uint32_t i){
+    return ByteOrder_ReadUint32(entry->gameIds + (uint64_t)i*POSITION_INDEX_POSTING_SIZE);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "protocol.h"
+#include "byte_order.h"
+#include "movegen.h"
+
+#include <string.h>
+
+#define SIDE_PAYLOAD_LEN 5
+#define WATCH_PAYLOAD_LEN 4
+#define POSITION_PAYLOAD_LEN 38
+#define MOVE_PAYLOAD_LEN 2
+#define SYNC_PAYLOAD_LEN 10
+
+int Protocol_Encode(unsigned char* out, int type, const void* payload, int length){
+
+    ByteOrder_WriteUint16(out, (uint16_t)length);
+    out[2] = PROTOCOL_VERSION;
+    out[3] = (unsigned char)type;
+    if(length > 0) memcpy(out + PROTOCOL_HEADER_LEN, payload, length);
+    return PROTOCOL_HEADER_LEN + length;
+
+}
+
+int Protocol_Write(RingBuffer* ringBuffer, int type, const void* payload, int length){
+
+    unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+    int frameLength = Protocol_Encode(frame, type, payload, length);
+    return RingBuffer_Write(ringBuffer, frame, frameLength);
+
+}
+
+int Protocol_Read(RingBuffer* ringBuffer, ProtocolMessage* message){
+
+    if(RingBuffer_Length(ringBuffer) < PROTOCOL_HEADER_LEN) return PROTOCOL_INCOMPLETE;
+
+    unsigned char header[PROTOCOL_HEADER_LEN];
+    RingBuffer_Peek(ringBuffer, 0, header, PROTOCOL_HEADER_LEN);
+    int length = ByteOrder_ReadUint16(header);
+    if(header[2] != PROTOCOL_VERSION || length > PROTOCOL_MAX_PAYLOAD) return PROTOCOL_MALFORMED;
+
+    if(RingBuffer_Length(ringBuffer) < PROTOCOL_HEADER_LEN + length) return PROTOCOL_INCOMPLETE;
+
+    message->type = header[3];
+    message->length = length;
+    RingBuffer_Peek(ringBuffer, PROTOCOL_HEADER_LEN, message->payload, length);
+    RingBuffer_Consume(ringBuffer, PROTOCOL_HEADER_LEN + length);
+    return PROTOCOL_MESSAGE;
+
+}
+
+int Protocol_EncodeSide(unsigned char* payload, enum CHESS_SIDE side, uint32_t game){
+    payload[0] = (unsigned char)side;
+    ByteOrder_WriteUint32(payload + 1, game);
+    return SIDE_PAYLOAD_LEN;
+}
+
+int Protocol_DecodeSide(const ProtocolMessage* message, enum CHESS_SIDE* side, uint32_t* game){
+    if(message->length != SIDE_PAYLOAD_LEN || message->payload[0] > BLACK) return 0;
+    *side = (enum CHESS_SIDE)message->payload[0];
+    *game = ByteOrder_ReadUint32(message->payload + 1);
+    return 1;
+}
+
+int Protocol_EncodeWatch(unsigned char* payload, uint32_t game){
+    ByteOrder_WriteUint32(payload, game);
+    return WATCH_PAYLOAD_LEN;
+}
+
+int Protocol_DecodeWatch(const ProtocolMessage* message, uint32_t* game){
+    if(message->length != WATCH_PAYLOAD_LEN) return 0;
+    *game = ByteOrder_ReadUint32(message->payload);
+    return 1;
+}
+
+int Protocol_EncodePosition(unsigned char* payload, const Position* position){
+
+    //Piece type in the low three bits and the side above them, two squares to a byte
+    for(int i = 0; i < 32; i++){
+        unsigned char squares[2];
+        for(int j = 0; j < 2; j++){
+            int index = i*2 + j;
+            enum CHESS_PIECE_TYPE type = Position_PieceTypeAt(position, index);
+            squares[j] = (unsigned char)(type == NONE ? 0 : (type | (Position_PieceSideAt(position, index) << 3)));
+        }
+        payload[i] = (unsigned char)(squares[0] | (squares[1] << 4));
+    }
+    payload[32] = position->sideToMove;
+    payload[33] = position->castlingRights;
+    payload[34] = position->enPassantSquare;
+    payload[35] = position->halfmoveClock;
+    ByteOrder_WriteUint16(payload + 36, position->fullmoveNumber);
+    return POSITION_PAYLOAD_LEN;
+
+}
+
+int Protocol_DecodePosition(const ProtocolMessage* message, Position* position){
+
+    const unsigned char* payload = message->payload;
+    if(message->length != POSITION_PAYLOAD_LEN) return 0;
+    if(payload[32] > BLACK || payload[33] > CASTLE_ALL || payload[34] > NO_SQUARE) return 0;
+
+    Position_Clear(position);
+    for(int index = 0; index < 64; index++){
+        int square = (payload[index / 2] >> ((index & 1) * 4)) & 0xF;
+        int type = square & 7;
+        if(type > KING) return 0;
+        if(type != NONE) Position_PutPiece(position, index, (enum CHESS_SIDE)(square >> 3), (enum CHESS_PIECE_TYPE)type);
+    }
+    position->sideToMove = payload[32];
+    position->castlingRights = payload[33];
+    position->enPassantSquare = payload[34];
+    position->halfmoveClock = payload[35];
+    position->fullmoveNumber = ByteOrder_ReadUint16(payload + 36);
+    //Peers are held to the same rules as fens, anything else would trip up the move generator
+    if(!Position_IsValid(position)) return 0;
+    position->hash = Position_ComputeHash(position);
+    return 1;
+
+}
+
+int Protocol_EncodeMove(unsigned char* payload, Move move){
+    Move_Encode(move, payload);
+    return MOVE_PAYLOAD_LEN;
+}
+
+int Protocol_DecodeMove(const ProtocolMessage* message, Move* move){
+    if(message->length != MOVE_PAYLOAD_LEN) return 0;
+    *move = Move_Decode(message->payload);
+    return 1;
+}
+
+int Protocol_EncodeSync(unsigned char* payload, int plies, uint64_t hash){
+
+    ByteOrder_WriteUint16(payload, (uint16_t)plies);
+    ByteOrder_WriteUint64(payload + 2, hash);
+    return SYNC_PAYLOAD_LEN;
+
+}
+
+int Protocol_DecodeSync(const ProtocolMessage* message, int* plies, uint64_t* hash){
+
+    const unsigned char* payload = message->payload;
+    if(message->length != SYNC_PAYLOAD_LEN) return 0;
+
+    *plies = ByteOrder_ReadUint16(payload);
+    *hash = ByteOrder_ReadUint64(payload + 2);
+    return 1;
+
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef H_PROTOCOL
+#define H_PROTOCOL
+
+#include <stdint.h>
+
+#include "chess.h"
+#include "move.h"
+#include "position.h"
+#include "data_structures/ring_buffer.h"
+
+//Wire format between players and the server. Every message is one frame:
+//
+//  uint16 payload length, uint8 version, uint8 type, payload
+//
+//Multi byte fields are little endian whatever the machine, so builds on any compiler or cpu talk to each other.
+//A receiver queues whatever recv returns in a RingBuffer and takes complete frames off the front, which copes
+//with frames split over reads and many frames in one read alike.
+
+#define PROTOCOL_VERSION 1
+#define PROTOCOL_HEADER_LEN 4
+#define PROTOCOL_MAX_PAYLOAD 64
+#define PROTOCOL_MAX_FRAME_LEN (PROTOCOL_HEADER_LEN + PROTOCOL_MAX_PAYLOAD)
+
+enum PROTOCOL_MESSAGE_TYPE{
+    MESSAGE_SIDE = 1,    //Server to player, uint8 CHESS_SIDE the player has, uint32 game number spectators can ask for
+    MESSAGE_MOVE,        //The sender's Move in its two byte Move_Encode form
+    MESSAGE_RESIGN,      //No payload, the game is over
+    MESSAGE_DRAW_OFFER,  //No payload
+    MESSAGE_DRAW_ACCEPT, //No payload, answers an offer and ends the game
+    MESSAGE_SYNC,        //uint16 plies played, uint64 position hash after them, lets the peer detect a desync
+    MESSAGE_ERROR,       //Text saying why the sender is ending the game, not null terminated
+    MESSAGE_WATCH,       //Spectator to server, uint32 game number to watch
+    MESSAGE_POSITION     //Server to spectator, the game's position when it started watching. Every message the players
+                         //exchange after it follows.
+};
+
+//Protocol_Read results
+#define PROTOCOL_INCOMPLETE 0
+#define PROTOCOL_MESSAGE 1
+#define PROTOCOL_MALFORMED -1 //Unknown version or oversized frame, the stream can't be trusted past it
+
+typedef struct ProtocolMessage{
+    int type;
+    int length;
+    unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+} ProtocolMessage;
+
+//Writes a frame to out, which needs PROTOCOL_HEADER_LEN + length bytes, and returns its size
+int Protocol_Encode(unsigned char* out, int type, const void* payload, int length);
+//Queues a frame, returns 0 without queuing anything if there's no room
+int Protocol_Write(RingBuffer* ringBuffer, int type, const void* payload, int length);
+//Takes the next complete frame off the front of ringBuffer
+int Protocol_Read(RingBuffer* ringBuffer, ProtocolMessage* message);
+
+//Typed payloads. The encoders return the payload length, the decoders 0 if the payload is the wrong size or out of range.
+int Protocol_EncodeSide(unsigned char* payload, enum CHESS_SIDE side, uint32_t game);
+int Protocol_DecodeSide(const ProtocolMessage* message, enum CHESS_SIDE* side, uint32_t* game);
+int Protocol_EncodeWatch(unsigned char* payload, uint32_t game);
+int Protocol_DecodeWatch(const ProtocolMessage* message, uint32_t* game);
+//Every square packed into a nibble, then side to move, castling rights, en passant square and the move counters
+int Protocol_EncodePosition(unsigned char* payload, const Position* position);
+int Protocol_DecodePosition(const ProtocolMessage* message, Position* position);
+int Protocol_EncodeMove(unsigned char* payload, Move move);
+int Protocol_DecodeMove(const ProtocolMessage* message, Move* move);
+int Protocol_EncodeSync(unsigned char* payload, int plies, uint64_t hash);
+int Protocol_DecodeSync(const ProtocolMessage* message, int* plies, uint64_t* hash);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "renderer.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Unchanged cells this close to the next change are rewritten rather than jumped over, it's shorter than a cursor move
+#define RENDER_MAX_SKIP_REWRITE 4
+
+//Most bytes one changed cell can add to a frame: a cursor move or skipped cells, both colors and the glyph
+#define RENDER_MAX_CELL_BYTES 40
+//Synchronized update markers, the full repaint prefix and the closing style reset
+#define RENDER_FRAME_OVERHEAD 64
+
+#define SYNC_BEGIN "\x1B[?2026h"
+#define SYNC_END "\x1B[?2026l"
+
+static int SameCell(const RenderCell* a, const RenderCell* b){
+    return a->glyph == b->glyph && a->foreground == b->foreground && a->background == b->background;
+}
+
+static void BlankCells(RenderCell* cells, int count){
+    for(int i = 0; i < count; i++){
+        cells[i].glyph = ' ';
+        cells[i].foreground = RENDER_COLOR_DEFAULT;
+        cells[i].background = RENDER_COLOR_DEFAULT;
+    }
+}
+
+int Renderer_Init(Renderer* renderer, int columns, int rows){
+
+    memset(renderer, 0, sizeof(Renderer));
+    renderer->synchronizedUpdates = 1;
+    return Renderer_Resize(renderer, columns, rows);
+
+}
+
+void Renderer_Free(Renderer* renderer){
+
+    free(renderer->back);
+    free(renderer->front);
+    free(renderer->output);
+    renderer->back = NULL;
+    renderer->front = NULL;
+    renderer->output = NULL;
+    renderer->outputCapacity = 0;
+    renderer->columns = 0;
+    renderer->rows = 0;
+
+}
+
+int Renderer_Resize(Renderer* renderer, int columns, int rows){
+
+    Renderer_Free(renderer);
+    if(columns < 0) columns = 0;
+    if(rows < 0) rows = 0;
+
+    size_t count = (size_t)columns * rows;
+    renderer->back = (RenderCell*)malloc(sizeof(RenderCell) * (count ? count : 1));
+    renderer->front = (RenderCell*)malloc(sizeof(RenderCell) * (count ? count : 1));
+    size_t capacity = count * RENDER_MAX_CELL_BYTES + RENDER_FRAME_OVERHEAD;
+    renderer->output = (char*)malloc(capacity);
+    if(renderer->back == NULL || renderer->front == NULL || renderer->output == NULL){
+        Renderer_Free(renderer);
+        return 0;
+    }
+    renderer->outputCapacity = (int)capacity;
+
+    renderer->columns = columns;
+    renderer->rows = rows;
+    renderer->frontValid = 0;
+    Renderer_Clear(renderer);
+    return 1;
+
+}
+
+void Renderer_Clear(Renderer* renderer){
+
+    BlankCells(renderer->back, renderer->columns * renderer->rows);
+    renderer->penX = 0;
+    renderer->penY = 0;
+    renderer->penForeground = RENDER_COLOR_DEFAULT;
+    renderer->penBackground = RENDER_COLOR_DEFAULT;
+
+}
+
+void Renderer_MoveTo(Renderer* renderer, int x, int y){
+    renderer->penX = x;
+    renderer->penY = y;
+}
+
+void Renderer_SetColors(Renderer* renderer, int foreground, int background){
+    renderer->penForeground = (unsigned short)foreground;
+    renderer->penBackground = (unsigned short)background;
+}
+
+void Renderer_Print(Renderer* renderer, const char* text){
+
+    int y = renderer->penY;
+    for(; *text; text++, renderer->penX++){
+        int x = renderer->penX;
+        if(x < 0 || x >= renderer->columns || y < 0 || y >= renderer->rows) continue;
+        RenderCell* cell = &renderer->back[y * renderer->columns + x];
+        cell->glyph = *text;
+        cell->foreground = renderer->penForeground;
+        cell->background = renderer->penBackground;
+    }
+
+}
+
+void Renderer_Blit(Renderer* renderer, int x, int y, const RenderCell* cells, int width, int height){
+
+    //Clip the block to the grid once, then every row is a single copy
+    int left = x < 0 ? -x : 0;
+    int right = (x + width > renderer->columns) ? renderer->columns - x : width;
+    if(left >= right) return;
+
+    for(int row = 0; row < height; row++){
+        if(y + row < 0 || y + row >= renderer->rows) continue;
+        memcpy(&renderer->back[(y + row) * renderer->columns + x + left], &cells[row * width + left], sizeof(RenderCell) * (right - left));
+    }
+
+}
+
+//The output buffer is sized for the worst case frame so appends never check for room
+static void Append(Renderer* renderer, const char* text, int length){
+    memcpy(renderer->output + renderer->outputLength, text, length);
+    renderer->outputLength += length;
+}
+
+static void AppendString(Renderer* renderer, const char* text){
+    Append(renderer, text, (int)strlen(text));
+}
+
+static void AppendNumber(Renderer* renderer, int number){
+
+    char digits[12];
+    int length = 0;
+    do{
+        digits[length++] = (char)('0' + number % 10);
+        number /= 10;
+    }while(number > 0);
+
+    while(length > 0){
+        renderer->output[renderer->outputLength++] = digits[--length];
+    }
+
+}
+
+static void AppendCursorMove(Renderer* renderer, int x, int y){
+    AppendString(renderer, "\x1B[");
+    AppendNumber(renderer, y + 1);
+    renderer->output[renderer->outputLength++] = ';';
+    AppendNumber(renderer, x + 1);
+    renderer->output[renderer->outputLength++] = 'H';
+}
+
+static void AppendColor(Renderer* renderer, int foreground, unsigned short color){
+
+    if(color == RENDER_COLOR_DEFAULT){
+        AppendString(renderer, foreground ? "\x1B[39m" : "\x1B[49m");
+        return;
+    }
+    AppendString(renderer, foreground ? "\x1B[38;5;" : "\x1B[48;5;");
+    AppendNumber(renderer, color);
+    renderer->output[renderer->outputLength++] = 'm';
+
+}
+
+//Hands the whole frame to the terminal, normally in one write. Returns the number of writes it took.
+static int WriteOutput(Renderer* renderer){
+
+    int writes = 0;
+    int written = 0;
+    while(written < renderer->outputLength){
+        int result = Platform_WriteStdout(renderer->output + written, renderer->outputLength - written);
+        writes++;
+        if(result <= 0) break;
+        written += result;
+    }
+    return writes;
+
+}
+
+void Renderer_Present(Renderer* renderer){
+
+    int columns = renderer->columns;
+
+    renderer->outputLength = 0;
+    if(renderer->synchronizedUpdates) AppendString(renderer, SYNC_BEGIN);
+    int emptyLength = renderer->outputLength;
+
+    //Nothing is known about the screen yet, start from a cleared one which is all default blanks.
+    //The cursor is hidden again too, the terminal shows it after some resizes.
+    if(!renderer->frontValid){
+        AppendString(renderer, "\x1B[0m\x1B[2J\x1B[?25l");
+        BlankCells(renderer->front, columns * renderer->rows);
+        renderer->frontValid = 1;
+    }
+    //Terminal state as far as what's been written goes, -1 for unknown
+    int cursorX = -1, cursorY = -1;
+    int foreground = -1, background = -1;
+
+    for(int y = 0; y < renderer->rows; y++){
+
+        RenderCell* back = &renderer->back[y * columns];
+        RenderCell* front = &renderer->front[y * columns];
+
+        for(int x = 0; x < columns; x++){
+
+            if(SameCell(&back[x], &front[x])) continue;
+
+            //Rewrite a short run of unchanged cells to get here if their colors match, otherwise jump
+            int skipped = x - cursorX;
+            int rewrite = cursorX >= 0 && cursorY == y && skipped > 0 && skipped <= RENDER_MAX_SKIP_REWRITE;
+            for(int i = cursorX; rewrite && i < x; i++){
+                rewrite = back[i].foreground == foreground && back[i].background == background;
+            }
+            if(rewrite){
+                for(int i = cursorX; i < x; i++) renderer->output[renderer->outputLength++] = back[i].glyph;
+            }
+            else if(cursorX != x || cursorY != y){
+                AppendCursorMove(renderer, x, y);
+            }
+
+            if(back[x].foreground != foreground){
+                foreground = back[x].foreground;
+                AppendColor(renderer, 1, back[x].foreground);
+            }
+            if(back[x].background != background){
+                background = back[x].background;
+                AppendColor(renderer, 0, back[x].background);
+            }
+            renderer->output[renderer->outputLength++] = back[x].glyph;
+            front[x] = back[x];
+
+            //Where the cursor sits after writing the last column differs between terminals
+            cursorX = (x + 1 < columns) ? x + 1 : -1;
+            cursorY = y;
+
+        }
+
+    }
+
+    renderer->frameBytes = 0;
+    renderer->frameWrites = 0;
+    if(renderer->outputLength == emptyLength){
+        return;
+    }
+
+    AppendString(renderer, "\x1B[0m");
+    if(renderer->synchronizedUpdates) AppendString(renderer, SYNC_END);
+
+    fflush(stdout);
+    renderer->frameBytes = renderer->outputLength;
+    renderer->frameWrites = WriteOutput(renderer);
+    renderer->frames++;
+    renderer->totalBytes += renderer->frameBytes;
+    renderer->totalWrites += renderer->frameWrites;
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef H_RENDERER
+#define H_RENDERER
+
+//Double buffered cell grid for the terminal. Everything is drawn into the back buffer, Renderer_Present
+//then compares it with the front buffer (what the terminal already shows) and writes escape sequences
+//for the changed cells only. A frame is assembled in one byte buffer and handed to the terminal in a
+//single write, wrapped in synchronized update markers so the terminal never shows half of it.
+
+#include <stdint.h>
+
+#define RENDER_COLOR_DEFAULT 256 //The terminal's own color, anything below is a 256 color palette index
+
+typedef struct RenderCell{
+    char glyph;
+    unsigned short foreground;
+    unsigned short background;
+} RenderCell;
+
+typedef struct Renderer{
+
+    int columns;
+    int rows;
+    RenderCell* back;  //Frame being drawn
+    RenderCell* front; //Frame on screen
+    int frontValid;    //0 until the first present and after a resize, the next present clears and repaints
+
+    //Bytes of the frame being presented, sized for the worst case frame of the grid
+    char* output;
+    int outputLength;
+    int outputCapacity;
+
+    //Wraps frames in DEC mode 2026 begin/end markers, terminals without it ignore them. On by default.
+    int synchronizedUpdates;
+
+    //Cost of the last presented frame and totals since init, frames with nothing to change write nothing
+    int frameBytes;
+    int frameWrites;
+    uint64_t frames;
+    uint64_t totalBytes;
+    uint64_t totalWrites;
+
+    //Pen used by the drawing calls
+    int penX;
+    int penY;
+    unsigned short penForeground;
+    unsigned short penBackground;
+
+} Renderer;
+
+//Returns 1 on success, 0 if out of memory
+int Renderer_Init(Renderer* renderer, int columns, int rows);
+void Renderer_Free(Renderer* renderer);
+//Reallocates the buffers, the next present repaints the whole screen. Returns 0 if out of memory.
+int Renderer_Resize(Renderer* renderer, int columns, int rows);
+
+//Blanks the back buffer with default colors
+void Renderer_Clear(Renderer* renderer);
+
+//Cells are 0 based, anything drawn outside the grid is clipped
+void Renderer_MoveTo(Renderer* renderer, int x, int y);
+void Renderer_SetColors(Renderer* renderer, int foreground, int background);
+//Writes text at the pen and moves the pen past it
+void Renderer_Print(Renderer* renderer, const char* text);
+//Copies a width by height block of ready made cells, rows stored one after the other, with its top left at x, y
+void Renderer_Blit(Renderer* renderer, int x, int y, const RenderCell* cells, int width, int height);
+
+//Brings the terminal up to date with the back buffer. Pending stdio output is flushed first so it lands before the frame.
+void Renderer_Present(Renderer* renderer);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "san.h"
+#include "movegen.h"
+#include "attacks.h"
+
+static const char pieceLetters[KING+1] = { [NONE] = '?', [PAWN] = 'P', [KNIGHT] = 'N', [ROOK] = 'R', [BISHOP] = 'B', [QUEEN] = 'Q', [KING] = 'K' };
+
+static enum CHESS_PIECE_TYPE PieceFromLetter(char letter){
+    switch(letter){
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default: return NONE;
+    }
+}
+
+//Squares a piece of that type on to would attack, which are the squares the same piece could come from
+static Bitboard PieceReach(const Position* position, enum CHESS_PIECE_TYPE type, int to){
+    switch(type){
+        case KNIGHT: return knightAttacks[to];
+        case BISHOP: return Attacks_Bishop(to, position->occupied);
+        case ROOK: return Attacks_Rook(to, position->occupied);
+        case QUEEN: return Attacks_Queen(to, position->occupied);
+        case KING: return kingAttacks[to];
+        default: return BITBOARD_EMPTY;
+    }
+}
+
+static Move Castle(const Position* position, int queenside){
+    Bitboard king = position->pieces[KING] & position->sides[position->sideToMove];
+    if(king == BITBOARD_EMPTY) return MOVE_NONE;
+    int from = Bitboard_LSB(king);
+    int to = queenside ? from - 2 : from + 2;
+    if(to < 0 || to > 63) return MOVE_NONE;
+    Move move = Position_MoveFromCoordinates(position, from, to, NONE);
+    return Position_IsLegalMove(position, move) ? move : MOVE_NONE;
+}
+
+//Only the pieces that could reach the square are tried, each with the single move legality check,
+//so no move list is generated
+Move Position_MoveFromSan(const Position* position, const char* san, int length){
+
+    //Check, mate and annotations trail the move
+    while(length > 0 && (san[length-1] == '+' || san[length-1] == '#' || san[length-1] == '!' || san[length-1] == '?')){
+        length--;
+    }
+    if(length < 2) return MOVE_NONE;
+
+    if(san[0] == 'O' || san[0] == '0'){
+        if(length == 3 && san[1] == '-' && san[2] == san[0]) return Castle(position, 0);
+        if(length == 5 && san[1] == '-' && san[2] == san[0] && san[3] == '-' && san[4] == san[0]) return Castle(position, 1);
+        return MOVE_NONE;
+    }
+
+    enum CHESS_PIECE_TYPE promotionType = NONE;
+    if(length >= 2 && PieceFromLetter(san[length-1]) != NONE && PieceFromLetter(san[length-1]) != KING){
+        promotionType = PieceFromLetter(san[length-1]);
+        length -= san[length-2] == '=' ? 2 : 1;
+    }
+
+    enum CHESS_PIECE_TYPE type = PieceFromLetter(san[0]);
+    int start = type == NONE ? 0 : 1;
+    if(type == NONE) type = PAWN;
+    if(promotionType != NONE && type != PAWN) return MOVE_NONE;
+
+    //The destination is always the last two chars, anything between the piece and it narrows down where it came from
+    if(length - start < 2) return MOVE_NONE;
+    char toFile = san[length-2];
+    char toRank = san[length-1];
+    if(toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') return MOVE_NONE;
+    int to = (toFile - 'a') + ('8' - toRank)*8;
+
+    int end = length - 2;
+    if(end > start && san[end-1] == 'x') end--;
+    Bitboard fromMask = ~BITBOARD_EMPTY;
+    for(int i = start; i < end; i++){
+        if(san[i] >= 'a' && san[i] <= 'h') fromMask &= BITBOARD_FILE_A << (san[i] - 'a');
+        else if(san[i] >= '1' && san[i] <= '8') fromMask &= BITBOARD_ROW('8' - san[i]);
+        else return MOVE_NONE;
+    }
+
+    int side = position->sideToMove;
+    Bitboard own = position->pieces[type] & position->sides[side];
+    Bitboard candidates;
+    if(type == PAWN){
+        //Captures come diagonally, pushes from one or two squares straight behind
+        int behind = side == WHITE ? 8 : -8;
+        candidates = pawnAttacks[side ^ 1][to] & own;
+        if(!(position->occupied & BITBOARD_SQUARE(to))){
+            int single = to + behind;
+            int twice = to + behind*2;
+            if(single >= 0 && single < 64){
+                if(own & BITBOARD_SQUARE(single)) candidates |= BITBOARD_SQUARE(single);
+                else if(twice >= 0 && twice < 64 && !(position->occupied & BITBOARD_SQUARE(single))) candidates |= own & BITBOARD_SQUARE(twice);
+            }
+        }
+        //The promotion piece has to be named
+        int toRow = to / 8;
+        if((toRow == 0 || toRow == 7) != (promotionType != NONE)) return MOVE_NONE;
+    }
+    else{
+        candidates = PieceReach(position, type, to) & own;
+    }
+    candidates &= fromMask;
+
+    Move found = MOVE_NONE;
+    while(candidates){
+        int from = Bitboard_PopLSB(&candidates);
+        Move move = Position_MoveFromCoordinates(position, from, to, promotionType);
+        if(!Position_IsLegalMove(position, move)) continue;
+        if(found != MOVE_NONE) return MOVE_NONE;
+        found = move;
+    }
+    return found;
+
+}
+
+static int WriteSquare(char* buffer, int index){
+    buffer[0] = (char)('a' + index % 8);
+    buffer[1] = (char)('8' - index / 8);
+    return 2;
+}
+
+int Position_MoveToSan(const Position* position, Move move, char* buffer){
+
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+    enum CHESS_PIECE_TYPE type = Position_PieceTypeAt(position, from);
+    int length = 0;
+
+    if(flags == MOVE_FLAG_KING_CASTLE || flags == MOVE_FLAG_QUEEN_CASTLE){
+        const char* castle = flags == MOVE_FLAG_KING_CASTLE ? "O-O" : "O-O-O";
+        while(*castle) buffer[length++] = *castle++;
+    }
+    else if(type == PAWN){
+        if(MOVE_IS_CAPTURE(move) || flags == MOVE_FLAG_EN_PASSANT){
+            buffer[length++] = (char)('a' + from % 8);
+            buffer[length++] = 'x';
+        }
+        length += WriteSquare(buffer + length, to);
+        if(MOVE_IS_PROMOTION(move)){
+            buffer[length++] = '=';
+            buffer[length++] = pieceLetters[Move_PromotionType(move)];
+        }
+    }
+    else{
+        buffer[length++] = pieceLetters[type];
+
+        //Other pieces of the same kind that could legally go to the same square decide how much of the origin is written
+        Bitboard others = PieceReach(position, type, to) & position->pieces[type] & position->sides[position->sideToMove] & ~BITBOARD_SQUARE(from);
+        int sameFile = 0, sameRow = 0, ambiguous = 0;
+        while(others){
+            int other = Bitboard_PopLSB(&others);
+            if(!Position_IsLegalMove(position, Position_MoveFromCoordinates(position, other, to, NONE))) continue;
+            ambiguous = 1;
+            sameFile |= other % 8 == from % 8;
+            sameRow |= other / 8 == from / 8;
+        }
+        if(ambiguous && (!sameFile || sameRow)) buffer[length++] = (char)('a' + from % 8);
+        if(ambiguous && sameFile) buffer[length++] = (char)('8' - from / 8);
+
+        if(MOVE_IS_CAPTURE(move)) buffer[length++] = 'x';
+        length += WriteSquare(buffer + length, to);
+    }
+
+    Position after = *position;
+    PositionUndo undo;
+    Position_MakeMove(&after, move, &undo);
+    if(Position_InCheck(&after)){
+        MoveList replies;
+        Position_GenerateLegalMoves(&after, &replies);
+        buffer[length++] = replies.length == 0 ? '#' : '+';
+    }
+    buffer[length] = '\0';
+    return length;
+
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef H_SAN
+#define H_SAN
+
+#include "position.h"
+
+#define SAN_MAX_LENGTH 8 //Qh4xe1# and exd8=Q# are the longest, 7 chars and the terminator
+
+//Standard algebraic notation, the move text of PGN files.
+
+//Resolves the length chars of san (Nf3, exd5, e8=Q, O-O-O, Rad1+, Nbd7!?) to the legal move it names. Check,
+//mate and annotation marks are ignored, 0-0 is read as O-O. Returns MOVE_NONE if no legal move or more than one matches.
+Move Position_MoveFromSan(const Position* position, const char* san, int length);
+//Writes move, a legal move in position, as null terminated SAN with its check or mate mark into buffer, which needs
+//SAN_MAX_LENGTH bytes. Returns the length.
+int Position_MoveToSan(const Position* position, Move move, char* buffer);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,573 @@
+#include "search.h"
+#include "movegen.h"
+#include "evaluate.h"
+#include "platform.h"
+#include "data_structures/move_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//Move ordering scores, the transposition table move first then captures by most valuable victim and
+//least valuable attacker, then the two killer moves and last the quiet moves by history
+#define ORDER_TT_MOVE 4000000
+#define ORDER_CAPTURE 2000000
+#define ORDER_KILLER_FIRST 1900000
+#define ORDER_KILLER_SECOND 1800000
+#define HISTORY_MAX 1000000
+
+//Victim and attacker order for MVV-LVA, the piece type enum isn't in value order
+static const int captureOrder[KING+1] = { [PAWN] = 1, [KNIGHT] = 2, [BISHOP] = 3, [ROOK] = 4, [QUEEN] = 5, [KING] = 6 };
+
+#define CHECK_LIMITS_INTERVAL 1024
+#define ASPIRATION_WINDOW 30
+#define ASPIRATION_MIN_DEPTH 5
+
+typedef struct SearchThread SearchThread;
+
+//What the threads of one search have in common. Lazy SMP, every thread searches the whole tree from the root
+//and they help each other only through the transposition table they all read and write.
+typedef struct SearchShared{
+    TranspositionTable* table;
+    const SearchLimits* limits;
+    uint64_t startNs;
+    volatile int stop;
+    int threadCount;
+    SearchThread* threads[SEARCH_MAX_THREADS];
+} SearchShared;
+
+//Everything one search thread needs, nothing is kept in globals so several of these can search at once
+struct SearchThread{
+
+    SearchShared* shared;
+    TranspositionTable* table;
+    int index; //Thread 0 is the main thread, it checks the limits, reports and its result is the one returned
+    volatile uint64_t nodes;
+    int stopped;
+    SearchResult result;
+
+    Move killers[SEARCH_MAX_PLY][2];
+    int history[2][64][64]; //[side][from][to] of quiet moves that caused cutoffs
+
+    Move pv[SEARCH_MAX_PLY][SEARCH_MAX_PLY];
+    int pvLength[SEARCH_MAX_PLY];
+
+    //Hashes of the game positions before the root followed by those on the current search path
+    uint64_t keys[SEARCH_MAX_HISTORY + SEARCH_MAX_PLY];
+    int keyCount;
+
+    //The thread's own copy of the root, walked with make and unmake
+    Position position;
+    PositionUndo undo[SEARCH_MAX_PLY];
+
+};
+
+//Mate scores are stored relative to the node rather than the root so they stay right when reached by another path
+static int ScoreToTable(int score, int ply){
+    if(score >= SCORE_MATE_BOUND) return score + ply;
+    if(score <= -SCORE_MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int ScoreFromTable(int score, int ply){
+    if(score >= SCORE_MATE_BOUND) return score - ply;
+    if(score <= -SCORE_MATE_BOUND) return score + ply;
+    return score;
+}
+
+static uint64_t ElapsedNs(const SearchShared* shared){
+    return Platform_TimeNanoseconds() - shared->startNs;
+}
+
+static uint64_t TotalNodes(const SearchShared* shared){
+    uint64_t nodes = 0;
+    for(int i = 0; i < shared->threadCount; i++){
+        nodes += shared->threads[i]->nodes;
+    }
+    return nodes;
+}
+
+//Only the main thread looks at the clock and node count, the helpers just follow the shared stop flag
+static void CheckLimits(SearchThread* thread){
+
+    SearchShared* shared = thread->shared;
+    if(thread->index == 0){
+        const SearchLimits* limits = shared->limits;
+        if(limits->nodes && TotalNodes(shared) >= limits->nodes){
+            shared->stop = 1;
+        }
+        if(limits->timeMs && ElapsedNs(shared) >= limits->timeMs * 1000000){
+            shared->stop = 1;
+        }
+    }
+    if(shared->stop){
+        thread->stopped = 1;
+    }
+
+}
+
+//Only the positions since the last capture or pawn move can repeat, and only those with the same side to move
+static int IsRepetition(const SearchThread* thread, const Position* position){
+
+    int oldest = thread->keyCount - position->halfmoveClock;
+    if(oldest < 0) oldest = 0;
+    for(int i = thread->keyCount - 2; i >= oldest; i -= 2){
+        if(thread->keys[i] == position->hash) return 1;
+    }
+    return 0;
+
+}
+
+static int HasNonPawnMaterial(const Position* position){
+    Bitboard pieces = position->pieces[KNIGHT] | position->pieces[BISHOP] | position->pieces[ROOK] | position->pieces[QUEEN];
+    return (pieces & position->sides[position->sideToMove]) != 0;
+}
+
+static void ScoreMoves(const SearchThread* thread, const Position* position, const MoveList* moveList, int* scores, Move ttMove, int ply){
+
+    int us = position->sideToMove;
+    for(int i = 0; i < moveList->length; i++){
+
+        Move move = moveList->moves[i];
+        int from = MOVE_FROM(move);
+        int to = MOVE_TO(move);
+
+        if(move == ttMove){
+            scores[i] = ORDER_TT_MOVE;
+        }
+        else if(MOVE_IS_CAPTURE(move)){
+            int victim = (MOVE_FLAGS(move) == MOVE_FLAG_EN_PASSANT) ? PAWN : Position_PieceTypeAt(position, to);
+            scores[i] = ORDER_CAPTURE + captureOrder[victim] * 16 - captureOrder[Position_PieceTypeAt(position, from)];
+            if(MOVE_IS_PROMOTION(move)) scores[i] += captureOrder[Move_PromotionType(move)];
+        }
+        else if(MOVE_IS_PROMOTION(move)){
+            //Queen promotions with the captures, underpromotions after everything else
+            scores[i] = (Move_PromotionType(move) == QUEEN) ? ORDER_CAPTURE + captureOrder[QUEEN] * 16 : -1;
+        }
+        else if(move == thread->killers[ply][0]){
+            scores[i] = ORDER_KILLER_FIRST;
+        }
+        else if(move == thread->killers[ply][1]){
+            scores[i] = ORDER_KILLER_SECOND;
+        }
+        else{
+            scores[i] = thread->history[us][from][to];
+        }
+
+    }
+
+}
+
+//Selection sort one step at a time, most nodes cut off after a move or two so sorting the whole list is wasted
+static Move PickMove(MoveList* moveList, int* scores, int index){
+
+    int best = index;
+    for(int i = index + 1; i < moveList->length; i++){
+        if(scores[i] > scores[best]) best = i;
+    }
+
+    Move move = moveList->moves[best];
+    int score = scores[best];
+    moveList->moves[best] = moveList->moves[index];
+    scores[best] = scores[index];
+    moveList->moves[index] = move;
+    scores[index] = score;
+    return move;
+
+}
+
+static void UpdateQuietCutoff(SearchThread* thread, const Position* position, Move move, int depth, int ply){
+
+    if(thread->killers[ply][0] != move){
+        thread->killers[ply][1] = thread->killers[ply][0];
+        thread->killers[ply][0] = move;
+    }
+
+    int* entry = &thread->history[position->sideToMove][MOVE_FROM(move)][MOVE_TO(move)];
+    *entry += depth * depth;
+    if(*entry >= HISTORY_MAX){
+        //Age the whole table so old cutoffs don't dominate forever
+        for(int side = 0; side < 2; side++){
+            for(int from = 0; from < 64; from++){
+                for(int to = 0; to < 64; to++){
+                    thread->history[side][from][to] /= 2;
+                }
+            }
+        }
+    }
+
+}
+
+static void UpdatePV(SearchThread* thread, Move move, int ply){
+
+    thread->pv[ply][ply] = move;
+    int childLength = (ply + 1 < SEARCH_MAX_PLY) ? thread->pvLength[ply + 1] : ply + 1;
+    for(int i = ply + 1; i < childLength; i++){
+        thread->pv[ply][i] = thread->pv[ply + 1][i];
+    }
+    thread->pvLength[ply] = childLength;
+
+}
+
+static int Quiescence(SearchThread* thread, Position* position, int alpha, int beta, int ply){
+
+    thread->nodes++;
+    if((thread->nodes & (CHECK_LIMITS_INTERVAL - 1)) == 0) CheckLimits(thread);
+    if(thread->stopped) return 0;
+
+    thread->pvLength[ply] = ply;
+    if(ply >= SEARCH_MAX_PLY - 1){
+        return Evaluate(position);
+    }
+
+    int inCheck = Position_InCheck(position);
+    int bestScore = -SCORE_INFINITE;
+    int standPat = 0;
+
+    MoveList moveList;
+    if(inCheck){
+        //Every evasion has to be looked at, standing pat while in check isn't an option
+        Position_GenerateLegalMoves(position, &moveList);
+        if(moveList.length == 0) return -SCORE_MATE + ply;
+    }
+    else{
+        standPat = Evaluate(position);
+        if(standPat >= beta) return standPat;
+        if(standPat > alpha) alpha = standPat;
+        bestScore = standPat;
+        Position_GenerateLegalCaptures(position, &moveList);
+    }
+
+    int scores[MAX_LEGAL_MOVES];
+    ScoreMoves(thread, position, &moveList, scores, MOVE_NONE, ply);
+
+    for(int i = 0; i < moveList.length; i++){
+
+        Move move = PickMove(&moveList, scores, i);
+
+        //Delta pruning, skip captures that can't lift the score to alpha even winning the piece for free
+        if(!inCheck && !MOVE_IS_PROMOTION(move)){
+            int victim = (MOVE_FLAGS(move) == MOVE_FLAG_EN_PASSANT) ? PAWN : Position_PieceTypeAt(position, MOVE_TO(move));
+            if(standPat + pieceValues[victim] + 200 <= alpha) continue;
+        }
+
+        Position_MakeMove(position, move, &thread->undo[ply]);
+        int score = -Quiescence(thread, position, -beta, -alpha, ply + 1);
+        Position_UnmakeMove(position, &thread->undo[ply]);
+        if(thread->stopped) return 0;
+
+        if(score > bestScore){
+            bestScore = score;
+            if(score > alpha){
+                alpha = score;
+                UpdatePV(thread, move, ply);
+                if(alpha >= beta) break;
+            }
+        }
+
+    }
+
+    return bestScore;
+
+}
+
+static int Negamax(SearchThread* thread, Position* position, int depth, int alpha, int beta, int ply, int allowNull){
+
+    int pvNode = beta - alpha > 1;
+    int root = ply == 0;
+
+    thread->pvLength[ply] = ply;
+
+    if(!root){
+        if(position->halfmoveClock >= 100 || IsRepetition(thread, position)) return 0;
+        if(ply >= SEARCH_MAX_PLY - 1) return Evaluate(position);
+
+        //Mate distance pruning, no line from here can beat a mate already found closer to the root
+        if(alpha < -SCORE_MATE + ply) alpha = -SCORE_MATE + ply;
+        if(beta > SCORE_MATE - ply - 1) beta = SCORE_MATE - ply - 1;
+        if(alpha >= beta) return alpha;
+    }
+
+    int inCheck = Position_InCheck(position);
+    if(inCheck) depth++;
+
+    if(depth <= 0){
+        return Quiescence(thread, position, alpha, beta, ply);
+    }
+
+    thread->nodes++;
+    if((thread->nodes & (CHECK_LIMITS_INTERVAL - 1)) == 0) CheckLimits(thread);
+    if(thread->stopped) return 0;
+
+    TTData ttData;
+    Move ttMove = MOVE_NONE;
+    if(TranspositionTable_Probe(thread->table, position->hash, &ttData)){
+        ttMove = ttData.move;
+        int ttScore = ScoreFromTable(ttData.score, ply);
+        if(!pvNode && ttData.depth >= depth){
+            if(ttData.bound == TT_BOUND_EXACT) return ttScore;
+            if(ttData.bound == TT_BOUND_LOWER && ttScore >= beta) return ttScore;
+            if(ttData.bound == TT_BOUND_UPPER && ttScore <= alpha) return ttScore;
+        }
+    }
+
+    int staticEval = inCheck ? -SCORE_INFINITE : Evaluate(position);
+
+    if(!pvNode && !inCheck){
+
+        //Reverse futility, far enough above beta that a shallow search won't bring it back down
+        if(depth <= 6 && staticEval - 80 * depth >= beta && beta > -SCORE_MATE_BOUND && beta < SCORE_MATE_BOUND){
+            return staticEval;
+        }
+
+        //Null move, if passing still fails high a real move would too. Not done without pieces because of zugzwang.
+        if(allowNull && depth >= 3 && staticEval >= beta && HasNonPawnMaterial(position)){
+            int reduction = 3 + depth / 6;
+            thread->keys[thread->keyCount++] = position->hash;
+            Position_MakeNullMove(position, &thread->undo[ply]);
+            int score = -Negamax(thread, position, depth - 1 - reduction, -beta, -beta + 1, ply + 1, 0);
+            Position_UnmakeNullMove(position, &thread->undo[ply]);
+            thread->keyCount--;
+            if(thread->stopped) return 0;
+            if(score >= beta){
+                return (score >= SCORE_MATE_BOUND) ? beta : score;
+            }
+        }
+
+    }
+
+    MoveList moveList;
+    Position_GenerateLegalMoves(position, &moveList);
+    if(moveList.length == 0){
+        return inCheck ? -SCORE_MATE + ply : 0;
+    }
+
+    int scores[MAX_LEGAL_MOVES];
+    ScoreMoves(thread, position, &moveList, scores, ttMove, ply);
+
+    int originalAlpha = alpha;
+    int bestScore = -SCORE_INFINITE;
+    Move bestMove = MOVE_NONE;
+    int quietsSearched = 0;
+
+    thread->keys[thread->keyCount++] = position->hash;
+
+    for(int i = 0; i < moveList.length; i++){
+
+        Move move = PickMove(&moveList, scores, i);
+        int quiet = !MOVE_IS_CAPTURE(move) && !MOVE_IS_PROMOTION(move);
+
+        PositionUndo* undo = &thread->undo[ply];
+        Position_MakeMove(position, move, undo);
+        TranspositionTable_Prefetch(thread->table, position->hash);
+        int givesCheck = Position_InCheck(position);
+
+        //Futility and late move pruning of quiet moves that are very unlikely to raise alpha this close to the leaves
+        if(!pvNode && !inCheck && quiet && !givesCheck && i > 0 && bestScore > -SCORE_MATE_BOUND){
+            if(depth <= 3 && (staticEval + 100 + 120 * depth <= alpha || quietsSearched >= 4 + depth * depth)){
+                Position_UnmakeMove(position, undo);
+                continue;
+            }
+        }
+        if(quiet) quietsSearched++;
+
+        int score;
+        if(i == 0){
+            score = -Negamax(thread, position, depth - 1, -beta, -alpha, ply + 1, 1);
+        }
+        else{
+            //Late move reductions, later quiet moves are searched shallower and only re-searched if they surprise
+            int reduction = 0;
+            if(depth >= 3 && i >= 3 && quiet && !inCheck && !givesCheck){
+                reduction = 1 + (i >= 8) + (depth >= 8) - pvNode;
+                if(move == thread->killers[ply][0] || move == thread->killers[ply][1]) reduction--;
+                if(reduction > depth - 2) reduction = depth - 2;
+                if(reduction < 0) reduction = 0;
+            }
+
+            score = -Negamax(thread, position, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, 1);
+            if(score > alpha && reduction > 0){
+                score = -Negamax(thread, position, depth - 1, -alpha - 1, -alpha, ply + 1, 1);
+            }
+            if(score > alpha && score < beta){
+                score = -Negamax(thread, position, depth - 1, -beta, -alpha, ply + 1, 1);
+            }
+        }
+
+        Position_UnmakeMove(position, undo);
+
+        if(thread->stopped){
+            thread->keyCount--;
+            return 0;
+        }
+
+        if(score > bestScore){
+            bestScore = score;
+            if(score > alpha){
+                alpha = score;
+                bestMove = move;
+                UpdatePV(thread, move, ply);
+                if(alpha >= beta){
+                    if(quiet) UpdateQuietCutoff(thread, position, move, depth, ply);
+                    break;
+                }
+            }
+        }
+
+    }
+
+    thread->keyCount--;
+
+    int bound = (bestScore >= beta) ? TT_BOUND_LOWER : (bestScore > originalAlpha) ? TT_BOUND_EXACT : TT_BOUND_UPPER;
+    TranspositionTable_Store(thread->table, position->hash, bestMove != MOVE_NONE ? bestMove : ttMove, ScoreToTable(bestScore, ply), depth, bound);
+
+    return bestScore;
+
+}
+
+static void FillResult(const SearchThread* thread, SearchResult* result, int depth, int score){
+
+    result->depth = depth;
+    result->score = score;
+    result->pvLength = thread->pvLength[0];
+    memcpy(result->pv, thread->pv[0], sizeof(Move) * result->pvLength);
+    if(result->pvLength > 0) result->bestMove = result->pv[0];
+
+}
+
+static void IterativeDeepening(SearchThread* thread){
+
+    SearchShared* shared = thread->shared;
+    const SearchLimits* limits = shared->limits;
+    SearchResult* result = &thread->result;
+
+    int maxDepth = (limits->depth > 0 && limits->depth < SEARCH_MAX_PLY) ? limits->depth : SEARCH_MAX_PLY - 1;
+    int score = 0;
+
+    for(int iteration = 1; iteration <= maxDepth; iteration++){
+
+        //Half the helpers run one ply ahead so the threads don't all search the same depth in lockstep
+        int depth = iteration + (thread->index & 1);
+        if(depth > maxDepth) depth = maxDepth;
+
+        //Narrow window around the last score, widened on either side until the score falls inside it
+        int window = ASPIRATION_WINDOW;
+        int alpha = -SCORE_INFINITE, beta = SCORE_INFINITE;
+        if(depth >= ASPIRATION_MIN_DEPTH){
+            alpha = score - window;
+            beta = score + window;
+        }
+
+        while(1){
+            int iterationScore = Negamax(thread, &thread->position, depth, alpha, beta, 0, 0);
+            if(thread->stopped) break;
+
+            if(iterationScore <= alpha){
+                alpha = (alpha - window > -SCORE_INFINITE) ? alpha - window : -SCORE_INFINITE;
+            }
+            else if(iterationScore >= beta){
+                //A fail high still found a better move, keep it in case time runs out before the re-search
+                FillResult(thread, result, result->depth, iterationScore);
+                beta = (beta + window < SCORE_INFINITE) ? beta + window : SCORE_INFINITE;
+            }
+            else{
+                score = iterationScore;
+                break;
+            }
+            window *= 2;
+        }
+
+        if(thread->stopped) break;
+
+        FillResult(thread, result, depth, score);
+
+        if(thread->index == 0){
+            result->nodes = TotalNodes(shared);
+            result->elapsedNs = ElapsedNs(shared);
+            if(limits->report) limits->report(result, limits->reportContext);
+
+            //A forced mate doesn't get better with more depth
+            if(score >= SCORE_MATE_BOUND && SCORE_MATE - score <= depth) break;
+            //The next iteration usually takes longer than all the previous ones together, don't start what can't finish
+            if(limits->timeMs && result->elapsedNs >= limits->timeMs * 1000000 / 2) break;
+        }
+
+    }
+
+}
+
+static void HelperThreadMain(void* argument){
+    IterativeDeepening((SearchThread*)argument);
+}
+
+void Search_Run(const Position* root, const uint64_t* history, int historyLength, const SearchLimits* limits, TranspositionTable* table, SearchResult* result){
+
+    memset(result, 0, sizeof(SearchResult));
+    result->bestMove = MOVE_NONE;
+
+    MoveList rootMoves;
+    Position_GenerateLegalMoves(root, &rootMoves);
+    if(rootMoves.length == 0){
+        return;
+    }
+    //Something to play even if the first iteration is cut short
+    result->bestMove = rootMoves.moves[0];
+
+    SearchShared* shared = (SearchShared*)calloc(1, sizeof(SearchShared));
+    if(shared == NULL){
+        return;
+    }
+    shared->table = table;
+    shared->limits = limits;
+
+    int threadCount = limits->threads;
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > SEARCH_MAX_THREADS) threadCount = SEARCH_MAX_THREADS;
+
+    if(historyLength > SEARCH_MAX_HISTORY){
+        history += historyLength - SEARCH_MAX_HISTORY;
+        historyLength = SEARCH_MAX_HISTORY;
+    }
+
+    for(int i = 0; i < threadCount; i++){
+        SearchThread* thread = (SearchThread*)calloc(1, sizeof(SearchThread));
+        if(thread == NULL) break;
+        thread->shared = shared;
+        thread->table = table;
+        thread->index = i;
+        thread->position = *root;
+        thread->result.bestMove = result->bestMove;
+        if(historyLength > 0) memcpy(thread->keys, history, sizeof(uint64_t) * historyLength);
+        thread->keyCount = historyLength;
+        shared->threads[shared->threadCount++] = thread;
+    }
+    if(shared->threadCount == 0){
+        free(shared);
+        return;
+    }
+
+    TranspositionTable_NewSearch(table);
+    shared->startNs = Platform_TimeNanoseconds();
+
+    //The calling thread is the main thread, a helper that fails to start is simply left out
+    PlatformThread* helpers[SEARCH_MAX_THREADS];
+    for(int i = 1; i < shared->threadCount; i++){
+        helpers[i] = Platform_CreateThread(HelperThreadMain, shared->threads[i]);
+    }
+
+    IterativeDeepening(shared->threads[0]);
+    shared->stop = 1;
+
+    for(int i = 1; i < shared->threadCount; i++){
+        if(helpers[i] != NULL) Platform_JoinThread(helpers[i]);
+    }
+
+    *result = shared->threads[0]->result;
+    result->nodes = TotalNodes(shared);
+    result->elapsedNs = ElapsedNs(shared);
+
+    for(int i = 0; i < shared->threadCount; i++){
+        free(shared->threads[i]);
+    }
+    free(shared);
+
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef H_SEARCH
+#define H_SEARCH
+
+#include <stdint.h>
+
+#include "position.h"
+#include "move.h"
+#include "transposition_table.h"
+
+#define SEARCH_MAX_PLY 128
+#define SEARCH_MAX_HISTORY 1024 //Game positions before the root that are checked for repetitions
+#define SEARCH_MAX_THREADS 256
+
+#define SCORE_INFINITE 32000
+#define SCORE_MATE 31000
+//Scores beyond this are mate in some number of plies, SCORE_MATE - score plies from the root
+#define SCORE_MATE_BOUND (SCORE_MATE - SEARCH_MAX_PLY)
+
+typedef struct SearchResult{
+    Move bestMove;
+    int score;       //Centipawns from the side to move's point of view
+    int depth;       //Deepest iteration that finished
+    uint64_t nodes;
+    uint64_t elapsedNs;
+    int pvLength;
+    Move pv[SEARCH_MAX_PLY];
+} SearchResult;
+
+typedef void (*SearchReportFunction)(const SearchResult* result, void* context);
+
+//A zero limit means no limit. With none set at all the search runs to SEARCH_MAX_PLY.
+typedef struct SearchLimits{
+    int depth;
+    uint64_t nodes;
+    uint64_t timeMs;
+    int threads; //Search threads sharing the transposition table, 0 or 1 for a single threaded search
+    SearchReportFunction report; //Called after every finished iteration, may be NULL
+    void* reportContext;
+} SearchLimits;
+
+//Iterative deepening principal variation search from root. history holds the hashes of the game positions
+//before root, oldest first, so repetitions of them score as draws. The best move of the deepest finished
+//iteration is returned in result, a move is always returned if the root has one.
+//With limits->threads above 1 the extra threads search the same root alongside it (Lazy SMP) and only
+//share results through table. The reported nodes are the total over all threads.
+void Search_Run(const Position* root, const uint64_t* history, int historyLength, const SearchLimits* limits, TranspositionTable* table, SearchResult* result);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,695 @@
+#include "server.h"
+#include "movegen.h"
+#include "fen.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//How often Server_Run looks at the running flag when nothing happens
+#define SERVER_RUN_POLL_MS 100
+
+static void SetEvents(GameServer* server, int index, int events){
+
+    ServerConnection* connection = &server->connections[index];
+    if(connection->events == events) return;
+    NetReactor_Modify(&server->reactor, connection->socket, events, index);
+    connection->events = (unsigned char)events;
+
+}
+
+//Reading stops while the in buffer is full, writing is only asked for while frames or stream bytes are queued
+static void UpdateEvents(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+    int events = 0;
+    if(RingBuffer_Space(&connection->in) > 0) events |= NET_EVENT_READ;
+    if(RingBuffer_Length(&connection->out) > 0 || BroadcastReader_Pending(&connection->reader)) events |= NET_EVENT_WRITE;
+    SetEvents(server, index, events);
+
+}
+
+static void CloseConnection(GameServer* server, int index);
+
+//Sends as much of the queued frames as the socket takes, and for a spectator as much of its game's stream after them.
+//Returns 0 if the connection failed and was closed.
+static int Flush(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+
+    //The queue can wrap, which takes a second send
+    while(RingBuffer_Length(&connection->out) > 0){
+
+        int size;
+        const unsigned char* span = RingBuffer_ReadSpan(&connection->out, &size);
+        int sent = Net_Send(connection->socket, span, size);
+        server->stats.writes++;
+        if(sent == NET_WOULD_BLOCK) return 1;
+        if(sent < 0){
+            CloseConnection(server, index);
+            return 0;
+        }
+
+        RingBuffer_Consume(&connection->out, sent);
+        if(sent < size) return 1;
+
+    }
+
+    //Sent straight out of the shared chunks, one send per chunk
+    while(connection->reader.buffer != NULL){
+
+        int size;
+        const unsigned char* span = BroadcastReader_Span(&server->broadcastPool, &connection->reader, &size);
+        if(size == 0) break;
+        int sent = Net_Send(connection->socket, span, size);
+        server->stats.writes++;
+        if(sent == NET_WOULD_BLOCK) return 1;
+        if(sent < 0){
+            CloseConnection(server, index);
+            return 0;
+        }
+
+        BroadcastReader_Consume(&connection->reader, sent);
+        server->stats.spectatorBytes += sent;
+        if(sent < size) return 1;
+
+    }
+    return 1;
+
+}
+
+//Spectators of a finished game are closed once everything has been sent to them
+static void FlushSpectator(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+    if(!Flush(server, index)) return;
+
+    if(connection->game == SERVER_NO_GAME && connection->reader.buffer != NULL
+        && RingBuffer_Length(&connection->out) == 0 && !BroadcastReader_Pending(&connection->reader)){
+        CloseConnection(server, index);
+        return;
+    }
+    UpdateEvents(server, index);
+
+}
+
+//Sends what was just added to the stream to every spectator not already waiting for room, and drops the ones too far behind
+static void FanOut(GameServer* server, int gameIndex){
+
+    ServerGame* game = &server->games[gameIndex];
+    int index = game->firstSpectator;
+    while(index != -1){
+
+        ServerConnection* spectator = &server->connections[index];
+        int next = spectator->nextSpectator;
+        if(game->stream.written - spectator->reader.read > SERVER_MAX_SPECTATOR_LAG){
+            server->stats.spectatorsDropped++;
+            CloseConnection(server, index);
+        }
+        else if(!(spectator->events & NET_EVENT_WRITE)){
+            FlushSpectator(server, index);
+        }
+        index = next;
+
+    }
+
+}
+
+//Encodes a message once into the game's stream for every spectator. Returns 0 if the stream ran out of memory,
+//its spectators are dropped then since they'd miss the message.
+static int Broadcast(GameServer* server, int gameIndex, const unsigned char* frame, int frameLength){
+
+    ServerGame* game = &server->games[gameIndex];
+    if(BroadcastStream_Write(&server->broadcastPool, &game->stream, frame, frameLength)){
+        server->stats.broadcastBytes += frameLength;
+        return 1;
+    }
+    while(game->firstSpectator != -1){
+        server->stats.spectatorsDropped++;
+        CloseConnection(server, game->firstSpectator);
+    }
+    return 0;
+
+}
+
+static void DetachSpectator(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+    if(connection->game != SERVER_NO_GAME){
+
+        ServerGame* game = &server->games[connection->game];
+        if(connection->previousSpectator != -1) server->connections[connection->previousSpectator].nextSpectator = connection->nextSpectator;
+        else game->firstSpectator = connection->nextSpectator;
+        if(connection->nextSpectator != -1) server->connections[connection->nextSpectator].previousSpectator = connection->previousSpectator;
+
+        //Nobody left to read the stream, stop writing it
+        game->spectators--;
+        if(game->spectators == 0) BroadcastStream_Close(&server->broadcastPool, &game->stream);
+
+    }
+    BroadcastReader_Detach(&server->broadcastPool, &connection->reader);
+
+}
+
+//Sets how the game ended unless it already was
+static void SetResult(ServerGame* game, enum GAME_RESULT result, enum GAME_END_REASON reason){
+    if(game->reason != GAME_END_UNKNOWN) return;
+    game->result = (unsigned char)result;
+    game->reason = (unsigned char)reason;
+}
+
+static void ArchiveGame(GameServer* server, ServerGame* game){
+
+    //Players usually leave right after the final move, the position tells whether that was mate
+    if(game->reason == GAME_END_UNKNOWN){
+        enum GAME_RESULT result = GAME_RESULT_UNFINISHED;
+        enum GAME_END_REASON reason = GAME_END_DISCONNECT;
+        GameResult_FromPosition(&game->position, &result, &reason);
+        SetResult(game, result, reason);
+    }
+
+    if(GameArchiveWriter_Append(&server->archive, NULL, game->moves, (int)game->moveCount,
+        (enum GAME_RESULT)game->result, (enum GAME_END_REASON)game->reason) < 0){
+        server->stats.archiveErrors++;
+        return;
+    }
+    server->stats.gamesArchived++;
+
+}
+
+static void EndGame(GameServer* server, int gameIndex){
+
+    ServerGame* game = &server->games[gameIndex];
+    int players[2] = { game->connections[WHITE], game->connections[BLACK] };
+
+    if(server->archive.data != NULL) ArchiveGame(server, game);
+
+    //Spectators keep their place in the stream and are closed once they've been sent the rest of it
+    if(game->spectators > 0){
+
+        static const char reason[] = "Game over";
+        unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+        int frameLength = Protocol_Encode(frame, MESSAGE_ERROR, reason, sizeof(reason) - 1);
+        Broadcast(server, gameIndex, frame, frameLength);
+
+        int index = game->firstSpectator;
+        game->firstSpectator = -1;
+        game->spectators = 0;
+        while(index != -1){
+            ServerConnection* spectator = &server->connections[index];
+            int next = spectator->nextSpectator;
+            spectator->game = SERVER_NO_GAME;
+            spectator->nextSpectator = -1;
+            spectator->previousSpectator = -1;
+            FlushSpectator(server, index);
+            index = next;
+        }
+        BroadcastStream_Close(&server->broadcastPool, &game->stream);
+
+    }
+
+    game->connections[0] = server->freeGame;
+    game->connections[1] = -1;
+    server->freeGame = gameIndex;
+    server->activeGames--;
+    server->stats.gamesFinished++;
+
+    //The game is gone so closing the players won't come back here
+    for(int i = 0; i < 2; i++){
+        server->connections[players[i]].game = SERVER_NO_GAME;
+        CloseConnection(server, players[i]);
+    }
+
+}
+
+static void CloseConnection(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+    if(connection->socket == NET_INVALID_SOCKET) return;
+
+    if(connection->spectator){
+        DetachSpectator(server, index);
+    }
+    //A player leaving ends the game for the opponent too
+    else if(connection->game != SERVER_NO_GAME){
+        EndGame(server, connection->game);
+        return;
+    }
+
+    NetReactor_Remove(&server->reactor, connection->socket, index);
+    Net_Close(connection->socket);
+    connection->socket = NET_INVALID_SOCKET;
+    if(connection->spectator){
+        connection->game = server->freeSpectator;
+        server->freeSpectator = index;
+    }
+    else{
+        connection->game = server->freeConnection;
+        server->freeConnection = index;
+    }
+    if(server->waiting == index) server->waiting = -1;
+
+}
+
+//Keeps the move for the archive. The buffer doubles as needed and stays with the game slot, so once the
+//slots have seen a few long games no more allocating is done. A game that runs out of memory or past
+//GAME_ARCHIVE_MAX_MOVES is marked so it isn't archived half.
+static void RecordMove(ServerGame* game, Move move){
+
+    if(game->moveCount > GAME_ARCHIVE_MAX_MOVES) return;
+    if(game->moveCount == GAME_ARCHIVE_MAX_MOVES){
+        game->moveCount++;
+        return;
+    }
+    if(game->moveCount == game->moveCapacity){
+        uint32_t capacity = game->moveCapacity == 0 ? 128 : game->moveCapacity*2;
+        unsigned char* moves = (unsigned char*)realloc(game->moves, (size_t)capacity*2);
+        if(moves == NULL){
+            game->moveCount = GAME_ARCHIVE_MAX_MOVES + 1;
+            return;
+        }
+        game->moves = moves;
+        game->moveCapacity = capacity;
+    }
+    Move_Encode(move, game->moves + game->moveCount*2);
+    game->moveCount++;
+
+}
+
+//Plays a relayed move on the game's position. Returns 0 if it isn't the player's turn or the move isn't legal.
+static int ApplyMove(GameServer* server, ServerGame* game, int side, const ProtocolMessage* message){
+
+    Move move;
+    if(!Protocol_DecodeMove(message, &move) || game->position.sideToMove != side || !Position_IsLegalMove(&game->position, move)){
+        return 0;
+    }
+    PositionUndo undo;
+    Position_MakeMove(&game->position, move, &undo);
+    if(server->archive.data != NULL) RecordMove(game, move);
+    return 1;
+
+}
+
+//Tells both players the game is over because of the player at index and closes it
+static void RejectMove(GameServer* server, int index, int opponentIndex){
+
+    static const char offenderReason[] = "Illegal move";
+    static const char opponentReason[] = "Opponent made an illegal move";
+    Protocol_Write(&server->connections[index].out, MESSAGE_ERROR, offenderReason, sizeof(offenderReason) - 1);
+    Protocol_Write(&server->connections[opponentIndex].out, MESSAGE_ERROR, opponentReason, sizeof(opponentReason) - 1);
+
+    //A failed flush closes the game already, closing again is then a no-op
+    ServerGame* game = &server->games[server->connections[index].game];
+    SetResult(game, server->connections[index].side == WHITE ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS, GAME_END_ILLEGAL_MOVE);
+    server->stats.illegalMoves++;
+    if(Flush(server, opponentIndex)) Flush(server, index);
+    CloseConnection(server, index);
+
+}
+
+//Relays every complete frame in the connection's in buffer that fits in the opponent's out buffer.
+//Returns 0 if either connection was closed.
+static int RelayMessages(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+    if(connection->game == SERVER_NO_GAME) return 1;
+
+    int gameIndex = connection->game;
+    ServerGame* game = &server->games[gameIndex];
+    int opponentIndex = game->connections[OppositeChessSide(connection->side)];
+    ServerConnection* opponent = &server->connections[opponentIndex];
+
+    ProtocolMessage message;
+    unsigned char frame[PROTOCOL_MAX_FRAME_LEN];
+    int relayed = 0;
+    while(RingBuffer_Space(&opponent->out) >= PROTOCOL_MAX_FRAME_LEN){
+
+        int result = Protocol_Read(&connection->in, &message);
+        if(result == PROTOCOL_INCOMPLETE) break;
+
+        //Sides and positions are the server's to hand out
+        if(result == PROTOCOL_MALFORMED || message.type == MESSAGE_SIDE || message.type > MESSAGE_ERROR){
+            server->stats.malformed++;
+            CloseConnection(server, index);
+            return 0;
+        }
+        if(message.type == MESSAGE_MOVE && !ApplyMove(server, game, connection->side, &message)){
+            RejectMove(server, index, opponentIndex);
+            return 0;
+        }
+        if(message.type == MESSAGE_RESIGN){
+            SetResult(game, connection->side == WHITE ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS, GAME_END_RESIGNATION);
+        }
+        else if(message.type == MESSAGE_DRAW_ACCEPT){
+            SetResult(game, GAME_RESULT_DRAW, GAME_END_DRAW_AGREED);
+        }
+
+        int frameLength = Protocol_Encode(frame, message.type, message.payload, message.length);
+        RingBuffer_Write(&opponent->out, frame, frameLength);
+        if(game->spectators > 0) Broadcast(server, gameIndex, frame, frameLength);
+        relayed++;
+
+    }
+
+    if(relayed > 0){
+        game->messages += relayed;
+        server->stats.messagesRelayed += relayed;
+        if(game->spectators > 0) FanOut(server, gameIndex);
+        if(!Flush(server, opponentIndex)) return 0;
+    }
+    UpdateEvents(server, opponentIndex);
+    UpdateEvents(server, index);
+    return 1;
+
+}
+
+static void StartGame(GameServer* server, int white, int black){
+
+    int gameIndex = server->freeGame;
+    ServerGame* game = &server->games[gameIndex];
+    server->freeGame = game->connections[0];
+
+    game->connections[WHITE] = white;
+    game->connections[BLACK] = black;
+    game->messages = 0;
+    game->position = server->startPosition;
+    game->firstSpectator = -1;
+    game->spectators = 0;
+    game->moveCount = 0;
+    game->result = GAME_RESULT_UNFINISHED;
+    game->reason = GAME_END_UNKNOWN;
+    server->activeGames++;
+    server->stats.gamesStarted++;
+
+    for(int side = WHITE; side <= BLACK; side++){
+        ServerConnection* connection = &server->connections[game->connections[side]];
+        connection->game = gameIndex;
+        connection->side = (unsigned char)side;
+        unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+        Protocol_Write(&connection->out, MESSAGE_SIDE, payload, Protocol_EncodeSide(payload, (enum CHESS_SIDE)side, (uint32_t)gameIndex));
+    }
+
+    //Anything sent while waiting for an opponent goes out after the sides
+    if(!Flush(server, white) || !Flush(server, black)) return;
+    if(!RelayMessages(server, white)) return;
+    RelayMessages(server, black);
+
+}
+
+//Starts a spectator on the game's stream after sending it the position. Returns 0 if the connection was closed.
+static int AttachSpectator(GameServer* server, int index, uint32_t gameNumber){
+
+    ServerConnection* connection = &server->connections[index];
+    ServerGame* game = (gameNumber < (uint32_t)server->maxGames) ? &server->games[gameNumber] : NULL;
+
+    //Free game slots have no black player
+    if(game == NULL || game->connections[BLACK] == -1 || (game->spectators == 0 && !BroadcastStream_Open(&server->broadcastPool, &game->stream))){
+        static const char reason[] = "No such game";
+        Protocol_Write(&connection->out, MESSAGE_ERROR, reason, sizeof(reason) - 1);
+        if(Flush(server, index)) CloseConnection(server, index);
+        return 0;
+    }
+
+    unsigned char payload[PROTOCOL_MAX_PAYLOAD];
+    Protocol_Write(&connection->out, MESSAGE_POSITION, payload, Protocol_EncodePosition(payload, &game->position));
+    BroadcastReader_Attach(&connection->reader, &game->stream);
+
+    connection->game = (int32_t)gameNumber;
+    connection->previousSpectator = -1;
+    connection->nextSpectator = game->firstSpectator;
+    if(game->firstSpectator != -1) server->connections[game->firstSpectator].previousSpectator = index;
+    game->firstSpectator = index;
+    game->spectators++;
+    server->stats.spectatorsAttached++;
+
+    FlushSpectator(server, index);
+    return connection->socket != NET_INVALID_SOCKET;
+
+}
+
+//A spectator only says which game it wants, anything it sends after that is dropped
+static void ReadSpectatorMessages(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+    ProtocolMessage message;
+    int result;
+    while((result = Protocol_Read(&connection->in, &message)) == PROTOCOL_MESSAGE){
+
+        if(connection->reader.buffer != NULL) continue;
+
+        uint32_t gameNumber;
+        if(message.type != MESSAGE_WATCH || !Protocol_DecodeWatch(&message, &gameNumber)){
+            server->stats.malformed++;
+            CloseConnection(server, index);
+            return;
+        }
+        if(!AttachSpectator(server, index, gameNumber)) return;
+
+    }
+
+    if(result == PROTOCOL_MALFORMED){
+        server->stats.malformed++;
+        CloseConnection(server, index);
+        return;
+    }
+    UpdateEvents(server, index);
+
+}
+
+static void AcceptConnections(GameServer* server, NetSocket listener, int spectators){
+
+    int* freeList = spectators ? &server->freeSpectator : &server->freeConnection;
+
+    NetSocket socket;
+    while((socket = Net_Accept(listener)) != NET_INVALID_SOCKET){
+
+        //There's always a free game slot for a full pair, so a free connection is all that's needed
+        if(*freeList == -1){
+            Net_Close(socket);
+            server->stats.rejected++;
+            continue;
+        }
+
+        int index = *freeList;
+        ServerConnection* connection = &server->connections[index];
+        *freeList = connection->game;
+
+        connection->socket = socket;
+        connection->game = SERVER_NO_GAME;
+        connection->events = NET_EVENT_READ;
+        connection->nextSpectator = -1;
+        connection->previousSpectator = -1;
+        connection->reader.buffer = NULL;
+        RingBuffer_Reset(&connection->in);
+        RingBuffer_Reset(&connection->out);
+        if(!NetReactor_Add(&server->reactor, socket, NET_EVENT_READ, index)){
+            Net_Close(socket);
+            connection->socket = NET_INVALID_SOCKET;
+            connection->game = *freeList;
+            *freeList = index;
+            continue;
+        }
+        server->stats.accepted++;
+
+        if(spectators){
+            continue;
+        }
+        if(server->waiting == -1){
+            server->waiting = index;
+        }
+        else{
+            int white = server->waiting;
+            server->waiting = -1;
+            StartGame(server, white, index);
+        }
+
+    }
+
+}
+
+//One recv straight into the in buffer, then every complete frame that came with it is relayed
+static void ReadFrom(GameServer* server, int index){
+
+    ServerConnection* connection = &server->connections[index];
+
+    int space;
+    unsigned char* span = RingBuffer_WriteSpan(&connection->in, &space);
+    if(space == 0){
+        UpdateEvents(server, index);
+        return;
+    }
+
+    int received = Net_Recv(connection->socket, span, space);
+    server->stats.reads++;
+    if(received == NET_WOULD_BLOCK) return;
+    if(received <= 0){
+        CloseConnection(server, index);
+        return;
+    }
+
+    RingBuffer_Commit(&connection->in, received);
+    if(connection->spectator){
+        ReadSpectatorMessages(server, index);
+        return;
+    }
+    server->stats.bytesRelayed += received;
+    if(connection->game == SERVER_NO_GAME){
+        UpdateEvents(server, index);
+        return;
+    }
+    RelayMessages(server, index);
+
+}
+
+int Server_Init(GameServer* server, const char* port, const char* spectatorPort, int maxGames, int maxSpectators){
+
+    memset(server, 0, sizeof(GameServer));
+    server->listener = NET_INVALID_SOCKET;
+    server->spectatorListener = NET_INVALID_SOCKET;
+    server->maxGames = maxGames;
+    server->maxSpectators = maxSpectators;
+    int playerConnections = maxGames*2 + 1;
+    server->maxConnections = playerConnections + maxSpectators;
+    server->waiting = -1;
+    Position_LoadFen(&server->startPosition, FEN_START_POSITION);
+    BroadcastPool_Init(&server->broadcastPool);
+
+    server->connections = (ServerConnection*)malloc(sizeof(ServerConnection) * server->maxConnections);
+    //Zeroed so freeing after a failed init finds no buffers or streams
+    server->games = (ServerGame*)calloc(maxGames, sizeof(ServerGame));
+    //The listeners are registered after the connections
+    if(server->connections == NULL || server->games == NULL || !NetReactor_Init(&server->reactor, server->maxConnections + 2)){
+        Server_Free(server);
+        return 0;
+    }
+
+    //Players and spectators have their own slots so spectators can't crowd out games.
+    //Free lists run in index order so the tables fill from the front.
+    for(int i = 0; i < server->maxConnections; i++){
+        ServerConnection* connection = &server->connections[i];
+        connection->socket = NET_INVALID_SOCKET;
+        connection->spectator = (unsigned char)(i >= playerConnections);
+        connection->game = (i + 1 < server->maxConnections && i + 1 != playerConnections) ? i + 1 : -1;
+        connection->reader.buffer = NULL;
+    }
+    for(int i = 0; i < maxGames; i++){
+        server->games[i].connections[0] = (i + 1 < maxGames) ? i + 1 : -1;
+        server->games[i].connections[1] = -1;
+        server->games[i].firstSpectator = -1;
+        server->games[i].spectators = 0;
+        server->games[i].stream.tail = NULL;
+        server->games[i].moves = NULL;
+        server->games[i].moveCapacity = 0;
+    }
+    server->freeConnection = 0;
+    server->freeSpectator = maxSpectators > 0 ? playerConnections : -1;
+    server->freeGame = maxGames > 0 ? 0 : -1;
+
+    server->listener = Net_Listen(port, 4096);
+    if(server->listener == NET_INVALID_SOCKET || !NetReactor_Add(&server->reactor, server->listener, NET_EVENT_READ, server->maxConnections)){
+        Server_Free(server);
+        return 0;
+    }
+    if(maxSpectators > 0){
+        server->spectatorListener = Net_Listen(spectatorPort, 4096);
+        if(server->spectatorListener == NET_INVALID_SOCKET
+            || !NetReactor_Add(&server->reactor, server->spectatorListener, NET_EVENT_READ, server->maxConnections + 1)){
+            Server_Free(server);
+            return 0;
+        }
+    }
+
+    server->running = 1;
+    return 1;
+
+}
+
+int Server_OpenArchive(GameServer* server, const char* path){
+    return GameArchiveWriter_Open(&server->archive, path);
+}
+
+void Server_Free(GameServer* server){
+
+    if(server->connections != NULL){
+        for(int i = 0; i < server->maxConnections; i++){
+            if(server->connections[i].socket != NET_INVALID_SOCKET) Net_Close(server->connections[i].socket);
+            BroadcastReader_Detach(&server->broadcastPool, &server->connections[i].reader);
+        }
+    }
+    if(server->games != NULL){
+        for(int i = 0; i < server->maxGames; i++){
+            BroadcastStream_Close(&server->broadcastPool, &server->games[i].stream);
+            free(server->games[i].moves);
+        }
+    }
+    if(server->listener != NET_INVALID_SOCKET) Net_Close(server->listener);
+    if(server->spectatorListener != NET_INVALID_SOCKET) Net_Close(server->spectatorListener);
+
+    GameArchiveWriter_Close(&server->archive);
+    NetReactor_Free(&server->reactor);
+    BroadcastPool_Free(&server->broadcastPool);
+    free(server->connections);
+    free(server->games);
+    server->connections = NULL;
+    server->games = NULL;
+    server->listener = NET_INVALID_SOCKET;
+    server->spectatorListener = NET_INVALID_SOCKET;
+
+}
+
+int Server_Poll(GameServer* server, int timeoutMs){
+
+    NetEvent events[SERVER_MAX_EVENTS];
+    int eventCount = NetReactor_Wait(&server->reactor, events, SERVER_MAX_EVENTS, timeoutMs);
+    if(eventCount < 0) return -1;
+
+    for(int i = 0; i < eventCount; i++){
+
+        int index = events[i].data;
+        if(index == server->maxConnections){
+            AcceptConnections(server, server->listener, 0);
+            continue;
+        }
+        if(index == server->maxConnections + 1){
+            AcceptConnections(server, server->spectatorListener, 1);
+            continue;
+        }
+
+        //An earlier event in this batch may have closed it, or closed it and handed the slot to someone new
+        ServerConnection* connection = &server->connections[index];
+        if(connection->socket == NET_INVALID_SOCKET) continue;
+
+        if((events[i].events & NET_EVENT_WRITE) && connection->spectator){
+            FlushSpectator(server, index);
+            if(connection->socket == NET_INVALID_SOCKET) continue;
+        }
+        else if(events[i].events & NET_EVENT_WRITE){
+            if(!Flush(server, index)) continue;
+            UpdateEvents(server, index);
+            if(connection->game != SERVER_NO_GAME){
+                //Room in this queue lets the opponent's held back messages through
+                if(!RelayMessages(server, server->games[connection->game].connections[OppositeChessSide(connection->side)])) continue;
+            }
+        }
+        if(events[i].events & NET_EVENT_READ){
+            ReadFrom(server, index);
+        }
+        else if(events[i].events & NET_EVENT_CLOSED){
+            //Hang ups are reported even while reading is paused, whatever it still had to say is dropped
+            CloseConnection(server, index);
+        }
+
+    }
+
+    return eventCount;
+
+}
+
+void Server_Run(GameServer* server){
+
+    while(server->running){
+        int handled = Server_Poll(server, SERVER_RUN_POLL_MS);
+        if(handled < 0) break;
+        if(handled == 0 && server->archive.data != NULL) GameArchiveWriter_Flush(&server->archive);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#ifndef H_SERVER
+#define H_SERVER
+
+#include <stdint.h>
+
+#include "net.h"
+#include "chess.h"
+#include "position.h"
+#include "protocol.h"
+#include "game_archive.h"
+#include "data_structures/ring_buffer.h"
+#include "data_structures/broadcast_buffer.h"
+
+//Headless game server. Clients connect to one listening socket and are paired in the order they arrive, the
+//first of the pair is white. Right after pairing each player gets a MESSAGE_SIDE, after that every message
+//one player sends is relayed to the other. The server keeps each game's position and checks every move against it,
+//a move out of turn or not legal is answered with a MESSAGE_ERROR to both players and ends the game. All connections are served from one thread through the reactor.
+//A player that can't keep up holds its messages in the opponent's in buffer, and once that fills up the
+//server stops reading from the opponent until it drains.
+//
+//Spectators connect to a second port and send a MESSAGE_WATCH with the game number the players got with their side.
+//They get the game's position as a MESSAGE_POSITION and then every message the players exchange. Each message is
+//encoded once into the game's BroadcastStream and sent to every spectator from there. A spectator whose socket
+//doesn't keep up is only written to again when it has room, one that falls SERVER_MAX_SPECTATOR_LAG bytes behind
+//is dropped. Once a game ends its spectators get a MESSAGE_ERROR after the last move and are closed.
+//
+//With an archive open every finished game is appended to it with its moves and how it ended. The writes are buffered
+//and pushed out whenever the server goes a poll without anything to do, and when it's freed.
+
+#define SERVER_DEFAULT_PORT "27015"
+#define SERVER_DEFAULT_SPECTATOR_PORT "27016"
+#define SERVER_MAX_SPECTATOR_LAG (16*BROADCAST_BUFFER_SIZE)
+#define SERVER_MAX_EVENTS 1024
+
+#define SERVER_NO_GAME -1
+
+typedef struct ServerConnection{
+    NetSocket socket;          //NET_INVALID_SOCKET for a free slot
+    int32_t game;              //SERVER_NO_GAME while waiting for an opponent, next free slot while unused
+    unsigned char side;
+    unsigned char events;      //NET_EVENT_ flags currently registered with the reactor
+    unsigned char spectator;
+    int32_t nextSpectator;     //Neighbours in the watched game's spectator list, -1 at the ends
+    int32_t previousSpectator;
+    BroadcastReader reader;    //Spectator's place in the game's stream, detached for players
+    RingBuffer in;             //Received bytes, complete frames are taken off as the opponent has room for them
+    RingBuffer out;            //Frames waiting for the socket to take them, sent ahead of the stream for spectators
+} ServerConnection;
+
+typedef struct ServerGame{
+    int32_t connections[2];    //Indexed by CHESS_SIDE, connections[0] is the next free slot while unused
+    uint32_t messages;         //Messages relayed between the players
+    Position position;         //After every move relayed so far
+    int32_t firstSpectator;    //-1 when nobody watches
+    int32_t spectators;
+    BroadcastStream stream;    //Open only while someone watches
+    unsigned char* moves;      //Encoded moves played so far while archiving, kept for the slot's next game
+    uint32_t moveCount;        //GAME_ARCHIVE_MAX_MOVES + 1 once the game can't be archived
+    uint32_t moveCapacity;
+    unsigned char result;      //GAME_RESULT and GAME_END_REASON once a player resigns, agrees a draw or breaks the rules
+    unsigned char reason;
+} ServerGame;
+
+typedef struct ServerStats{
+    uint64_t accepted;
+    uint64_t rejected;         //Closed straight away because every slot was taken
+    uint64_t gamesStarted;
+    uint64_t gamesFinished;
+    uint64_t bytesRelayed;
+    uint64_t messagesRelayed;
+    uint64_t malformed;        //Connections dropped for breaking the protocol
+    uint64_t illegalMoves;     //Games ended for a move out of turn or against the rules
+    uint64_t spectatorsAttached;
+    uint64_t spectatorsDropped; //Fell too far behind their game
+    uint64_t broadcastBytes;   //Written to game streams, once however many watch
+    uint64_t spectatorBytes;   //Sent to spectators from the streams
+    uint64_t gamesArchived;
+    uint64_t archiveErrors;    //Finished games that couldn't be archived
+    uint64_t reads;
+    uint64_t writes;
+} ServerStats;
+
+typedef struct GameServer{
+
+    NetSocket listener;
+    NetSocket spectatorListener; //NET_INVALID_SOCKET when spectators aren't allowed
+    NetReactor reactor;
+    BroadcastPool broadcastPool;
+    GameArchiveWriter archive; //archive.data is NULL while not archiving
+
+    int maxGames;
+    int maxSpectators;
+    int maxConnections;        //Two per game plus the one waiting for an opponent plus the spectators
+    ServerConnection* connections;
+    ServerGame* games;
+    int freeConnection;
+    int freeSpectator;
+    int freeGame;
+    int waiting;               //Connection waiting for an opponent or -1
+    int activeGames;
+    Position startPosition;    //Copied into every new game
+
+    volatile int running;
+    ServerStats stats;
+
+} GameServer;
+
+//Listens on port for players and on spectatorPort for spectators, and allocates the tables for maxGames games
+//and maxSpectators spectators. With maxSpectators 0 there's no spectator port. Returns 1 on success, 0 otherwise.
+//Net_Init, Attacks_Init and Zobrist_Init have to have been called.
+int Server_Init(GameServer* server, const char* port, const char* spectatorPort, int maxGames, int maxSpectators);
+//Appends every game finished from now on to the archive at path, creating it if needed. Returns 1 on success, 0 otherwise.
+int Server_OpenArchive(GameServer* server, const char* path);
+//Closes every connection and the archive and frees the tables
+void Server_Free(GameServer* server);
+
+//Handles whatever is ready within timeoutMs (-1 waits for ever). Returns the events handled or -1 on a reactor error.
+int Server_Poll(GameServer* server, int timeoutMs);
+//Polls until running is cleared, which another thread or a signal handler can do
+void Server_Run(GameServer* server);
+
+#endif
\ No newline at end of file
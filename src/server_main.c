@@ -0,0 +1,81 @@
+//Headless multi game server.
+//
+//  chess_server [port] [maxGames] [spectatorPort] [maxSpectators] [archive]
+//
+//Port defaults to 27015, maxGames to 10000, spectatorPort to 27016 and maxSpectators to 10000. Players connect with
+//"5. Join Server" from the menu and spectators with "6. Watch Game". With an archive path every finished game is
+//appended to that archive.
+//Ctrl+C stops it and prints what it served.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#include "server.h"
+#include "attacks.h"
+#include "zobrist.h"
+
+#define SERVER_DEFAULT_MAX_GAMES 10000
+#define SERVER_DEFAULT_MAX_SPECTATORS 10000
+
+GameServer server;
+
+void StopServer(int signal){
+    (void)signal;
+    server.running = 0;
+}
+
+int main(int argc, char** argv){
+
+    const char* port = argc >= 2 ? argv[1] : SERVER_DEFAULT_PORT;
+    int maxGames = argc >= 3 ? atoi(argv[2]) : SERVER_DEFAULT_MAX_GAMES;
+    const char* spectatorPort = argc >= 4 ? argv[3] : SERVER_DEFAULT_SPECTATOR_PORT;
+    int maxSpectators = argc >= 5 ? atoi(argv[4]) : SERVER_DEFAULT_MAX_SPECTATORS;
+    const char* archivePath = argc >= 6 ? argv[5] : NULL;
+    if(maxGames < 1 || maxSpectators < 0){
+        printf("Usage: %s [port] [maxGames] [spectatorPort] [maxSpectators] [archive]\n", argv[0]);
+        return 1;
+    }
+
+    Attacks_Init();
+    Zobrist_Init();
+    if(!Net_Init()){
+        printf("Could not initialize networking\n");
+        return 1;
+    }
+    if(!Server_Init(&server, port, spectatorPort, maxGames, maxSpectators)){
+        printf("Could not listen on ports %s and %s for %d games\n", port, spectatorPort, maxGames);
+        Net_Cleanup();
+        return 1;
+    }
+    if(archivePath != NULL && !Server_OpenArchive(&server, archivePath)){
+        printf("Could not open the game archive %s\n", archivePath);
+        Server_Free(&server);
+        Net_Cleanup();
+        return 1;
+    }
+
+    signal(SIGINT, StopServer);
+    printf("Listening on PORT: %s for up to %d games, spectators on PORT: %s\n", port, maxGames, spectatorPort);
+    Server_Run(&server);
+
+    printf("\nAccepted:       %llu\n", (unsigned long long)server.stats.accepted);
+    printf("Rejected:       %llu\n", (unsigned long long)server.stats.rejected);
+    printf("Games started:  %llu\n", (unsigned long long)server.stats.gamesStarted);
+    printf("Games finished: %llu\n", (unsigned long long)server.stats.gamesFinished);
+    printf("Bytes relayed:  %llu\n", (unsigned long long)server.stats.bytesRelayed);
+    printf("Illegal moves:  %llu\n", (unsigned long long)server.stats.illegalMoves);
+    printf("Spectators:     %llu, %llu dropped for falling behind\n", (unsigned long long)server.stats.spectatorsAttached,
+        (unsigned long long)server.stats.spectatorsDropped);
+    printf("Broadcast bytes encoded: %llu, sent to spectators: %llu\n", (unsigned long long)server.stats.broadcastBytes,
+        (unsigned long long)server.stats.spectatorBytes);
+    if(archivePath != NULL){
+        printf("Games archived: %llu (%llu in %s), %llu could not be\n", (unsigned long long)server.stats.gamesArchived,
+            (unsigned long long)server.archive.count, archivePath, (unsigned long long)server.stats.archiveErrors);
+    }
+
+    Server_Free(&server);
+    Net_Cleanup();
+    return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "thread_pool.h"
+#include "platform.h"
+
+#include <stddef.h>
+
+//One block of tasks per thread, padded to a cache line so claiming tasks doesn't bounce other threads' counters
+typedef struct TaskBlock{
+    volatile int32_t next;
+    int32_t end;
+    char padding[56];
+} TaskBlock;
+
+typedef struct ThreadPoolRun{
+    TaskBlock blocks[THREAD_POOL_MAX_THREADS];
+    int threadCount;
+    ThreadPoolTask task;
+    void* context;
+} ThreadPoolRun;
+
+typedef struct ThreadPoolWorker{
+    ThreadPoolRun* run;
+    int threadIndex;
+} ThreadPoolWorker;
+
+static void WorkerMain(void* argument){
+
+    ThreadPoolWorker* worker = (ThreadPoolWorker*)argument;
+    ThreadPoolRun* run = worker->run;
+
+    //Own block first, then the others in order. Owner and thieves claim tasks the same way, one atomic add,
+    //so a block can be shared by any number of threads without locks.
+    for(int i = 0; i < run->threadCount; i++){
+        TaskBlock* block = &run->blocks[(worker->threadIndex + i) % run->threadCount];
+        while(block->next < block->end){
+            int32_t taskIndex = Platform_AtomicFetchAdd(&block->next, 1);
+            if(taskIndex >= block->end) break;
+            run->task(run->context, taskIndex, worker->threadIndex);
+        }
+    }
+
+}
+
+void ThreadPool_Run(int threadCount, int taskCount, ThreadPoolTask task, void* context){
+
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+
+    ThreadPoolRun run;
+    ThreadPoolWorker workers[THREAD_POOL_MAX_THREADS];
+    PlatformThread* threads[THREAD_POOL_MAX_THREADS];
+
+    run.threadCount = threadCount;
+    run.task = task;
+    run.context = context;
+    for(int i = 0; i < threadCount; i++){
+        run.blocks[i].next = (int32_t)((long long)taskCount * i / threadCount);
+        run.blocks[i].end = (int32_t)((long long)taskCount * (i+1) / threadCount);
+    }
+
+    for(int i = 1; i < threadCount; i++){
+        workers[i].run = &run;
+        workers[i].threadIndex = i;
+        threads[i] = Platform_CreateThread(WorkerMain, &workers[i]);
+    }
+
+    workers[0].run = &run;
+    workers[0].threadIndex = 0;
+    WorkerMain(&workers[0]);
+
+    //Threads that failed to start just leave their block to be stolen
+    for(int i = 1; i < threadCount; i++){
+        if(threads[i] != NULL) Platform_JoinThread(threads[i]);
+    }
+
+}
\ No newline at end of file
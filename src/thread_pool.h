@@ -0,0 +1,13 @@
+#ifndef H_THREAD_POOL
+#define H_THREAD_POOL
+
+#define THREAD_POOL_MAX_THREADS 256
+
+typedef void (*ThreadPoolTask)(void* context, int taskIndex, int threadIndex);
+
+//Runs task(context, i, thread) for every i in [0, taskCount) on threadCount threads and returns when all are done.
+//Each thread starts on its own contiguous block of tasks and steals from the other blocks once its own runs dry,
+//so uneven task sizes still keep every core busy. The calling thread works as thread 0.
+void ThreadPool_Run(int threadCount, int taskCount, ThreadPoolTask task, void* context);
+
+#endif
\ No newline at end of file
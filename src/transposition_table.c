@@ -0,0 +1,129 @@
+#include "transposition_table.h"
+#include "platform.h"
+
+#include <string.h>
+
+#define DATA_MOVE(data) ((Move)((data) & 0xFFFF))
+#define DATA_SCORE(data) ((int)(int16_t)(((data) >> 16) & 0xFFFF))
+#define DATA_DEPTH(data) ((int)(((data) >> 32) & 0xFF))
+#define DATA_BOUND(data) ((int)(((data) >> 40) & 0x3))
+#define DATA_GENERATION(data) ((unsigned char)(((data) >> 48) & 0xFF))
+
+static uint64_t PackData(Move move, int score, int depth, int bound, unsigned char generation){
+
+    if(depth < 0) depth = 0;
+    if(depth > 255) depth = 255;
+
+    return (uint64_t)move
+         | ((uint64_t)(uint16_t)(int16_t)score << 16)
+         | ((uint64_t)depth << 32)
+         | ((uint64_t)bound << 40)
+         | ((uint64_t)generation << 48);
+
+}
+
+int TranspositionTable_Init(TranspositionTable* table, size_t megabytes){
+
+    size_t bytes = megabytes * 1024 * 1024;
+    uint64_t bucketCount = 1;
+    while(bucketCount * 2 * sizeof(TTBucket) <= bytes){
+        bucketCount *= 2;
+    }
+
+    table->buckets = (TTBucket*)Platform_AlignedAlloc(bucketCount * sizeof(TTBucket), 64);
+    if(table->buckets == NULL){
+        table->bucketMask = 0;
+        return 0;
+    }
+    table->bucketMask = bucketCount - 1;
+    table->generation = 0;
+    TranspositionTable_Clear(table);
+    return 1;
+
+}
+
+void TranspositionTable_Free(TranspositionTable* table){
+
+    Platform_AlignedFree(table->buckets);
+    table->buckets = NULL;
+    table->bucketMask = 0;
+
+}
+
+void TranspositionTable_Clear(TranspositionTable* table){
+    memset(table->buckets, 0, (table->bucketMask + 1) * sizeof(TTBucket));
+}
+
+void TranspositionTable_NewSearch(TranspositionTable* table){
+    table->generation++;
+}
+
+int TranspositionTable_Probe(const TranspositionTable* table, uint64_t key, TTData* data){
+
+    TTBucket* bucket = TranspositionTable_Bucket(table, key);
+    for(int i = 0; i < TT_BUCKET_ENTRIES; i++){
+        uint64_t entryData = bucket->entries[i].data;
+        uint64_t entryKey = bucket->entries[i].keyXorData ^ entryData;
+        if(entryKey == key && entryData != 0){
+            data->move = DATA_MOVE(entryData);
+            data->score = DATA_SCORE(entryData);
+            data->depth = DATA_DEPTH(entryData);
+            data->bound = DATA_BOUND(entryData);
+            return 1;
+        }
+    }
+    return 0;
+
+}
+
+void TranspositionTable_Store(TranspositionTable* table, uint64_t key, Move move, int score, int depth, int bound){
+
+    TTBucket* bucket = TranspositionTable_Bucket(table, key);
+
+    //Same position first, otherwise the entry least worth keeping: old generations go before shallow depths
+    TTEntry* replace = &bucket->entries[0];
+    int replaceWorth = 1 << 30;
+    for(int i = 0; i < TT_BUCKET_ENTRIES; i++){
+
+        TTEntry* entry = &bucket->entries[i];
+        uint64_t entryData = entry->data;
+
+        if((entry->keyXorData ^ entryData) == key){
+            //Don't let a shallower non exact result wipe out a deeper one from this search
+            if(bound != TT_BOUND_EXACT && depth + 2 < DATA_DEPTH(entryData) && DATA_GENERATION(entryData) == table->generation){
+                return;
+            }
+            //Keep the old best move if this search didn't find one
+            if(move == MOVE_NONE) move = DATA_MOVE(entryData);
+            replace = entry;
+            break;
+        }
+
+        int age = (unsigned char)(table->generation - DATA_GENERATION(entryData));
+        int worth = (entryData == 0) ? -(1 << 30) : DATA_DEPTH(entryData) - 8*age;
+        if(worth < replaceWorth){
+            replaceWorth = worth;
+            replace = entry;
+        }
+
+    }
+
+    uint64_t data = PackData(move, score, depth, bound, table->generation);
+    replace->data = data;
+    replace->keyXorData = key ^ data;
+
+}
+
+int TranspositionTable_Hashfull(const TranspositionTable* table){
+
+    int used = 0;
+    uint64_t samples = table->bucketMask + 1 < 250 ? table->bucketMask + 1 : 250;
+    for(uint64_t i = 0; i < samples; i++){
+        for(int j = 0; j < TT_BUCKET_ENTRIES; j++){
+            uint64_t entryData = table->buckets[i].entries[j].data;
+            if(entryData != 0 && DATA_GENERATION(entryData) == table->generation) used++;
+        }
+    }
+    return (int)(used * 1000 / (samples * TT_BUCKET_ENTRIES));
+
+}
\ No newline at end of file
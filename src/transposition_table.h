@@ -0,0 +1,75 @@
+#ifndef H_TRANSPOSITION_TABLE
+#define H_TRANSPOSITION_TABLE
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "move.h"
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+#define TT_BOUND_NONE 0
+#define TT_BOUND_UPPER 1 //Search failed low, score is at most this
+#define TT_BOUND_LOWER 2 //Search failed high, score is at least this
+#define TT_BOUND_EXACT 3
+
+#define TT_BUCKET_ENTRIES 4
+
+//16 byte entry. data packs the move, score, depth, bound and generation. keyXorData is the position key
+//xored with data, so an entry torn by two threads writing at once fails the key check on probe and is
+//treated as a miss. That lets any number of search threads share the table without locks.
+typedef struct TTEntry{
+    volatile uint64_t keyXorData;
+    volatile uint64_t data;
+} TTEntry;
+
+//Four entries, one cache line
+typedef struct TTBucket{
+    TTEntry entries[TT_BUCKET_ENTRIES];
+} TTBucket;
+
+typedef struct TranspositionTable{
+    TTBucket* buckets;
+    uint64_t bucketMask; //Bucket count is a power of two
+    unsigned char generation;
+} TranspositionTable;
+
+//Unpacked contents of a hit
+typedef struct TTData{
+    Move move;
+    int score;
+    int depth;
+    int bound;
+} TTData;
+
+//Allocates the largest power of two number of buckets that fits in megabytes. Returns 1 on success, 0 if out of memory.
+int TranspositionTable_Init(TranspositionTable* table, size_t megabytes);
+void TranspositionTable_Free(TranspositionTable* table);
+void TranspositionTable_Clear(TranspositionTable* table);
+
+//Call once per search so entries from older searches are the first to be replaced
+void TranspositionTable_NewSearch(TranspositionTable* table);
+
+//Returns 1 and fills data if the key is in the table
+int TranspositionTable_Probe(const TranspositionTable* table, uint64_t key, TTData* data);
+void TranspositionTable_Store(TranspositionTable* table, uint64_t key, Move move, int score, int depth, int bound);
+
+//Permille of sampled entries written during the current search
+int TranspositionTable_Hashfull(const TranspositionTable* table);
+
+static inline TTBucket* TranspositionTable_Bucket(const TranspositionTable* table, uint64_t key){
+    return &table->buckets[key & table->bucketMask];
+}
+
+//Start loading the bucket for key into cache, call as soon as the key of a child position is known
+static inline void TranspositionTable_Prefetch(const TranspositionTable* table, uint64_t key){
+#if defined(_MSC_VER)
+    _mm_prefetch((const char*)TranspositionTable_Bucket(table, key), _MM_HINT_T0);
+#else
+    __builtin_prefetch(TranspositionTable_Bucket(table, key));
+#endif
+}
+
+#endif
\ No newline at end of file
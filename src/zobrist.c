@@ -0,0 +1,72 @@
+#include "zobrist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+uint64_t zobristPieces[2][KING+1][64];
+uint64_t zobristBlackToMove;
+uint64_t zobristCastling[16];
+uint64_t zobristEnPassantFile[8];
+
+//splitmix64
+static uint64_t NextKey(uint64_t* seed){
+    uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void Zobrist_Init(){
+
+    uint64_t seed = 0x5EED0F0C4E55ULL;
+
+    for(int side = 0; side < 2; side++){
+        for(int i = 0; i < 64; i++){
+            zobristPieces[side][NONE][i] = 0;
+        }
+        for(int type = PAWN; type <= KING; type++){
+            for(int i = 0; i < 64; i++){
+                zobristPieces[side][type][i] = NextKey(&seed);
+            }
+        }
+    }
+
+    zobristBlackToMove = NextKey(&seed);
+
+    //Each right gets a key, a combination of rights is the xor of its rights' keys
+    uint64_t rightKeys[4];
+    for(int i = 0; i < 4; i++){
+        rightKeys[i] = NextKey(&seed);
+    }
+    for(int rights = 0; rights < 16; rights++){
+        zobristCastling[rights] = 0;
+        for(int i = 0; i < 4; i++){
+            if(rights & (1 << i)) zobristCastling[rights] ^= rightKeys[i];
+        }
+    }
+
+    for(int i = 0; i < 8; i++){
+        zobristEnPassantFile[i] = NextKey(&seed);
+    }
+
+}
+
+uint64_t Zobrist_ComputeBoardState(const BoardState* boardState){
+
+    uint64_t hash = 0;
+    for(int i = 0; i < 64; i++){
+        hash ^= zobristPieces[boardState->board[i].side][boardState->board[i].type][i];
+    }
+    return hash;
+
+}
+
+void Zobrist_DebugCheck(uint64_t incremental, uint64_t recomputed, const char* file, int line){
+
+    if(incremental != recomputed){
+        printf("Zobrist hash mismatch at %s:%d, incremental %016llx recomputed %016llx\n", file, line,
+            (unsigned long long)incremental, (unsigned long long)recomputed);
+        abort();
+    }
+
+}
\ No newline at end of file
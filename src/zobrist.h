@@ -0,0 +1,32 @@
+#ifndef H_ZOBRIST
+#define H_ZOBRIST
+
+#include <stdint.h>
+
+#include "chess.h"
+
+//Random keys xored together into a 64 bit position hash. The hash is kept up to date piece by piece
+//as positions change instead of being recomputed. Build with CHESS_DEBUG_HASH to have every update
+//checked against a full recompute.
+
+extern uint64_t zobristPieces[2][KING+1][64]; //zobristPieces[side][NONE] is all zero so empty squares add nothing
+extern uint64_t zobristBlackToMove;
+extern uint64_t zobristCastling[16];
+extern uint64_t zobristEnPassantFile[8];
+
+//Must be called once before any hashing. The keys come from a fixed seed so hashes are stable across runs and builds.
+void Zobrist_Init();
+
+//Hash of the pieces on a BoardState, the part of the key it has the information for
+uint64_t Zobrist_ComputeBoardState(const BoardState* boardState);
+
+//Prints both hashes and aborts when they differ
+void Zobrist_DebugCheck(uint64_t incremental, uint64_t recomputed, const char* file, int line);
+
+#if defined(CHESS_DEBUG_HASH)
+#define ZOBRIST_DEBUG_CHECK(incremental, recomputed) Zobrist_DebugCheck((incremental), (recomputed), __FILE__, __LINE__)
+#else
+#define ZOBRIST_DEBUG_CHECK(incremental, recomputed)
+#endif
+
+#endif
\ No newline at end of file